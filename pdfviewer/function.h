@@ -105,8 +105,8 @@ inline int image2pdf(std::string imageFile, std::string pdfFile) {
     return FormatConverter::image2pdf(imageFile, pdfFile);
 }
 
-inline int images2pdf(QStringList& images, std::string pdfFile) {
-    return FormatConverter::images2pdf(images, pdfFile);
+inline int images2pdf(QStringList& images, std::string pdfFile, bool removeImages = true) {
+    return FormatConverter::images2pdf(images, pdfFile, removeImages);
 }
 
 inline int images2pdf(std::string imagesDir, std::string pdfFile, int num) {
@@ -142,12 +142,8 @@ inline int addWatermark_multiline(string in, string out, QString mark_txt,
                                                       fontSize, color, angle, opacity);
 }
 
-inline void getSVGDimensions(const char* filename, int& width, int& height) {
-    WatermarkProcessor::getSVGDimensions(filename, width, height);
-}
-
 // 几何计算函数（映射到GeometryUtils命名空间）
-inline SIZE getTextWidth(QString text, QString fontName, int fontSize) {
+inline QSize getTextWidth(QString text, QString fontName, int fontSize) {
     return GeometryUtils::getTextWidth(text, fontName, fontSize);
 }
 
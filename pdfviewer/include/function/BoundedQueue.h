@@ -0,0 +1,103 @@
+/**
+ * @file BoundedQueue.h
+ * @brief 有界阻塞队列
+ *
+ * 连接流水线相邻阶段：队列满时生产方阻塞（反压），队列空时消费方阻塞。
+ * 关闭后生产方的push立即失败，消费方取完剩余元素后pop返回false。
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma once
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QQueue>
+#include <QWaitCondition>
+
+/**
+ * @class BoundedQueue
+ * @brief 线程安全的有界阻塞队列
+ * @tparam T 元素类型
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    /**
+     * @brief 构造函数
+     * @param capacity 队列容量，至少为1
+     */
+    explicit BoundedQueue(int capacity) : m_capacity(qMax(1, capacity)) {}
+
+    /**
+     * @brief 放入元素，队列满时阻塞
+     * @param item 元素
+     * @param waitNs 累加阻塞等待的时间（纳秒），可为nullptr
+     * @return 队列已关闭时返回false，元素未放入
+     */
+    bool push(const T& item, qint64* waitNs = nullptr) {
+        QElapsedTimer timer;
+        timer.start();
+        QMutexLocker locker(&m_mutex);
+        while (!m_closed && m_items.size() >= m_capacity) {
+            m_notFull.wait(&m_mutex);
+        }
+        if (waitNs) {
+            *waitNs += timer.nsecsElapsed();
+        }
+        if (m_closed) {
+            return false;
+        }
+        m_items.enqueue(item);
+        m_notEmpty.wakeOne();
+        return true;
+    }
+
+    /**
+     * @brief 取出元素，队列空时阻塞
+     * @param item 取出的元素
+     * @param waitNs 累加阻塞等待的时间（纳秒），可为nullptr
+     * @return 队列已关闭且为空时返回false
+     */
+    bool pop(T* item, qint64* waitNs = nullptr) {
+        QElapsedTimer timer;
+        timer.start();
+        QMutexLocker locker(&m_mutex);
+        while (!m_closed && m_items.isEmpty()) {
+            m_notEmpty.wait(&m_mutex);
+        }
+        if (waitNs) {
+            *waitNs += timer.nsecsElapsed();
+        }
+        if (m_items.isEmpty()) {
+            return false;
+        }
+        *item = m_items.dequeue();
+        m_notFull.wakeOne();
+        return true;
+    }
+
+    /**
+     * @brief 关闭队列并唤醒所有等待方
+     */
+    void close() {
+        QMutexLocker locker(&m_mutex);
+        m_closed = true;
+        m_notFull.wakeAll();
+        m_notEmpty.wakeAll();
+    }
+
+private:
+    QMutex m_mutex;
+    QWaitCondition m_notFull;
+    QWaitCondition m_notEmpty;
+    QQueue<T> m_items;
+    int m_capacity;
+    bool m_closed = false;
+};
+
+#endif  // BOUNDED_QUEUE_H
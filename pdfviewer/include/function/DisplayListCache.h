@@ -0,0 +1,109 @@
+/**
+ * @file DisplayListCache.h
+ * @brief 页面显示列表缓存头文件
+ *
+ * 导出、PDF转图片、页数统计等功能各自用独立的MuPDF上下文解析同一文档，
+ * 同一页面会被反复解释。本缓存：
+ * - 每个页面只解析一次，生成的fz_display_list可在任意分辨率、任意条带上重放
+ * - 以"文件路径 + 修改时间 + 页码"为键，文件被改写后自动失效
+ * - 文档从内存打开，不占用文件句柄，不妨碍其他功能改写同一文件
+ * - 按字节预算做LRU淘汰，预算包括文档数据和显示列表
+ * - 所有使用方的上下文都克隆自同一个带锁的基础上下文，可在线程池中共享
+ *
+ * Qt的QPdfView使用自己的渲染引擎，不经过本缓存。
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma once
+#ifndef DISPLAY_LIST_CACHE_H
+#define DISPLAY_LIST_CACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include "mupdf/fitz.h"
+
+/**
+ * @class DisplayListCache
+ * @brief 进程共享的页面显示列表缓存
+ */
+class DisplayListCache {
+public:
+    /**
+     * @brief 默认缓存预算：256 MB
+     */
+    static const qint64 kDefaultBudget = 256LL * 1024 * 1024;
+
+    /**
+     * @brief 获取进程共享的缓存实例
+     */
+    static DisplayListCache* instance();
+
+    /**
+     * @brief 为调用线程创建上下文
+     * @return 克隆自基础上下文的新上下文，调用方用fz_drop_context释放，失败返回nullptr
+     * @note 每个线程使用自己的上下文；从缓存取得的显示列表只能用这类上下文渲染
+     */
+    fz_context* newContext();
+
+    /**
+     * @brief 获取PDF文件页数
+     * @param ctx 调用线程的上下文（来自newContext）
+     * @param pdfFile PDF文件路径
+     * @return 页数，文件无法打开时返回-1
+     */
+    int pageCount(fz_context* ctx, const QString& pdfFile);
+
+    /**
+     * @brief 获取页面的显示列表
+     * @param ctx 调用线程的上下文（来自newContext）
+     * @param pdfFile PDF文件路径
+     * @param page 页码（从0开始）
+     * @param bounds 输出页面显示区域（点，已考虑/Rotate）
+     * @return 显示列表，已增加引用，调用方用fz_drop_display_list释放；
+     *         文件无法打开或页面解析失败时返回nullptr
+     * @note 不抛出MuPDF异常，可在fz_try之外调用
+     */
+    fz_display_list* displayList(fz_context* ctx, const QString& pdfFile, int page,
+                                 fz_rect* bounds);
+
+    /**
+     * @brief 设置缓存预算
+     * @param bytes 预算（字节），超出时立即淘汰最久未使用的条目
+     */
+    void setBudget(qint64 bytes);
+
+    /**
+     * @brief 当前缓存占用（字节，估算值）
+     */
+    qint64 used() const;
+
+    /**
+     * @brief 清空缓存
+     */
+    void clear();
+
+private:
+    struct Document;
+    struct Entry;
+
+    DisplayListCache();
+    ~DisplayListCache();
+
+    Document* acquireDocument(fz_context* ctx, const QString& pdfFile);
+    void releaseDocument(fz_context* ctx, Document* doc);
+    void dropDocument(fz_context* ctx, Document* doc);
+    void evict(fz_context* ctx);
+
+    mutable QMutex m_mutex;
+    fz_context* m_base = nullptr;
+    qint64 m_budget = kDefaultBudget;
+    qint64 m_used = 0;
+    quint64 m_clock = 0;
+    QHash<QString, Document*> m_documents;  ///< 键为文件绝对路径
+    QHash<QString, Entry*> m_entries;       ///< 键为"文档键|页码"
+};
+
+#endif // DISPLAY_LIST_CACHE_H
@@ -6,6 +6,7 @@
  * - 目录递归遍历和文件收集
  * - 路径字符串处理和变换
  * - 目录创建和文件名提取
+ * - 整个文件的读写（配合内存缓冲区版本的PDF处理函数）
  * 
  * @author Qt PDF工具集项目组
  * @date 2023
@@ -15,6 +16,7 @@
 #ifndef FILE_SYSTEM_UTILS_H
 #define FILE_SYSTEM_UTILS_H
 
+#include <QByteArray>
 #include <QDir>
 #include <QStringList>
 #include <QFileInfo>
@@ -98,6 +100,26 @@ string extractDirectory(const std::string& fullPath);
  */
 bool createDirectory(const QString& path);
 
+// ================================
+// 文件读写函数组
+// ================================
+
+/**
+ * @brief 读取整个文件到内存
+ * @param path 文件路径
+ * @return 文件内容，读取失败返回空数组
+ */
+QByteArray readFileBytes(const QString& path);
+
+/**
+ * @brief 把内存数据写入文件（覆盖）
+ * @param path 文件路径
+ * @param data 文件内容
+ * @return true: 写入成功, false: 写入失败
+ * @note 先写入同目录下的临时文件再替换，失败时不会留下不完整的目标文件
+ */
+bool writeFileBytes(const QString& path, const QByteArray& data);
+
 } // namespace FileSystemUtils
 
 #endif // FILE_SYSTEM_UTILS_H
\ No newline at end of file
@@ -0,0 +1,145 @@
+/**
+ * @file FlattenPipeline.h
+ * @brief 扁平化（PDF栅格化为图片PDF）流水线模块头文件
+ *
+ * 把扁平化拆成三个阶段，相邻阶段之间用有界队列连接：
+ * - 渲染：PageRasterizer在多个线程上渲染页面，按页码顺序输出像素数据
+ * - 压缩：多个线程并行编码像素数据（黑白CCITT G4、灰度Flate、彩色JPEG或无损Flate）
+ * - 写入：调用线程按页码顺序把压缩后的图片写入MuPDF生成的PDF
+ *
+ * 高分辨率下页面按水平条带渲染和编码，每个条带是一个独立的图片对象，
+ * 单个工作线程的内存与条带大小成正比。
+ *
+ * 下游处理不过来时上游在队列上阻塞（反压）；像素数据从渲染前到
+ * 压缩完成都计入MemoryBudget，内存上限由字节预算而不是线程数决定。
+ * 每个阶段统计忙碌与等待时间，便于判断瓶颈所在。
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma once
+#ifndef FLATTEN_PIPELINE_H
+#define FLATTEN_PIPELINE_H
+
+#include <QByteArray>
+#include <QString>
+#include "include/function/MemoryBudget.h"
+
+/**
+ * @namespace FlattenPipeline
+ * @brief 扁平化流水线功能命名空间
+ */
+namespace FlattenPipeline {
+
+// ================================
+// 编码选项
+// ================================
+
+/**
+ * @brief 页面图片编码方式
+ */
+enum class Codec {
+    Auto,     ///< 按页检测：黑白用CCITT G4，灰度用8位Flate，彩色用JPEG
+    Bitonal,  ///< 全部转为1位黑白，CCITT G4编码
+    Gray,     ///< 全部转为8位灰度，Flate编码
+    Jpeg,     ///< 全部按RGB做JPEG编码
+    Lossless  ///< 全部按RGB做Flate编码（原有行为）
+};
+
+/**
+ * @brief 编码选项，一批文件共用一个
+ */
+struct Encoding {
+    Codec codec = Codec::Auto;  ///< 编码方式
+    int jpegQuality = 75;       ///< JPEG质量（1~100）
+    int maxDpi = 0;             ///< 灰度和彩色页面图片的分辨率上限，0表示与渲染分辨率相同；
+                                ///< 渲染分辨率更高时按面积平均缩小后再编码，黑白页面不缩小
+};
+
+/**
+ * @brief 从界面选项文本解析编码选项
+ * @param text 选项文本："自动"、"黑白"、"灰度"、"无损"或"JPEG 90"这类带质量的文本
+ * @return 编码选项，无法识别时返回默认的自动模式
+ */
+Encoding parseEncoding(const QString& text);
+
+// ================================
+// 统计信息
+// ================================
+
+/**
+ * @brief 单个阶段的统计
+ */
+struct StageStats {
+    int workers = 1;     ///< 该阶段的线程数
+    int items = 0;       ///< 处理的页数
+    qint64 busyNs = 0;   ///< 各线程忙碌时间之和（纳秒）
+    qint64 waitNs = 0;   ///< 各线程在队列上等待的时间之和（纳秒）
+
+    /**
+     * @brief 阶段利用率
+     * @param wallNs 流水线总耗时（纳秒）
+     * @return 忙碌时间占该阶段全部线程时间的比例（0~1）
+     */
+    double utilization(qint64 wallNs) const;
+};
+
+/**
+ * @brief 整条流水线的统计
+ */
+struct Stats {
+    StageStats render;    ///< 渲染阶段（busy为渲染输出未被下游阻塞的时间）
+    StageStats compress;  ///< 压缩阶段
+    StageStats write;     ///< 写入阶段
+    qint64 wallNs = 0;    ///< 总耗时（纳秒）
+    qint64 peakBytes = 0; ///< 运行结束时预算的占用峰值（字节）
+    int bitonalPages = 0; ///< 按黑白编码的页数
+    int grayPages = 0;    ///< 按灰度编码的页数
+    int colorPages = 0;   ///< 按彩色（JPEG或无损）编码的页数
+
+    /**
+     * @brief 生成一行便于记录日志的摘要
+     * @return 如"页数 120 耗时 8.2s 渲染 97% 压缩 41% 写入 6% 峰值 612MB 黑白/灰度/彩色 110/6/4"
+     */
+    QString summary() const;
+};
+
+// ================================
+// 流水线函数
+// ================================
+
+/**
+ * @brief 将内存中的PDF栅格化为纯图片PDF
+ * @param pdfData PDF文件内容
+ * @param resolution 栅格化分辨率（DPI）
+ * @param encoding 页面图片编码选项
+ * @param workers 渲染线程数，0表示使用CPU核心数；压缩线程数为其一半
+ * @param bandHeight 条带高度（像素），0表示整页，小于0表示自动
+ *                   （整页超过PageRasterizer::kAutoBandBytes时才分条带）；
+ *                   使用JPEG时建议取16的倍数
+ * @param budget 内存预算，nullptr表示不限制；多个文件同时处理时应共用同一预算
+ * @param stats 输出各阶段统计，可为nullptr
+ * @return 扁平化后的PDF文件内容，失败时返回空数组
+ * @note 输出页面保持原页面尺寸（点），与分辨率无关
+ */
+QByteArray run(const QByteArray& pdfData, int resolution,
+               const Encoding& encoding = Encoding(), int workers = 0,
+               int bandHeight = -1, MemoryBudget* budget = nullptr,
+               Stats* stats = nullptr);
+
+/**
+ * @brief 将PDF文件栅格化为纯图片PDF
+ * @param pdfFile PDF文件路径
+ * @return 扁平化后的PDF文件内容，失败时返回空数组
+ * @note 其余参数同run；页面显示列表取自DisplayListCache，
+ *       同一文件以不同分辨率或编码重复扁平化时不再解析页面
+ */
+QByteArray runFile(const QString& pdfFile, int resolution,
+                   const Encoding& encoding = Encoding(), int workers = 0,
+                   int bandHeight = -1, MemoryBudget* budget = nullptr,
+                   Stats* stats = nullptr);
+
+} // namespace FlattenPipeline
+
+#endif // FLATTEN_PIPELINE_H
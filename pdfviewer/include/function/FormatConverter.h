@@ -6,6 +6,7 @@
  * - PDF转图片（使用MuPDF库）
  * - 图片转PDF（单个或批量）
  * - 支持多种图片格式和自定义分辨率
+ * - 内存缓冲区版本，便于连续处理时在内存中传递数据而不经过临时文件
  * 
  * @author Qt PDF工具集项目组
  * @date 2023
@@ -16,6 +17,8 @@
 #define FORMAT_CONVERTER_H
 
 #include <string>
+#include <QByteArray>
+#include <QList>
 #include <QStringList>
 #include <QDebug>
 #include <iostream>
@@ -55,7 +58,7 @@ int pdf2image(string pdfFile, string imagePath, int resolution = 72);
  * @param imageFile 输入图片文件路径
  * @param pdfFile 输出PDF文件路径
  * @return 0: 成功, 2: 失败
- * @note 使用PDFlib库，创建包含一页图片的PDF文档，页面大小自适应图片尺寸
+ * @note 页面大小自适应图片尺寸；JPEG和可直通的PNG原样嵌入，其他格式快速Flate压缩
  */
 int image2pdf(std::string imageFile, std::string pdfFile);
 
@@ -63,10 +66,12 @@ int image2pdf(std::string imageFile, std::string pdfFile);
  * @brief 将图片列表合并到一个PDF文件
  * @param images 图片文件路径列表
  * @param pdfFile 输出PDF文件路径
+ * @param removeImages 成功后是否删除原图片文件
  * @return 0: 成功, 2: 失败
- * @note 每个图片占一页，页面大小自适应图片尺寸，处理后会删除原图片文件
+ * @note 每个图片占一页，页面大小自适应图片尺寸；
+ *       由ImageBatch::combine并行解码，按列表顺序写入
  */
-int images2pdf(QStringList& images, std::string pdfFile);
+int images2pdf(QStringList& images, std::string pdfFile, bool removeImages = true);
 
 /**
  * @brief 将指定目录中的图片文件合并为PDF
@@ -79,6 +84,46 @@ int images2pdf(QStringList& images, std::string pdfFile);
  */
 int images2pdf(std::string imagesDir, std::string pdfFile, int num);
 
+// ================================
+// 内存缓冲区版本
+// ================================
+
+/**
+ * @brief 将内存中的PDF转换为PNG图片数据
+ * @param pdfData PDF文件内容
+ * @param resolution 输出图片的分辨率（DPI），默认72
+ * @return 每页一个PNG数据，出错时返回空列表
+ */
+QList<QByteArray> pdf2imageBuffers(const QByteArray& pdfData, int resolution = 72);
+
+/**
+ * @brief 将内存中的单个图片转换为PDF
+ * @param imageData 图片文件内容（PNG、JPEG、BMP等）
+ * @return PDF文件内容，失败时返回空数组
+ */
+QByteArray image2pdfBuffer(const QByteArray& imageData);
+
+/**
+ * @brief 将内存中的图片列表合并为一个PDF
+ * @param images 图片文件内容列表，每个图片占一页
+ * @return PDF文件内容，失败时返回空数组
+ * @note 图片通过PVF虚拟文件交给PDFlib，不产生临时文件
+ */
+QByteArray images2pdfBuffer(const QList<QByteArray>& images);
+
+/**
+ * @brief 将内存中的PDF栅格化为纯图片PDF（扁平化）
+ * @param pdfData PDF文件内容
+ * @param resolution 栅格化分辨率（DPI），默认72
+ * @param workers 渲染线程数，0表示使用CPU核心数
+ * @return 扁平化后的PDF文件内容，失败时返回空数组
+ * @note 由FlattenPipeline并行渲染、压缩并写入，不经过PNG编解码；
+ *       输出页面保持原页面尺寸（点），与分辨率无关；需要限制内存或
+ *       查看各阶段统计时直接使用FlattenPipeline::run
+ */
+QByteArray flattenPdfBuffer(const QByteArray& pdfData, int resolution = 72,
+                            int workers = 0);
+
 } // namespace FormatConverter
 
 #endif // FORMAT_CONVERTER_H
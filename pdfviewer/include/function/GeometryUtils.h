@@ -3,7 +3,7 @@
  * @brief 几何计算工具模块头文件
  * 
  * 提供几何计算和文本处理的实用工具函数，包括：
- * - 文本宽度计算（使用Windows GDI）
+ * - 文本宽度计算（委托TextMetrics，跨平台）
  * - 几何图形的旋转变换计算
  * - SVG文件生成和处理
  * - 角度与弧度转换
@@ -29,7 +29,6 @@
 #include <cmath>
 #include <iostream>
 #include <vector>
-#include "windows.h"
 
 
 
@@ -58,14 +57,14 @@ struct Rectangle {
 // ================================
 
 /**
- * @brief 使用Windows GDI获取指定字体和大小的文本宽度
+ * @brief 获取指定字体和大小的文本尺寸
  * @param text 要测量的文本内容
  * @param fontName 字体名称
  * @param fontSize 字体大小
- * @return SIZE结构体，包含文本的宽度和高度信息
- * @note 用于水印文本的尺寸计算和布局，依赖Windows API
+ * @return 文本的宽度和高度（像素，向上取整）
+ * @note 由TextMetrics测量并缓存，线程安全，不依赖Windows API
  */
-SIZE getTextWidth(QString text, QString fontName, int fontSize);
+QSize getTextWidth(QString text, QString fontName, int fontSize);
 
 // ================================
 // 几何计算函数组
@@ -0,0 +1,56 @@
+/**
+ * @file GraftAnnotations.h
+ * @brief 嫁接页面的注释复制模块头文件
+ *
+ * pdf_graft_mapped_page只复制页面的内容和资源，不复制/Annots，
+ * 链接、表单域和批注会随之丢失。本模块为已嫁接的页面补复制注释：
+ * - 注释的/P和链接目标指向源文档的页面对象，直接嫁接会把页面连同
+ *   整棵页面树再复制一份，因此先断开这些引用
+ * - 嫁接后/P指向目标页面，链接目标指向目标文档中对应的页面，
+ *   指向未复制页面的链接保留注释、去掉目标
+ *
+ * 拆分、合并（GraftCopy）和分页并行水印的拼接（ParallelWatermark）共用。
+ * 所有函数只调用MuPDF的C接口，出错时抛出MuPDF异常，可以在fz_try中使用。
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma once
+#ifndef GRAFT_ANNOTATIONS_H
+#define GRAFT_ANNOTATIONS_H
+
+#include "mupdf/fitz.h"
+#include "mupdf/pdf.h"
+
+/**
+ * @namespace GraftAnnotations
+ * @brief 嫁接页面注释复制功能命名空间
+ */
+namespace GraftAnnotations {
+
+/**
+ * @brief 断开源文档注释对页面对象的引用
+ * @param src 源文档，打开后、复制任何注释之前调用一次
+ * @note 删除各注释的/P，链接目标中的页面对象改为源文档页序号；
+ *       只修改内存中的文档，可以重复调用
+ */
+void detach(fz_context* ctx, pdf_document* src);
+
+/**
+ * @brief 把源文档一页的注释复制到已嫁接的目标页面
+ * @param map 嫁接该页时使用的映射；为nullptr时注释单独深复制一份，
+ *        用于同一源页面在目标文档中出现多次的情况
+ * @param dst 目标文档
+ * @param src 源文档，需已经过detach()
+ * @param srcPage 源页序号（从0开始）
+ * @param dstPage 目标页序号（从0开始）
+ * @param dstPageOf 按源页序号给出目标页序号的数组，长度为源文档页数，
+ *        未复制的页为-1；链接按它改指向目标文档中的页面
+ */
+void copyPage(fz_context* ctx, pdf_graft_map* map, pdf_document* dst,
+              pdf_document* src, int srcPage, int dstPage, const int* dstPageOf);
+
+} // namespace GraftAnnotations
+
+#endif // GRAFT_ANNOTATIONS_H
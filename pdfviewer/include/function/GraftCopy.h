@@ -0,0 +1,87 @@
+/**
+ * @file GraftCopy.h
+ * @brief 基于MuPDF对象嫁接的页面复制模块头文件
+ *
+ * PDFlib的PDI把每一页导入为一个Form XObject模板再放置到新页面上，
+ * 每个输出文件都要重新序列化页面的整棵资源树。本模块使用MuPDF的
+ * pdf_graft_map直接复制页面对象：
+ * - 页面字典、内容流和资源按原样复制，不再包一层模板
+ * - 同一输入的页面共用一个嫁接映射，多页引用的字体、图片只复制一次
+ * - 合并时按内容摘要去掉不同输入之间重复的字体程序、图片和ICC配置文件
+ * - 输入在保存前关闭，输出可以覆盖某个输入
+ *
+ * 通过PdfOperations中各拆分、合并函数的CopyBackend参数选用。
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma once
+#ifndef GRAFT_COPY_H
+#define GRAFT_COPY_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include "include/function/PdfOperations.h"
+
+/**
+ * @namespace GraftCopy
+ * @brief 对象嫁接页面复制功能命名空间
+ */
+namespace GraftCopy {
+
+// ================================
+// 参数与类型
+// ================================
+
+/**
+ * @brief 从一个输入中提取页面写出的一个文件
+ */
+struct Extract {
+    QString file;                            ///< 输出PDF文件路径
+    QList<PdfOperations::PageRange> ranges;  ///< 按顺序写入的页面范围
+};
+
+// ================================
+// 页面复制函数
+// ================================
+
+/**
+ * @brief 从同一个输入提取多个输出文件
+ * @param pdfData 输入PDF的完整内容
+ * @param outputs 各输出文件及其页面范围
+ * @param workers 并发数，0表示使用CPU核心数
+ * @return 0: 全部成功, 2: 有文件失败
+ * @note 每个工作线程使用独立的MuPDF上下文，只解析一次输入
+ */
+int extract(const QByteArray& pdfData, const QList<Extract>& outputs, int workers = 1);
+
+/**
+ * @brief 按页面范围合并多个文件
+ * @param sources 输入列表，同一文件可以出现多次
+ * @param outFile 输出PDF文件路径，可以与某个输入相同
+ * @return 0: 成功, 2: 失败
+ * @note 输出在内存中组装，保存前关闭全部输入；不同输入中内容相同的
+ *       字体程序、图片和ICC配置文件按摘要去重，只写出一份
+ */
+int merge(const QList<PdfOperations::MergeSource>& sources, const QString& outFile);
+
+// ================================
+// 性能对比
+// ================================
+
+/**
+ * @brief 在相同输入上对比PDI与对象嫁接两种后端
+ * @param inputs 输入PDF文件列表，全部合并；第一个文件另做按页数拆分
+ * @param workDir 输出目录，测试文件保留以便检查
+ * @param subpages 拆分时每个文件的页数
+ * @return 制表符分隔的报告：操作、后端、耗时、页/秒、输出大小
+ */
+QString benchmark(const QStringList& inputs, const QString& workDir, int subpages = 10);
+
+} // namespace GraftCopy
+
+#endif // GRAFT_COPY_H
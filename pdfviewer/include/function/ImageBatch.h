@@ -0,0 +1,132 @@
+/**
+ * @file ImageBatch.h
+ * @brief 批量图片转PDF模块头文件
+ *
+ * 原来的批量转换在界面线程中逐个调用image2pdf，每个图片都新建一个PDFlib对象
+ * 并重新设置搜索路径。本模块：
+ * - 在多个工作线程上并行转换，每个工作线程持有一个长期存在的PDFlib对象
+ * - 每个图片单独输出为一个PDF，或合并为一个多页PDF
+ * - 合并时各工作线程并行解码图片并生成单页PDF，
+ *   调用线程按原顺序通过PDI导入，在途页面数有上限
+ * - 通过回调报告进度
+ * - JPEG和可直接嵌入的PNG原样复制压缩数据，其他格式（如BMP）只做一次快速Flate压缩，
+ *   并按文件头统计预计直通与转码的图片数
+ * - 可选的分辨率上限：页面长边缩到A4长边，超出上限的像素用ImageResample缩小后再嵌入
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma once
+#ifndef IMAGE_BATCH_H
+#define IMAGE_BATCH_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+/**
+ * @namespace ImageBatch
+ * @brief 批量图片转PDF功能命名空间
+ */
+namespace ImageBatch {
+
+// ================================
+// 参数与类型
+// ================================
+
+/**
+ * @brief 进度回调
+ *
+ * 每完成一个图片调用一次，done为已完成数（含失败），total为总数。
+ * 会在工作线程中调用，实现需线程安全（如发射跨线程信号）。
+ */
+typedef std::function<void(int done, int total)> Progress;
+
+/**
+ * @brief 图片嵌入方式统计
+ *
+ * 直通指压缩数据原样写入PDF（JPEG的DCT数据、非隔行且无Alpha通道PNG的IDAT数据），
+ * 转码指PDFlib解码后重新压缩。扫描件多为JPEG，直通比例高时转换基本只有读写开销。
+ * 直通数只按文件头规则预测，PDFlib对个别文件仍可能转码，不读取输出核对。
+ */
+struct Stats {
+    int expectedPassthrough = 0;  ///< 按文件头判断可原样嵌入的图片数
+    int transcoded = 0;   ///< 解码后重新压缩的图片数
+    int downsampled = 0;  ///< 按分辨率上限缩小后重新编码的图片数
+    int failed = 0;       ///< 无法读取的图片数
+    int skipped = 0;      ///< 合并时未能写入输出的图片数
+
+    /**
+     * @brief 生成一行便于记录日志的摘要
+     * @return 如"预计直通 118 转码 2 降采样 0 失败 0 跳过 0"
+     */
+    QString summary() const;
+};
+
+// ================================
+// 转换函数
+// ================================
+
+/**
+ * @brief 分辨率上限
+ *
+ * maxDpi大于0时，长边超过ImageResample::kPageLongEdge点的页面等比缩到该尺寸，
+ * 图片在该页面上的分辨率超过maxDpi时先按面积平均缩小：
+ * JPEG缩小后仍编码为JPEG，其他格式以原始像素交给PDFlib压缩。
+ * 带Alpha通道的图片不缩小。maxDpi为0时页面大小等于图片像素数，与原有行为一致。
+ */
+
+/**
+ * @brief 把单个图片转换为只有一页的内存PDF
+ * @param imageFile 图片文件路径（PNG、JPEG、BMP等）
+ * @param maxDpi 分辨率上限，0表示不限制
+ * @return PDF文件内容，失败时返回空数组
+ * @note 使用当前线程的PDFlib对象，同一线程上的多次调用共用该对象
+ */
+QByteArray imagePage(const QString& imageFile, int maxDpi = 0);
+
+/**
+ * @brief 把单个图片转换为PDF文件
+ * @param imageFile 图片文件路径
+ * @param pdfFile 输出PDF文件路径
+ * @param stats 输出嵌入方式统计，可为nullptr
+ * @param maxDpi 分辨率上限，0表示不限制
+ * @return 0: 成功, 2: 失败
+ */
+int convertFile(const QString& imageFile, const QString& pdfFile, Stats* stats = nullptr,
+                int maxDpi = 0);
+
+/**
+ * @brief 把每个图片分别转换为PDF
+ * @param images 图片文件路径列表，输出文件为"图片路径.pdf"
+ * @param workers 工作线程数，0表示使用CPU核心数
+ * @param progress 进度回调，可为空
+ * @param stats 输出嵌入方式统计，可为nullptr
+ * @param maxDpi 分辨率上限，0表示不限制
+ * @return 成功转换的图片数
+ */
+int convertEach(const QStringList& images, int workers = 0,
+                const Progress& progress = Progress(), Stats* stats = nullptr,
+                int maxDpi = 0);
+
+/**
+ * @brief 把图片列表按顺序合并为一个多页PDF
+ * @param images 图片文件路径列表，每个图片占一页
+ * @param pdfFile 输出PDF文件路径
+ * @param workers 解码线程数，0表示使用CPU核心数
+ * @param progress 进度回调，可为空
+ * @param stats 输出嵌入方式统计，可为nullptr
+ * @param maxDpi 分辨率上限，0表示不限制；缩小在各解码线程中并行进行
+ * @return 0: 成功, 2: 失败（包括有图片被跳过）
+ * @note 无法读取的图片记录后跳过，其他页面照常写入，跳过的图片数记入stats->skipped；
+ *       单页PDF通过PDI导入时图片数据流原样复制，直通的图片在合并后仍是原始数据
+ */
+int combine(const QStringList& images, const QString& pdfFile, int workers = 0,
+            const Progress& progress = Progress(), Stats* stats = nullptr,
+            int maxDpi = 0);
+
+} // namespace ImageBatch
+
+#endif // IMAGE_BATCH_H
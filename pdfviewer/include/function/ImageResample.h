@@ -0,0 +1,70 @@
+/**
+ * @file ImageResample.h
+ * @brief 像素数据降采样模块头文件
+ *
+ * 手机照片和600 DPI扫描件按原始像素嵌入PDF时体积大、下游渲染慢。
+ * 本模块按面积平均（box filter）缩小8位像素数据：
+ * - 输出像素取其覆盖的输入区域的加权平均，区域边缘不满一个像素的部分按覆盖比例计权
+ * - 先纵向后横向分两步处理，纵向一步读取全部输入，使用SIMD
+ * - 只支持缩小，缩小倍数不必是整数
+ *
+ * x86/x64上纵向一步使用SSE2，其他平台使用等价的标量实现。
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma once
+#ifndef IMAGE_RESAMPLE_H
+#define IMAGE_RESAMPLE_H
+
+#include <QByteArray>
+
+/**
+ * @namespace ImageResample
+ * @brief 像素数据降采样功能命名空间
+ */
+namespace ImageResample {
+
+// ================================
+// 参数
+// ================================
+
+/**
+ * @brief 限制分辨率时参照的页面长边：A4长边842点
+ *
+ * 长边超过该尺寸的图片页面缩到该尺寸，分辨率上限按该尺寸换算为像素数。
+ */
+const double kPageLongEdge = 842;
+
+// ================================
+// 降采样函数
+// ================================
+
+/**
+ * @brief 按面积平均缩小像素数据
+ * @param src 像素数据，每分量8位
+ * @param width 宽度（像素）
+ * @param height 高度（像素）
+ * @param stride 行字节数
+ * @param components 每像素分量数（1为灰度，3为RGB）
+ * @param dstWidth 输出宽度，不大于width
+ * @param dstHeight 输出高度，不大于height
+ * @return 输出像素数据，行间无填充；参数无效时返回空数组
+ */
+QByteArray downsample(const unsigned char* src, int width, int height, int stride,
+                      int components, int dstWidth, int dstHeight);
+
+/**
+ * @brief 按比例计算缩小后的尺寸
+ * @param width 原宽度（像素）
+ * @param height 原高度（像素）
+ * @param scale 缩放比例（0~1）
+ * @param dstWidth 输出宽度，至少为1
+ * @param dstHeight 输出高度，至少为1
+ */
+void scaledSize(int width, int height, double scale, int* dstWidth, int* dstHeight);
+
+} // namespace ImageResample
+
+#endif // IMAGE_RESAMPLE_H
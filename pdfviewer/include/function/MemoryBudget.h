@@ -0,0 +1,105 @@
+/**
+ * @file MemoryBudget.h
+ * @brief 内存预算模块头文件
+ *
+ * 多个文件、多个处理阶段同时持有整页像素数据时，内存占用不再由线程数决定，
+ * 而是由一个共享的字节预算限制：
+ * - 大块数据分配前先申请预算，预算不足时阻塞等待其他持有方归还
+ * - 单个请求超过整个预算时，只要当前没有其他占用就允许通过，避免死锁
+ * - 记录占用峰值，便于调整预算大小
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma once
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QtGlobal>
+
+/**
+ * @class MemoryBudget
+ * @brief 线程安全的字节预算
+ */
+class MemoryBudget {
+public:
+    /**
+     * @brief 构造函数
+     * @param limit 预算上限（字节）
+     */
+    explicit MemoryBudget(qint64 limit);
+
+    /**
+     * @brief 进程共享的默认预算
+     * @return 默认预算对象，上限为kDefaultLimit
+     * @note 导出PDF等批量任务的所有文件共用该预算
+     */
+    static MemoryBudget* shared();
+
+    /**
+     * @brief 默认预算上限：1 GB
+     */
+    static const qint64 kDefaultLimit = 1024LL * 1024 * 1024;
+
+    /**
+     * @brief 修改预算上限
+     * @param limit 新的上限（字节）
+     */
+    void setLimit(qint64 limit);
+
+    /**
+     * @brief 获取预算上限
+     */
+    qint64 limit() const;
+
+    /**
+     * @brief 申请预算，不足时阻塞等待
+     * @param bytes 申请的字节数
+     */
+    void acquire(qint64 bytes);
+
+    /**
+     * @brief 尝试申请预算，不等待
+     * @param bytes 申请的字节数
+     * @return 申请成功返回true
+     */
+    bool tryAcquire(qint64 bytes);
+
+    /**
+     * @brief 不经检查直接记入占用
+     * @param bytes 记入的字节数
+     * @note 用于已持有预算的数据改换持有方（如复制到下一阶段），
+     *       此时等待会与原持有方互相阻塞
+     */
+    void charge(qint64 bytes);
+
+    /**
+     * @brief 归还预算并唤醒等待方
+     * @param bytes 归还的字节数
+     */
+    void release(qint64 bytes);
+
+    /**
+     * @brief 当前占用（字节）
+     */
+    qint64 used() const;
+
+    /**
+     * @brief 占用峰值（字节）
+     */
+    qint64 peak() const;
+
+private:
+    bool fits(qint64 bytes) const;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_released;
+    qint64 m_limit;
+    qint64 m_used = 0;
+    qint64 m_peak = 0;
+};
+
+#endif  // MEMORY_BUDGET_H
@@ -0,0 +1,138 @@
+/**
+ * @file PageRasterizer.h
+ * @brief 单文档分页并行栅格化模块头文件
+ *
+ * 批量处理只在文件之间并行，单个几百页的文档栅格化仍由一个线程完成。
+ * 本模块把一个文档的页面分给多个工作线程渲染：
+ * - 文档只打开一次，在调用线程中逐页取得显示列表（display list）
+ * - 按文件路径栅格化时显示列表取自DisplayListCache，跨调用复用
+ * - 各工作线程使用从DisplayListCache基础上下文克隆的上下文渲染显示列表
+ * - 渲染结果严格按页码顺序交给调用方
+ * - 可按水平条带渲染，每个工作线程的内存与条带大小而不是页面大小成正比
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma once
+#ifndef PAGE_RASTERIZER_H
+#define PAGE_RASTERIZER_H
+
+#include <QByteArray>
+#include <QString>
+#include <functional>
+#include "mupdf/fitz.h"
+#include "include/function/MemoryBudget.h"
+
+/**
+ * @namespace PageRasterizer
+ * @brief 分页并行栅格化功能命名空间
+ */
+namespace PageRasterizer {
+
+// ================================
+// 参数与类型
+// ================================
+
+/**
+ * @brief 自动条带模式下单个条带的像素数据上限：32 MB
+ *
+ * 整页像素数据不超过该值时不分条带；超过时按该值计算条带高度。
+ */
+const qint64 kAutoBandBytes = 32LL * 1024 * 1024;
+
+/**
+ * @brief 页面结果处理函数
+ *
+ * 在调用rasterize的线程中按页码顺序调用，每页调用一次。
+ * pix为不带透明通道的RGB像素数据，调用返回后由本模块释放；
+ * bounds为页面显示区域（点，已考虑/Rotate）。返回false时中止处理。
+ */
+typedef std::function<bool(fz_context* ctx, int page, fz_pixmap* pix,
+                           const fz_rect& bounds)> PageSink;
+
+/**
+ * @brief 条带位置信息
+ */
+struct Band {
+    int page = 0;       ///< 页码（从0开始）
+    int index = 0;      ///< 条带在页内的序号（从上到下，从0开始）
+    int count = 1;      ///< 页内条带总数
+    fz_irect area;      ///< 条带的像素区域
+    fz_irect pageArea;  ///< 整页的像素区域，area是它的一个水平切片
+    fz_rect bounds;     ///< 页面显示区域（点，已考虑/Rotate）
+    bool color = true;  ///< 页面是否含彩色内容，只在分条带时检测，未检测时为true
+};
+
+/**
+ * @brief 条带结果处理函数
+ *
+ * 按页码、页内条带序号的顺序在调用线程中调用。pix为条带的RGB像素数据，
+ * 其bbox等于band.area，调用返回后由本模块释放。返回false时中止处理。
+ */
+typedef std::function<bool(fz_context* ctx, const Band& band, fz_pixmap* pix)> BandSink;
+
+// ================================
+// 栅格化函数
+// ================================
+
+/**
+ * @brief 并行栅格化内存中PDF的全部页面
+ * @param pdfData PDF文件内容
+ * @param resolution 栅格化分辨率（DPI）
+ * @param sink 页面结果处理函数
+ * @param workers 渲染线程数，0表示使用CPU核心数
+ * @param budget 内存预算，每页像素数据在渲染前申请、处理函数返回后归还，
+ *               nullptr表示不限制
+ * @return 处理的页数，文档无法打开或处理失败时返回-1
+ * @note 同时在途的页面不超过渲染线程数的两倍，内存占用与文档页数无关
+ */
+int rasterize(const QByteArray& pdfData, int resolution, const PageSink& sink,
+              int workers = 0, MemoryBudget* budget = nullptr);
+
+/**
+ * @brief 按水平条带并行栅格化内存中PDF的全部页面
+ * @param pdfData PDF文件内容
+ * @param resolution 栅格化分辨率（DPI）
+ * @param bandHeight 条带高度（像素），0表示整页作为一个条带，
+ *                   小于0表示自动：整页超过kAutoBandBytes时才分条带
+ * @param sink 条带结果处理函数
+ * @param workers 渲染线程数，0表示使用CPU核心数
+ * @param budget 内存预算，按条带申请和归还，nullptr表示不限制
+ * @return 处理的页数，失败时返回-1
+ * @note 同一页的各条带共享一个显示列表，可由不同线程同时渲染
+ */
+int rasterizeBands(const QByteArray& pdfData, int resolution, int bandHeight,
+                   const BandSink& sink, int workers = 0,
+                   MemoryBudget* budget = nullptr);
+
+/**
+ * @brief 并行栅格化PDF文件的全部页面
+ * @param pdfFile PDF文件路径
+ * @param resolution 栅格化分辨率（DPI）
+ * @param sink 页面结果处理函数
+ * @param workers 渲染线程数，0表示使用CPU核心数
+ * @param budget 内存预算，nullptr表示不限制
+ * @return 处理的页数，失败时返回-1
+ * @note 显示列表取自DisplayListCache，文件未改动时再次栅格化不重新解析页面
+ */
+int rasterizeFile(const QString& pdfFile, int resolution, const PageSink& sink,
+                  int workers = 0, MemoryBudget* budget = nullptr);
+
+/**
+ * @brief 按水平条带并行栅格化PDF文件的全部页面
+ * @param pdfFile PDF文件路径
+ * @param resolution 栅格化分辨率（DPI）
+ * @param bandHeight 条带高度（像素），含义同rasterizeBands
+ * @param sink 条带结果处理函数
+ * @param workers 渲染线程数，0表示使用CPU核心数
+ * @param budget 内存预算，nullptr表示不限制
+ * @return 处理的页数，失败时返回-1
+ */
+int rasterizeFileBands(const QString& pdfFile, int resolution, int bandHeight,
+                       const BandSink& sink, int workers = 0,
+                       MemoryBudget* budget = nullptr);
+
+} // namespace PageRasterizer
+
+#endif // PAGE_RASTERIZER_H
@@ -0,0 +1,87 @@
+/**
+ * @file ParallelWatermark.h
+ * @brief 大文档分页并行水印模块头文件
+ *
+ * 批量处理只在文件之间并行，单个几千页的文档仍由一个线程处理。
+ * 本模块把一个大文档按页面范围切分，各范围并发加水印，
+ * 再拼接成一个输出文件：
+ * - 页数达到阈值时才切换到分页并行模式
+ * - 各范围的结果保存在内存中，不产生临时文件
+ * - 拼接时保留页面注释以及原文档的书签和页码标签
+ * - 所有文档的页面范围共用一个线程池，并发不超过CPU核心数
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma once
+#ifndef PARALLEL_WATERMARK_H
+#define PARALLEL_WATERMARK_H
+
+#include <QByteArray>
+#include <QString>
+#include <functional>
+
+/**
+ * @namespace ParallelWatermark
+ * @brief 分页并行水印功能命名空间
+ */
+namespace ParallelWatermark {
+
+// ================================
+// 参数与类型
+// ================================
+
+/**
+ * @brief 切换到分页并行模式的页数阈值
+ */
+const int kPageThreshold = 400;
+
+/**
+ * @brief 每个页面范围的最少页数，避免范围过碎导致重复打开输入文档
+ */
+const int kMinPagesPerRange = 50;
+
+/**
+ * @brief 页面范围水印函数
+ *
+ * 为输入文档的[firstPage, lastPage]页（从1开始，包含两端）加水印，
+ * 返回只包含这些页面的PDF数据，失败时返回空数组。
+ * 会在多个线程中同时调用，实现时每个线程需使用独立的PDFlib对象。
+ */
+typedef std::function<QByteArray(int firstPage, int lastPage)> RangeRenderer;
+
+// ================================
+// 分页并行处理函数
+// ================================
+
+/**
+ * @brief 判断文档是否应切换到分页并行模式
+ * @param pageCount 文档页数
+ * @return 页数达到阈值且有多个CPU核心时返回true
+ */
+bool shouldSplit(int pageCount);
+
+/**
+ * @brief 获取PDF文件页数
+ * @param pdfFile PDF文件路径
+ * @return 页数，文件无法打开时返回0
+ * @note 使用MuPDF只解析交叉引用表和页面树，不解析页面内容
+ */
+int pageCount(const QString& pdfFile);
+
+/**
+ * @brief 分页并行加水印
+ * @param inFile 输入PDF文件路径（用于读取书签和页码标签）
+ * @param outFile 输出PDF文件路径
+ * @param pageCount 输入文档页数
+ * @param render 页面范围水印函数
+ * @param workers 切分的并发数，0表示使用CPU核心数；实际并发受共用线程池限制
+ * @return 0: 成功, 2: 失败
+ */
+int run(const QString& inFile, const QString& outFile, int pageCount,
+        const RangeRenderer& render, int workers = 0);
+
+} // namespace ParallelWatermark
+
+#endif // PARALLEL_WATERMARK_H
@@ -4,8 +4,9 @@
  * 
  * 提供PDF文档的基础操作功能，包括：
  * - PDF文档信息获取（页面数、页面尺寸）
- * - PDF文档拆分（按页数或页面范围）
- * - PDF文档合并
+ * - PDF文档拆分（按页数或页面范围，多个范围只解析一次输入）
+ * - PDF文档合并（可按页面范围直接从原文件导入）
+ * - 拆分、合并的内存缓冲区版本，连续处理时不经过临时文件
  * 
  * @author Qt PDF工具集项目组
  * @date 2023
@@ -19,7 +20,11 @@
 #include <list>
 #include <iostream>
 #include <sstream>
+#include <QByteArray>
 #include <QDebug>
+#include <QList>
+#include <QString>
+#include <QStringList>
 #include "mupdf/fitz.h"
 #include "lib/pdflib.hpp"
 #include "include/function/StringConverter.h"
@@ -53,6 +58,48 @@ int getPages(string pdfFile);
  */
 int getPageheight(wstring filename);
 
+// ================================
+// 页面范围与复制方式
+// ================================
+
+/**
+ * @brief 拆分、合并时的页面复制方式
+ */
+enum class CopyBackend {
+    Pdi,   ///< PDFlib PDI：每页导入为模板再放置到新页面，逐页写出
+    Graft  ///< MuPDF对象嫁接：直接复制页面对象，共用的字体、图片只复制一次，见GraftCopy
+};
+
+/**
+ * @brief 页面范围，从0开始，包含start、不包含end，与splitPdf的参数含义相同
+ */
+struct PageRange {
+    int start = 0;  ///< 起始页（从0开始）
+    int end = 0;    ///< 结束页（不包含此页）
+    int step = 1;   ///< 页码间隔，奇数页、偶数页为2
+};
+
+/**
+ * @brief 拆分的一个输出文件
+ */
+struct SplitSection {
+    QString label;            ///< 文件名中的范围标识，如"3-8"、"odd"
+    QList<PageRange> ranges;  ///< 按顺序写入的页面范围
+};
+
+/**
+ * @brief 解析拆分范围说明
+ * @param spec 以逗号分隔的范围说明，每一项生成一个文件：
+ *             "5"单页，"3-8"区间，"12-"到末页，"-4"从首页，
+ *             "odd"/"奇数"全部奇数页，"even"/"偶数"全部偶数页
+ * @param pageCount 文档页数，用于展开开放区间和检查越界
+ * @param sections 解析结果
+ * @param error 解析失败时的错误说明，可以为nullptr
+ * @return 解析成功返回true
+ */
+bool parseSplitSpec(const QString& spec, int pageCount, QList<SplitSection>* sections,
+                    QString* error = nullptr);
+
 // ================================
 // PDF拆分函数组
 // ================================
@@ -67,6 +114,24 @@ int getPageheight(wstring filename);
  */
 int splitPdf(string in, string out, int subpages);
 
+/**
+ * @brief 把指定页面范围按页数并行拆分为多个文件
+ * @param inFile 输入PDF文件路径
+ * @param outBase 输出文件名前缀
+ * @param subpages 每个拆分文件的页数
+ * @param start 起始页（从0开始）
+ * @param end 结束页（不包含此页），-1表示到末页
+ * @param workers 并发数，0表示使用CPU核心数
+ * @param backend 页面复制方式
+ * @return 0: 成功, 2: 失败
+ * @note 生成的文件名格式与splitPdf相同：outBase_1.pdf, outBase_2.pdf, ...
+ *       输入文件只读入内存一次，各线程通过PVF共享这份数据；
+ *       指定范围时直接从原文件拆分，不再生成中间文件
+ */
+int splitPdfChunks(const QString& inFile, const QString& outBase, int subpages,
+                   int start = 0, int end = -1, int workers = 0,
+                   CopyBackend backend = CopyBackend::Pdi);
+
 /**
  * @brief 从PDF中提取指定页面范围为新文件
  * @param in 输入PDF文件路径
@@ -78,10 +143,32 @@ int splitPdf(string in, string out, int subpages);
  */
 int splitPdf(string in, string out, int start, int end);
 
+/**
+ * @brief 按多个页面范围拆分PDF
+ * @param inFile 输入PDF文件路径
+ * @param outBase 输出文件名前缀
+ * @param sections 各输出文件的页面范围，通常由parseSplitSpec得到
+ * @param backend 页面复制方式
+ * @return 0: 全部成功, 2: 有文件失败
+ * @note 输入文档只打开、解析一次，所有输出文件共用同一个PDI句柄；
+ *       生成的文件名格式与splitPdf相同：outBase_label_split.pdf
+ */
+int splitPdf(const QString& inFile, const QString& outBase, const QList<SplitSection>& sections,
+             CopyBackend backend = CopyBackend::Pdi);
+
 // ================================
 // PDF合并函数组
 // ================================
 
+/**
+ * @brief 合并的一个输入
+ */
+struct MergeSource {
+    QString file;             ///< 输入PDF文件路径
+    QList<PageRange> ranges;  ///< 按顺序导入的页面范围，为空表示全部页面
+    QString bookmark;         ///< 该输入第一个导入页面的书签文本，为空时不创建书签
+};
+
 /**
  * @brief 将多个PDF文件合并为一个文件
  * @param fileList 要合并的PDF文件路径列表
@@ -91,6 +178,41 @@ int splitPdf(string in, string out, int start, int end);
  */
 int mergePdf(std::list<string> fileList, string outFile);
 
+/**
+ * @brief 按页面范围从原文件直接合并为一个文件
+ * @param sources 输入列表，同一文件可以出现多次
+ * @param outFile 输出PDF文件路径
+ * @param backend 页面复制方式
+ * @return 0: 成功, 2: 失败
+ * @note 页面只导入、写出一次，不经过拆分的中间结果；同一文件只打开一次。
+ *       输出文件同时也是输入时先写入内存，关闭输入后再保存
+ */
+int mergePdf(const QList<MergeSource>& sources, const QString& outFile,
+             CopyBackend backend = CopyBackend::Pdi);
+
+// ================================
+// 内存缓冲区版本
+// ================================
+
+/**
+ * @brief 从内存中的PDF提取指定页面范围
+ * @param pdfData 输入PDF文件内容
+ * @param start 截取的起始页（从0开始）
+ * @param end 截取的结束页（不包含此页）
+ * @return 只包含这些页面的PDF文件内容，失败时返回空数组
+ * @note 输入通过PVF虚拟文件交给PDFlib，输出写入内存，不产生临时文件
+ */
+QByteArray splitPdfBuffer(const QByteArray& pdfData, int start, int end);
+
+/**
+ * @brief 将内存中的多个PDF合并为一个
+ * @param pdfs 要合并的PDF文件内容列表
+ * @param bookmarks 每个输入第一页的书签文本，为空或数量不足时不创建书签
+ * @return 合并后的PDF文件内容，失败时返回空数组
+ */
+QByteArray mergePdfBuffers(const QList<QByteArray>& pdfs,
+                           const QStringList& bookmarks = QStringList());
+
 } // namespace PdfOperations
 
 #endif // PDF_OPERATIONS_H
@@ -0,0 +1,95 @@
+/**
+ * @file RasterAnalysis.h
+ * @brief 栅格页面色调检测与转换模块头文件
+ *
+ * 扁平化输出的页面大多是白底黑字，按RGB无损压缩既大又慢。本模块：
+ * - 用SIMD扫描RGB像素，判断页面是黑白、灰度还是彩色
+ * - 把RGB像素转换为8位灰度或1位黑白数据，供对应的编码器使用
+ *
+ * x86/x64上使用SSE2，其他平台使用等价的标量实现。
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma once
+#ifndef RASTER_ANALYSIS_H
+#define RASTER_ANALYSIS_H
+
+#include <QByteArray>
+
+/**
+ * @namespace RasterAnalysis
+ * @brief 栅格页面分析功能命名空间
+ */
+namespace RasterAnalysis {
+
+// ================================
+// 检测参数
+// ================================
+
+/**
+ * @brief 判定为灰色像素时R、G、B两两之间允许的最大差值
+ */
+const int kGrayTolerance = 12;
+
+/**
+ * @brief 判定为"接近纯黑或纯白"时与0或255的最大距离
+ */
+const int kBitonalTolerance = 48;
+
+/**
+ * @brief 黑白页面中允许的中间调像素比例（文字抗锯齿边缘）
+ */
+const double kBitonalMidtoneRatio = 0.04;
+
+/**
+ * @brief 黑白页面中允许的"成片"中间调像素数
+ *
+ * 抗锯齿边缘的中间调像素上下左右总有接近纯黑或纯白的邻居；
+ * 四邻都是中间调的像素说明存在成片的灰色区域（如浅色水印），
+ * 二值化会把它整块丢掉，超过该数量时按灰度处理。
+ */
+const int kBitonalFlatMidtoneLimit = 64;
+
+/**
+ * @brief 页面色调
+ */
+enum class Tone {
+    Color,   ///< 彩色
+    Gray,    ///< 灰度
+    Bitonal  ///< 黑白
+};
+
+// ================================
+// 检测与转换函数
+// ================================
+
+/**
+ * @brief 判断RGB像素数据的色调
+ * @param rgb 像素数据，每像素3字节
+ * @param width 宽度（像素）
+ * @param height 高度（像素）
+ * @param stride 行字节数
+ * @return 页面色调；遇到彩色像素时立即返回，不扫描剩余数据
+ *
+ * 中间调比例不超过kBitonalMidtoneRatio、且成片中间调像素不超过
+ * kBitonalFlatMidtoneLimit时才判定为黑白。
+ */
+Tone classify(const unsigned char* rgb, int width, int height, int stride);
+
+/**
+ * @brief RGB转8位灰度
+ * @return 每像素1字节的灰度数据，行间无填充
+ */
+QByteArray toGray(const unsigned char* rgb, int width, int height, int stride);
+
+/**
+ * @brief RGB转1位黑白（阈值128）
+ * @return 每行按字节对齐的位图，1表示白、0表示黑（PDF DeviceGray 1位的默认含义）
+ */
+QByteArray toBitonal(const unsigned char* rgb, int width, int height, int stride);
+
+} // namespace RasterAnalysis
+
+#endif // RASTER_ANALYSIS_H
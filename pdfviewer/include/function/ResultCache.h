@@ -0,0 +1,132 @@
+/**
+ * @file ResultCache.h
+ * @brief 处理结果缓存头文件
+ *
+ * 操作人员经常在只改动少数文件后重新处理整个目录。本缓存按
+ * "输入文件内容哈希 + 操作名 + 全部参数"保存输出文件，输入和参数都未变化时
+ * 直接取出上次的结果，不再重新处理：
+ * - 键为SHA-256，与文件路径和修改时间无关，文件被复制、改名后仍能命中
+ * - 取出时优先建立硬链接，跨卷或失败时退化为复制
+ * - 缓存条目被外部改写（硬链接的另一端被原地修改）时自动作废
+ * - 按字节上限做LRU淘汰，索引保存在缓存目录中，跨进程保留
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma once
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @class ResultCache
+ * @brief 线程安全的内容寻址结果缓存
+ */
+class ResultCache {
+public:
+    /**
+     * @brief 构造函数
+     * @param dir 缓存目录，不存在时自动创建
+     * @param limit 缓存上限（字节）
+     */
+    ResultCache(const QString& dir, qint64 limit);
+
+    /**
+     * @brief 析构函数，保存索引
+     */
+    ~ResultCache();
+
+    /**
+     * @brief 进程共享的默认缓存
+     * @return 位于用户缓存目录下results子目录、上限为kDefaultLimit的缓存
+     */
+    static ResultCache* shared();
+
+    /**
+     * @brief 默认缓存上限：2 GB
+     */
+    static const qint64 kDefaultLimit = 2048LL * 1024 * 1024;
+
+    /**
+     * @brief 计算缓存键
+     * @param operation 操作名，如"watermark"、"flatten"
+     * @param inputFile 输入文件路径
+     * @param params 影响输出的全部参数，顺序固定
+     * @return 缓存键（十六进制SHA-256），输入文件无法读取时返回空字符串
+     * @note 同一进程内输入文件的哈希按路径记忆，修改时间和大小未变时不再读文件
+     */
+    QString key(const QString& operation, const QString& inputFile,
+                const QStringList& params);
+
+    /**
+     * @brief 取出缓存结果
+     * @param key 缓存键
+     * @param outFile 输出文件路径，已存在时覆盖
+     * @return 命中并成功写出时返回true
+     */
+    bool fetch(const QString& key, const QString& outFile);
+
+    /**
+     * @brief 保存处理结果
+     * @param key 缓存键
+     * @param outFile 刚生成的输出文件，复制一份存入缓存
+     * @note 超出上限时淘汰最久未使用的条目
+     */
+    void store(const QString& key, const QString& outFile);
+
+    /**
+     * @brief 修改缓存上限
+     * @param limit 新的上限（字节），0表示不再保存新结果
+     */
+    void setLimit(qint64 limit);
+
+    /**
+     * @brief 获取缓存上限
+     */
+    qint64 limit() const;
+
+    /**
+     * @brief 获取当前缓存占用（字节）
+     */
+    qint64 size() const;
+
+    /**
+     * @brief 删除全部缓存条目
+     */
+    void clear();
+
+private:
+    struct Entry {
+        qint64 size = 0;
+        qint64 modified = 0;  ///< 存入时条目文件的修改时间（毫秒），用于发现外部改写
+        qint64 used = 0;      ///< 最近使用时间（毫秒）
+    };
+
+    struct InputHash {
+        qint64 modified = 0;  ///< 计算哈希时输入文件的修改时间（毫秒）
+        qint64 size = 0;
+        QString hash;
+    };
+
+    QString entryPath(const QString& key) const;
+    QString inputHash(const QString& inputFile);
+    void remove(const QString& key);
+    void evict();
+    void load();
+    void save(bool force = false) const;
+
+    mutable QMutex m_mutex;
+    QString m_dir;
+    qint64 m_limit;
+    qint64 m_size = 0;
+    mutable qint64 m_lastSave = 0;
+    QHash<QString, Entry> m_entries;
+    QHash<QString, InputHash> m_inputHashes;  ///< 绝对路径 -> 内容哈希，数量有上限
+};
+
+#endif // RESULT_CACHE_H
@@ -0,0 +1,87 @@
+/**
+ * @file TextMetrics.h
+ * @brief 文本度量服务模块头文件
+ *
+ * 为水印排版提供与平台无关的文本尺寸计算：
+ * - 基于QRawFont读取字体文件中的字形前进宽度，不依赖Windows GDI
+ * - 按（字体、字号）缓存字体对象和字形前进宽度
+ * - 按（文本、字体、字号）缓存测量结果
+ * - 所有函数线程安全，各水印工作线程共用同一份缓存
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma once
+#ifndef TEXT_METRICS_H
+#define TEXT_METRICS_H
+
+#include <QSizeF>
+#include <QString>
+
+/**
+ * @namespace TextMetrics
+ * @brief 文本度量功能命名空间
+ */
+namespace TextMetrics {
+
+// ================================
+// 字体解析函数
+// ================================
+
+/**
+ * @brief 把界面上显示的字体名称转换为字体文件名
+ * @param fontName 字体名称（如"楷体"，或已经是"simkai"这样的文件名）
+ * @return 字体文件名（不含扩展名），无法识别时原样返回
+ * @note 与PDFlib加载字体时使用的FontOutline文件名一致，
+ *       新宋体位于字体集合simsun.ttc中，返回"simsun"
+ */
+QString fontFileName(const QString& fontName);
+
+/**
+ * @brief 把界面上显示的字体名称转换为PDFlib字体名称
+ * @param fontName 字体名称（如"新宋体"）
+ * @return PDFlib load_font使用的字体名称，新宋体为"NSimSun"，其余同fontFileName
+ * @note 对字体集合中的字体，该名称同时用于选择集合中的字体
+ */
+QString pdfFontName(const QString& fontName);
+
+// ================================
+// 文本测量函数
+// ================================
+
+/**
+ * @brief 测量单行文本的尺寸
+ * @param text 文本内容
+ * @param fontName 字体名称
+ * @param fontSize 字号（像素）
+ * @return 宽度为各字形前进宽度之和，高度为字体行高
+ */
+QSizeF textSize(const QString& text, const QString& fontName, int fontSize);
+
+/**
+ * @brief 测量单行文本的宽度
+ * @param text 文本内容
+ * @param fontName 字体名称
+ * @param fontSize 字号（像素）
+ * @return 文本宽度
+ */
+qreal textWidth(const QString& text, const QString& fontName, int fontSize);
+
+/**
+ * @brief 获取字体行高（升部 + 降部，不含行距）
+ * @param fontName 字体名称
+ * @param fontSize 字号（像素）
+ * @return 行高
+ */
+qreal lineHeight(const QString& fontName, int fontSize);
+
+/**
+ * @brief 清空所有缓存
+ * @note 字体文件被替换后调用，一般不需要
+ */
+void clearCache();
+
+} // namespace TextMetrics
+
+#endif // TEXT_METRICS_H
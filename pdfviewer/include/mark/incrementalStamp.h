@@ -0,0 +1,44 @@
+/**
+ * @file incrementalStamp.h
+ * @brief 以增量更新方式追加水印的头文件
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ *
+ * 重建模式需要通过PDI重新导入每一页，耗时与文档中图片、字体的
+ * 总字节数成正比。追加模式使用MuPDF的pdf_*对象接口：
+ * - 水印只写入一个共享的Form XObject
+ * - 每页只增加一小段内容流前缀/后缀来绘制该XObject
+ * - 以增量更新方式保存，原文件字节原样保留
+ *
+ * 输出耗时和写盘量因此只与页数有关，适合大体积的扫描件。
+ */
+
+#pragma once
+#ifndef INCREMENTALSTAMP_H
+#define INCREMENTALSTAMP_H
+
+#include <QByteArray>
+#include <QString>
+#include <functional>
+
+/**
+ * @brief 水印页提供函数
+ *
+ * 参数为页面显示宽度和高度（已考虑/Rotate），返回一个单页PDF的内容，
+ * 该页绘制了对应尺寸页面上的水印；返回空数组表示生成失败。
+ * 相同尺寸的页面只会调用一次。
+ */
+typedef std::function<QByteArray(double width, double height)> StampProvider;
+
+/**
+ * @brief 以增量更新方式为PDF追加水印
+ * @param inFile 输入PDF文件路径
+ * @param outFile 输出PDF文件路径，可以与输入相同（原地追加）
+ * @param stampFor 按页面尺寸生成水印页的函数
+ * @return 处理结果，0表示成功，2表示失败
+ * @note 无法增量保存的文档（如经过修复的损坏文件）会退化为完整重写
+ */
+int appendStampIncremental(const QString& inFile, const QString& outFile,
+                           const StampProvider& stampFor);
+
+#endif  // INCREMENTALSTAMP_H
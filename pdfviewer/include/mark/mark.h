@@ -25,6 +25,9 @@
 
 #include <QObject>
 #include <string>
+#include <vector>
+
+#include "include/mark/watermarkSession.h"
 
 using namespace std;
 
@@ -76,6 +79,24 @@ int setMark(std::string infile, std::string outfile, wstring mark_txt,
             wstring mark_color, wstring scale, wstring vertalign,
             wstring vertshift);
 
+/**
+ * @brief 在一次导入/写出中为PDF文件添加多条定位水印
+ * @param infile 输入PDF文件路径
+ * @param outfile 输出PDF文件路径
+ * @param mark_txt 水印文本内容
+ * @param mark_opacity 水印透明度
+ * @param mark_font 水印字体
+ * @param mark_rotate 水印旋转角度
+ * @param mark_color 水印颜色
+ * @param anchors 水印锚点列表，如WatermarkAnchor::threeLine()
+ * @return 处理结果，0表示成功
+ * @note 锚点数量只增加模板个数，文档仍只读写一次
+ */
+int setAnchoredMark(std::string infile, std::string outfile, wstring mark_txt,
+                    wstring mark_opacity, wstring mark_font, wstring mark_rotate,
+                    wstring mark_color,
+                    const std::vector<WatermarkAnchor>& anchors);
+
 /**
  * @brief 获取系统字体文件夹路径
  * @return 字体文件夹的完整路径（宽字符串格式）
@@ -130,4 +151,38 @@ int addWatermark(const QString& i = "in.pdf", const QString& o = "out.pdf",
                  const QString& s = "0.6", const QString& va = "center",
                  const QString& vs = "10");
 
+/**
+ * @brief 为内存中的PDF添加水印
+ * @param pdfData 输入PDF文件内容
+ * @param t 水印文本
+ * @param p 水印透明度百分比
+ * @param c 水印颜色
+ * @param r 水印旋转角度
+ * @param f 水印字体
+ * @return 加水印后的PDF文件内容，失败返回空数组
+ * @note 用于连续处理（如水印后栅格化）时在内存中传递PDF，不产生临时文件
+ */
+QByteArray addWatermarkBuffer(const QByteArray& pdfData,
+                              const QString& t = "联通数字科技有限公司总部投标专用文档",
+                              const QString& p = "15%", const QString& c = "gray",
+                              const QString& r = "45", const QString& f = "simkai");
+
+/**
+ * @brief 以追加（增量更新）方式添加水印
+ * @param i 输入PDF文件路径
+ * @param o 输出PDF文件路径，可以与输入相同
+ * @param t 水印文本
+ * @param p 水印透明度百分比
+ * @param c 水印颜色
+ * @param r 水印旋转角度
+ * @param f 水印字体
+ * @return 处理结果，0表示成功，2表示失败
+ * @note 不重新导入页面，只追加一个共享XObject和每页的少量内容流，
+ *       耗时与页数相关而与文档体积无关，适合大体积扫描件
+ */
+int appendWatermark(const QString& i, const QString& o,
+                    const QString& t = "联通数字科技有限公司总部投标专用文档",
+                    const QString& p = "15%", const QString& c = "gray",
+                    const QString& r = "45", const QString& f = "simkai");
+
 #endif  // WATERMARL_H
@@ -0,0 +1,70 @@
+/**
+ * @file personalize.h
+ * @brief 批量个性化水印头文件
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ *
+ * 同一份投标文件发给几百个收件人、每份带各自的姓名和编号时，
+ * 逐份调用addWatermark会把同一个输入反复解析几百次。
+ * 个性化模式只读取一次输入文件：
+ * - 输入内容读入内存后由所有工作线程共用（PVF，不复制）
+ * - 每个工作线程只解析一次文档，PDI文档句柄常驻在会话中
+ * - 每份输出只重新生成水印模板并写出文档
+ *
+ * 收件人列表为CSV文件，每行一个收件人：
+ *   水印文本[,输出文件名]
+ * 字段可用双引号包围，引号内可包含逗号，两个连续双引号表示一个双引号。
+ */
+
+#pragma once
+#ifndef PERSONALIZE_H
+#define PERSONALIZE_H
+
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <functional>
+
+#include "include/mark/watermarkSession.h"
+
+/**
+ * @brief 收件人
+ */
+struct Recipient {
+  QString text;     ///< 该收件人的水印文本
+  QString outFile;  ///< 输出PDF文件路径
+};
+
+/**
+ * @brief 个性化进度回调，参数为已完成份数和总份数，会在工作线程中调用
+ */
+typedef std::function<void(int done, int total)> PersonalizeProgress;
+
+/**
+ * @brief 读取收件人CSV文件
+ * @param csvFile CSV文件路径（UTF-8）
+ * @param inFile 输入PDF文件路径，用于生成默认输出文件名
+ * @param outputDir 输出目录
+ * @return 收件人列表；未指定输出文件名的行输出为"输入文件名_序号.pdf"
+ * @note 空行被跳过；输出文件重名（不区分大小写）时在扩展名前追加"_2"、"_3"等
+ */
+QList<Recipient> readRecipients(const QString& csvFile, const QString& inFile,
+                                const QString& outputDir);
+
+/**
+ * @brief 为同一输入文档生成多份不同水印文本的输出
+ * @param inFile 输入PDF文件路径
+ * @param recipients 收件人列表
+ * @param params 水印参数，其中的text被各收件人的文本替换
+ * @param result 可选，接收每个输出文件的处理结果（0表示成功）
+ * @param progress 可选，进度回调
+ * @param workers 并发数，0表示使用CPU核心数
+ * @return 全部成功返回0，输入无法读取或有输出失败返回2
+ */
+int personalize(const QString& inFile, const QList<Recipient>& recipients,
+                const WatermarkParams& params,
+                QMap<QString, int>* result = nullptr,
+                const PersonalizeProgress& progress = PersonalizeProgress(),
+                int workers = 0);
+
+#endif  // PERSONALIZE_H
@@ -0,0 +1,232 @@
+/**
+ * @file watermarkSession.h
+ * @brief 可复用的PDF水印会话类头文件
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ *
+ * 批量加水印时，每个文件都重新创建PDFlib对象、设置searchpath、
+ * 解析FontOutline并load_font，这部分固定开销往往比处理页面本身还大。
+ * WatermarkSession把这些与输入文件无关的准备工作只做一次：
+ * - PDFlib对象、searchpath在会话内长期保持
+ * - 字体在对象作用域中加载一次，跨文档复用
+ * - 模板与页面所需的选项列表预先拼好
+ *
+ * 每个输入/输出文件对只需调用一次process()。PDFlib对象不是线程安全的，
+ * 因此一个会话只能在一个线程中使用，线程池中可通过forCurrentThread()
+ * 获取当前工作线程专属的会话。
+ */
+
+#pragma once
+#ifndef WATERMARKSESSION_H
+#define WATERMARKSESSION_H
+
+#include <QByteArray>
+#include <QRectF>
+#include <QString>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "lib/pdflib.hpp"
+
+/**
+ * @brief 水印写入方式
+ */
+enum class WatermarkMode {
+  Rebuild,  ///< 通过PDI重新导入每一页生成新文档（默认）
+  Append    ///< 追加共享XObject并以增量更新方式保存，见incrementalStamp.h
+};
+
+/**
+ * @brief 水印锚点
+ *
+ * 描述一条水印在页面上的位置，对应PDFlib模板watermark选项中的
+ * scale、vertalign、vertshift子选项。一个文档的所有锚点在同一次
+ * 页面导入中由各自的模板自动放置，锚点数量不影响读写次数。
+ */
+struct WatermarkAnchor {
+  QString scale = "0.6";        ///< 缩放比例
+  QString vertalign = "center"; ///< 垂直对齐方式（top/center/bottom）
+  QString vertshift = "10";     ///< 垂直偏移量
+
+  bool operator==(const WatermarkAnchor& o) const {
+    return scale == o.scale && vertalign == o.vertalign &&
+           vertshift == o.vertshift;
+  }
+  bool operator!=(const WatermarkAnchor& o) const { return !(*this == o); }
+
+  /**
+   * @brief 上、中、下三条水印的锚点
+   * @return 与原先三次调用setMark时使用的位置参数相同
+   */
+  static std::vector<WatermarkAnchor> threeLine() {
+    return {{"0.6", "top", "-10"}, {"0.6", "center", "10"},
+            {"0.6", "bottom", "40"}};
+  }
+};
+
+/**
+ * @brief 水印参数
+ *
+ * 与addWatermark()的参数一一对应，透明度等沿用PDFlib选项字符串格式
+ */
+struct WatermarkParams {
+  QString text = "联通数字科技有限公司总部投标专用文档";  ///< 水印文本
+  QString opacity = "15%";                                ///< 透明度
+  QString color = "gray";                                 ///< 颜色
+  QString rotate = "45";                                  ///< 旋转角度
+  QString font = "simkai";                                ///< 字体名称
+  WatermarkMode mode = WatermarkMode::Rebuild;            ///< 写入方式
+  std::vector<WatermarkAnchor> anchors;  ///< 水印锚点，为空时使用单条默认位置
+  int tileColumns = 0;  ///< 平铺列数，与tileRows均大于0时启用平铺模式
+  int tileRows = 0;     ///< 平铺行数
+
+  /**
+   * @brief 是否为平铺模式
+   * @note 平铺模式下忽略anchors，文本只绘制一次到Form XObject，
+   *       每个网格位置只引用该XObject
+   */
+  bool tiled() const { return tileColumns > 0 && tileRows > 0; }
+
+  bool operator==(const WatermarkParams& o) const {
+    return text == o.text && opacity == o.opacity && color == o.color &&
+           rotate == o.rotate && font == o.font && mode == o.mode &&
+           anchors == o.anchors && tileColumns == o.tileColumns &&
+           tileRows == o.tileRows;
+  }
+  bool operator!=(const WatermarkParams& o) const { return !(*this == o); }
+};
+
+/**
+ * @brief 水印会话
+ *
+ * 持有一个长期存在的PDFlib对象，在多个输入/输出文件之间复用
+ * 字体、搜索路径和选项列表。PDFlib的模板属于文档作用域，
+ * 每个文档仍需重新生成，但此时字体已经加载完毕，代价很小。
+ */
+class WatermarkSession {
+ public:
+  WatermarkSession();
+  explicit WatermarkSession(const WatermarkParams& params);
+  ~WatermarkSession();
+
+  WatermarkSession(const WatermarkSession&) = delete;
+  WatermarkSession& operator=(const WatermarkSession&) = delete;
+
+  /**
+   * @brief 设置水印参数
+   * @param params 新的水印参数
+   * @note 仅在字体变化时才会重新加载字体，其余参数只重建选项列表
+   */
+  void setParams(const WatermarkParams& params);
+
+  /**
+   * @brief 获取当前水印参数
+   */
+  const WatermarkParams& params() const { return m_params; }
+
+  /**
+   * @brief 为一个PDF文件添加水印
+   * @param inFile 输入PDF文件路径
+   * @param outFile 输出PDF文件路径
+   * @return 处理结果，0表示成功，2表示失败
+   * @note 发生PDFlib异常后会话内部的PDFlib对象会被丢弃，下次调用时自动重建；
+   *       追加模式下输出与输入可以是同一文件；页数达到
+   *       ParallelWatermark::kPageThreshold时自动拆分页面范围并发处理
+   */
+  int process(const QString& inFile, const QString& outFile);
+
+  /**
+   * @brief 为内存中的PDF添加水印
+   * @param pdfData 输入PDF文件内容
+   * @return 加水印后的PDF文件内容，失败返回空数组
+   * @note 输入通过PVF交给PDFlib，输出写入内存，用于在连续处理的各步骤
+   *       之间传递数据；总是按重建方式处理，不做分页并行
+   */
+  QByteArray processBuffer(const QByteArray& pdfData);
+
+  /**
+   * @brief 为输入文档的一个页面范围加水印，结果保存在内存中
+   * @param inFile 输入PDF文件路径
+   * @param first 起始页（从1开始）
+   * @param last 结束页（包含）
+   * @return 只包含这些页面的PDF数据，失败返回空数组
+   */
+  QByteArray renderRange(const QString& inFile, int first, int last);
+
+  /**
+   * @brief 生成指定页面尺寸的单页水印PDF
+   * @param width 页面宽度（点）
+   * @param height 页面高度（点）
+   * @return 单页PDF数据，失败返回空数组
+   * @note 结果按尺寸缓存，参数变化前在多个文档之间复用
+   */
+  QByteArray stampPage(double width, double height);
+
+  /**
+   * @brief 把输入文档解析一次并常驻在会话中
+   * @param inFile 输入PDF文件路径（仅用于日志）
+   * @param data 输入PDF的完整内容，常驻期间调用方需保证其有效
+   * @return 成功返回true
+   * @note PVF和PDI文档句柄在对象作用域中打开，之后每次processResident()
+   *       只打开页面、生成新的水印模板并写出，不再解析输入；适用于同一文档
+   *       按不同水印文本输出多份的场景，见personalize.h
+   */
+  bool openResident(const QString& inFile, const QByteArray& data);
+
+  /**
+   * @brief 把常驻文档加上当前参数的水印写出
+   * @param outFile 输出PDF文件路径
+   * @return 处理结果，0表示成功，2表示失败
+   */
+  int processResident(const QString& outFile);
+
+  /**
+   * @brief 关闭常驻文档并释放对应的虚拟文件
+   */
+  void closeResident();
+
+  /**
+   * @brief 获取当前工作线程专属的会话
+   * @param params 水印参数，与会话现有参数不同时自动更新
+   * @return 当前线程的会话对象，随线程结束而销毁
+   */
+  static WatermarkSession& forCurrentThread(const WatermarkParams& params);
+
+  /**
+   * @brief 按字体名称加载水印字体
+   * @param p PDFlib对象
+   * @param font 字体名称，NSimSun对应simsun.ttc，其余对应"字体名.ttf"
+   * @return 字体句柄，失败返回-1
+   */
+  static int loadFont(pdflib::PDFlib& p, const std::wstring& font);
+
+ private:
+  bool ensureReady();
+  void buildOptionLists();
+  void buildTemplate();
+  void buildTileTemplate();
+  void placeTiles(double width, double height);
+  int writeDocument(const std::wstring& outfile, int indoc, int first, int last);
+  void reset();
+
+  WatermarkParams m_params;
+  std::unique_ptr<pdflib::PDFlib> m_pdf;
+  int m_font = -1;                ///< 已加载字体句柄，-1表示尚未加载
+  std::wstring m_fontName;        ///< 已加载字体对应的名称
+  std::wstring m_text;            ///< 预转换的水印文本
+  std::wstring m_templateOptions; ///< begin_template_ext选项（无锚点时）
+  std::vector<std::wstring> m_anchorOptions;  ///< 每个锚点的begin_template_ext选项
+  std::wstring m_textOptions;     ///< fit_textline选项
+  std::wstring m_tileTextOptions; ///< 平铺模板中fit_textline的选项
+  int m_residentDoc = -1;         ///< 常驻的PDI文档句柄，-1表示没有
+  int m_residentPageCount = 0;    ///< 常驻文档的页数
+  std::wstring m_residentPvf;     ///< 常驻文档对应的PVF虚拟文件名
+  int m_tile = -1;                ///< 当前文档的平铺模板句柄
+  std::map<std::pair<int, int>, QByteArray> m_stamps;  ///< 追加模式的水印页缓存
+  std::map<std::pair<int, int>, std::vector<QRectF>> m_grids;  ///< 按页面尺寸缓存的平铺网格
+};
+
+#endif  // WATERMARKSESSION_H
@@ -28,6 +28,8 @@ class watermarkThreadSingle : public QObject, public QRunnable {
   void setFont(QString font);
   void setFontsize(QString fontsize);
   void setRotate(QString rotate);
+  void setAppendMode(bool append);
+  void setTileGrid(int columns, int rows);
 
   void run() override;
   QMutex *m_mutex;
@@ -40,6 +42,8 @@ class watermarkThreadSingle : public QObject, public QRunnable {
 
  private:
   int m_num;
+  bool m_append = false;
+  int m_tileColumns = 0, m_tileRows = 0;
   QString m_text = "联通数字科技有限公司总部投标专用文档", m_opacity = "15%",
           m_color = "gray", m_font = "simkai", m_fontsize, m_rotate = "45",
           m_input, m_output;
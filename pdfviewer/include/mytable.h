@@ -296,8 +296,9 @@ class mytable : public QTableWidget {
       // 创建两个lineedit用于保存 开始、结束页码
       QLineEdit *leStart = new QLineEdit("1");
       QLabel *label = new QLabel("-");
-      QLineEdit *leEnd =
-          new QLineEdit(QString::number(getPages(fileName.toStdString())));
+      // 页数只读取一次，校验页码时复用
+      QString page = QString::number(getPages(fileName.toStdString()));
+      QLineEdit *leEnd = new QLineEdit(page);
       leStart->setFixedWidth(30);
       label->setFixedWidth(10);
       leEnd->setFixedWidth(30);
@@ -316,7 +317,6 @@ class mytable : public QTableWidget {
           QMessageBox::information(nullptr, "提示信息！", "必须是大于0的数字");
         }
         if (start.toInt() > end.toInt()) {
-          QString page = QString::number(getPages(fileName.toStdString()));
           leStart->setText("1");
           leEnd->setText(page);
           QMessageBox::information(nullptr, "提示信息！",
@@ -335,7 +335,6 @@ class mytable : public QTableWidget {
           QMessageBox::information(nullptr, "提示信息！", "必须是大于0的数字");
         }
         if (start.toInt() > end.toInt()) {
-          QString page = QString::number(getPages(fileName.toStdString()));
           leEnd->setText(page);
           leStart->setText("1");
           QMessageBox::information(nullptr, "提示信息！",
@@ -346,8 +345,7 @@ class mytable : public QTableWidget {
       QTableWidgetItem *itemFile = new QTableWidgetItem(fileName);
       // 设置不可编辑
       itemFile->setFlags(itemFile->flags() & ~Qt::ItemIsEditable);
-      QTableWidgetItem *itemPages = new QTableWidgetItem(
-          QString::number(getPages(fileName.toStdString())));
+      QTableWidgetItem *itemPages = new QTableWidgetItem(page);
       itemPages->setFlags(itemPages->flags() & ~Qt::ItemIsEditable);
 
       this->setItem(rowCount, 0, itemFile);
@@ -0,0 +1,87 @@
+/**
+ * @file image2pdfThread.h
+ * @brief 批量图片转PDF线程类头文件
+ * @author PDF工具集项目组
+ * @date 2024
+ *
+ * 在线程池中执行批量图片转PDF，界面线程只负责显示进度。
+ * 实际转换由ImageBatch完成：每个图片单独输出，或合并为一个多页PDF。
+ */
+
+#ifndef IMAGE2PDFTHREAD_H
+#define IMAGE2PDFTHREAD_H
+
+#include <QObject>
+#include <QRunnable>
+#include <QStringList>
+
+/**
+ * @class image2pdfThread
+ * @brief 批量图片转PDF线程类
+ *
+ * 继承自QObject和QRunnable，在线程池中运行，
+ * 通过信号报告进度和完成情况。
+ */
+class image2pdfThread : public QObject, public QRunnable {
+  Q_OBJECT
+ public:
+  /**
+   * @brief 构造函数
+   * @param parent 父对象指针
+   */
+  explicit image2pdfThread(QObject* parent = nullptr);
+
+  /**
+   * @brief 设置待转换的图片列表
+   * @param images 图片文件路径列表，合并模式下按此顺序排列页面
+   */
+  void setImages(const QStringList& images);
+
+  /**
+   * @brief 设置合并输出的PDF文件
+   * @param targetFile 目标PDF路径，为空时每个图片单独输出为"图片路径.pdf"
+   */
+  void setTargetFile(const QString& targetFile);
+
+  /**
+   * @brief 设置工作线程数
+   * @param workers 工作线程数，0表示使用CPU核心数
+   */
+  void setWorkers(int workers);
+
+  /**
+   * @brief 设置分辨率上限
+   * @param maxDpi 图片在页面上的分辨率上限，0表示按原始像素嵌入
+   */
+  void setMaxDpi(int maxDpi);
+
+  /**
+   * @brief 线程主执行函数
+   */
+  void run() override;
+
+ signals:
+  /**
+   * @brief 进度信号
+   * @param done 已完成的图片数
+   * @param total 图片总数
+   * @note 完成百分比变化时才发出，避免大批量时信号过多
+   */
+  void progress(int done, int total);
+
+  /**
+   * @brief 处理完成信号
+   * @param succeeded 成功转换的图片数（合并模式下成功为总数，失败为0）
+   * @param total 图片总数
+   * @param summary 嵌入方式统计摘要，如"预计直通 118 转码 2 降采样 0 失败 0 跳过 0"
+   */
+  void addFinish(int succeeded, int total, const QString& summary);
+
+ private:
+  QStringList m_images;
+  QString m_targetFile;
+  int m_workers = 0;
+  int m_maxDpi = 0;
+};
+
+#endif  // IMAGE2PDFTHREAD_H
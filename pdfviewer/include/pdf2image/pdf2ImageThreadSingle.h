@@ -27,6 +27,8 @@
 #include <QVector>        // Qt动态数组
 
 #include "qthreadpool.h"  // Qt线程池
+#include "include/function/FlattenPipeline.h"  // 扁平化编码选项
+#include "include/function/MemoryBudget.h"  // 内存预算
 using namespace std;
 
 /**
@@ -68,6 +70,7 @@ class pdf2imageThreadSingle : public QObject, public QRunnable {
   /**
    * @brief 设置输出图片路径
    * @param imagePath 图片输出目录路径
+   * @note 仅PDF转图片模式使用，PDF→图片→PDF模式不需要图片目录
    */
   void setImagePath(QString imagePath);
   
@@ -103,6 +106,38 @@ class pdf2imageThreadSingle : public QObject, public QRunnable {
    * 控制转换方向：true为图片转PDF模式，false为PDF转图片模式。
    */
   void setIs2pdf(bool is2pdf);
+
+  /**
+   * @brief 设置单个文档的渲染线程数
+   * @param workers 渲染线程数，0表示使用CPU核心数
+   * 
+   * 同一文档的各页在多个线程上并行渲染，结果仍按页码顺序输出。
+   */
+  void setWorkers(int workers);
+
+  /**
+   * @brief 设置扁平化使用的内存预算
+   * @param budget 内存预算，nullptr表示不限制
+   * 
+   * 默认使用MemoryBudget::shared()，同时处理的所有文件共用一个字节上限。
+   */
+  void setMemoryBudget(MemoryBudget* budget);
+
+  /**
+   * @brief 设置扁平化输出的图片编码
+   * @param encoding 编码选项
+   * 
+   * 默认按页检测：黑白页面用CCITT G4，灰度页面用8位Flate，彩色页面用JPEG。
+   */
+  void setEncoding(const FlattenPipeline::Encoding& encoding);
+
+  /**
+   * @brief 设置扁平化的条带高度
+   * @param bandHeight 条带高度（像素），0表示整页，小于0表示自动（默认）
+   * 
+   * 分条带时每个渲染线程的内存与条带大小成正比，可以同时运行更多线程。
+   */
+  void setBandHeight(int bandHeight);
   
   /**
    * @brief 线程主执行函数
@@ -138,6 +173,26 @@ class pdf2imageThreadSingle : public QObject, public QRunnable {
    * 默认值为true（图片转PDF）。
    */
   bool m_is2pdf = true;
+
+  /**
+   * @brief 单个文档的渲染线程数，0表示使用CPU核心数
+   */
+  int m_workers = 0;
+
+  /**
+   * @brief 扁平化使用的内存预算
+   */
+  MemoryBudget* m_budget = MemoryBudget::shared();
+
+  /**
+   * @brief 扁平化输出的图片编码
+   */
+  FlattenPipeline::Encoding m_encoding;
+
+  /**
+   * @brief 扁平化的条带高度，小于0表示自动
+   */
+  int m_bandHeight = -1;
   
   /**
    * @brief 文件路径变量
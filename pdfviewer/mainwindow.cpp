@@ -28,8 +28,10 @@
 #include <QPdfDocument>
 #include <QPdfPageNavigation>
 #include <QProgressDialog>
+#include <QSharedPointer>
 #include <QStandardItemModel>
 #include <QTableWidget>
+#include <QThread>
 #include <QtConcurrent/QtConcurrent>
 #include <QtMath>
 #include <QtSvg/QSvgGenerator>
@@ -38,6 +40,7 @@
 #include "function.h"
 #include "include/QProgressIndicator.h"
 #include "include/mark/mark.h"
+#include "include/mark/personalize.h"
 #include "mainwindow.h"
 #include "pageselector.h"
 #include "qColordialog.h"
@@ -564,9 +567,6 @@ void MainWindow::viewWatermark() {
         ui->cBoxFont->currentText(), ui->lineEdit_fs->text().toInt(),
         ui->lineEditColor->text(), ui->lineEditRotate->text().toDouble(),
         ui->lineEditOpacity->text().toDouble() / 100);
-    //由于多行文本用create_annotation处理，在预览中不显示，所以做转换处理
-    pdf2image("doc/2.pdf", "doc/", 72);
-    image2pdf("doc/0.png", "doc/2.pdf");
   } else {
     //单上文本处理
     addWatermark("doc/1.pdf", "doc/2.pdf", text, opacity, color, "-" + rotate,
@@ -631,6 +631,10 @@ void MainWindow::addWatermarkSingle(QString text, QString inputDir,
         wmThreadSinge->setFontsize(fontSize);
         wmThreadSinge->setInputFilename(file);
         wmThreadSinge->setOutputFilename(outfile);
+        wmThreadSinge->setAppendMode(ui->checkBoxAppend->isChecked());
+        // "平铺 列×行"，第一项"单个水印"解析为0×0
+        QStringList grid = ui->cBoxTile->currentText().section(' ', 1).split("×");
+        wmThreadSinge->setTileGrid(grid.value(0).toInt(), grid.value(1).toInt());
         threadPool.start(wmThreadSinge);
       }
     }
@@ -644,6 +648,95 @@ void MainWindow::addWatermarkSingle(QString text, QString inputDir,
   }
 }
 
+/**
+ * @brief 按名单生成按钮点击事件
+ *
+ * 选择一个PDF文件和收件人CSV，按当前的颜色、透明度、角度和字体
+ * 为每个收件人输出一份带各自水印文本的文件，保存在输出目录的_out_中；
+ * 生成过程在线程池中进行，进度显示在进度对话框中
+ */
+void MainWindow::on_btnPersonalize_clicked() {
+  QString outputDir = ui->lineEditOutput->text();
+  if (outputDir.isEmpty() || !QFileInfo(outputDir).isDir()) {
+    QMessageBox::information(nullptr, "提示", "输入目录或者选择正确目录");
+    ui->lineEditOutput->setFocus();
+    return;
+  }
+  QString inFile = QFileDialog::getOpenFileName(
+      this, "选择PDF文件", ui->lineEditInput->text(), "PDF文件 (*.pdf *.PDF)");
+  if (inFile.isEmpty()) {
+    return;
+  }
+  QString csvFile = QFileDialog::getOpenFileName(
+      this, "选择收件人名单", QFileInfo(inFile).absolutePath(),
+      "CSV文件 (*.csv *.txt)");
+  if (csvFile.isEmpty()) {
+    return;
+  }
+
+  QString outDir = outputDir + "/_out_";
+  QDir().mkpath(outDir);
+  QList<Recipient> recipients = readRecipients(csvFile, inFile, outDir);
+  if (recipients.isEmpty()) {
+    QMessageBox::information(nullptr, "提示！", "收件人名单为空");
+    return;
+  }
+
+  QString font;
+  switch (ui->cBoxFont->currentIndex()) {
+    case 0:
+      font = "NSimSun";
+      break;
+    case 1:
+      font = "simkai";
+      break;
+    case 2:
+      font = "simfang";
+      break;
+    case 3:
+      font = "simhei";
+      break;
+    default:
+      font = "simkai";
+  }
+  WatermarkParams params;
+  params.opacity = ui->lineEditOpacity->text() + "%";
+  params.color = ui->lineEditColor->text();
+  params.rotate = "-" + ui->lineEditRotate->text();
+  params.font = font;
+
+  QElapsedTimer time;
+  time.start();
+  QSharedPointer<QMap<QString, int>> results(new QMap<QString, int>());
+  QFutureWatcher<void> *watcher = new QFutureWatcher<void>(this);
+  connect(watcher, &QFutureWatcher<void>::finished, this, [=]() {
+    emit this->Finished();
+    int succeeded = 0;
+    for (int r : *results) {
+      if (r == 0) {
+        succeeded++;
+      }
+    }
+    ui->textEditLog->append("按名单生成用时:" +
+                            QString::number(time.elapsed()) +
+                            "毫秒,结果文件保存在:" + outDir + "/");
+    QMessageBox::information(nullptr, "提示！",
+                             "按名单生成完成！<br>共" +
+                                 QString::number(recipients.size()) +
+                                 "份，<br>成功" + QString::number(succeeded) +
+                                 "份");
+    watcher->deleteLater();
+  });
+  watcher->setFuture(QtConcurrent::run(&threadPool, [=]() {
+    personalize(inFile, recipients, params, results.data(),
+                [this](int done, int total) {
+                  emit this->Progress(
+                      QString("正在生成：%1/%2").arg(done).arg(total));
+                });
+  }));
+  qprogresssindicat();
+}
+
 /**
  * @brief 导出PDF按钮点击事件处理函数
  * 
@@ -694,22 +787,18 @@ void MainWindow::exportPdf(QDir pdfdir) {
   // 初始化原子计数器和总文件数
   m_completedCount.storeRelaxed(0);
   m_totalFiles = files.length();
-  
-  // 保存原始目录路径，避免在lambda中被修改
-  QString originalPdfDirPath = pdfdir.path();
+  // 文件之间已经并行，按同时处理的文件数分摊每个文档的渲染线程
+  int workers = qMax(1, QThread::idealThreadCount() /
+                            qMin(m_totalFiles, threadPool.maxThreadCount()));
   
   for (const QString &originalFile : files) {  // 使用const引用，按值遍历
     // 使用局部变量替代成员变量，避免竞态条件
     auto* thread = new pdf2imageThreadSingle();
     // 正确处理文件路径，避免修改原始字符串
     QString file = originalFile;  // 创建副本
-    //将pdf源文件的全路径中的_out_更换为__image__，并作为保存源文件转换为图片的目录
-    QString imagePath = QString(file).replace("_out_", "_image_");
-    //创建保存图片文件目录
-    createDirectory(imagePath);
-    //ui->textEditLog->append("imagePath:"   + imagePath);
-    //将图片文件的全路径中的_image_更换为__pdf__
-    QString pdfPath = QString(imagePath).replace("_image_", "_pdf_");
+    //将pdf源文件的全路径中的_out_更换为_pdf_，作为目标pdf文件路径
+    //页面图片只在内存中传递，不再创建_image_图片目录
+    QString pdfPath = QString(file).replace("_out_", "_pdf_");
     //提取目录作为保存目标pdf文件的目录
     QFileInfo fileInfo(pdfPath);
     QString path = fileInfo.absolutePath();
@@ -719,15 +808,20 @@ void MainWindow::exportPdf(QDir pdfdir) {
     
     // 设置线程参数
     thread->setSourceFile(file);
-    thread->setImagePath(imagePath);
     thread->setTargetFile(path + "/" + filename);
     thread->setIs2pdf(true);
     thread->setResolution(ui->cBoxResolution->currentText().toInt());
+    thread->setWorkers(workers);
+    FlattenPipeline::Encoding encoding =
+        FlattenPipeline::parseEncoding(ui->cBoxCodec->currentText());
+    // "300 DPI"这类选项取数字作为分辨率上限，"原始"为0即与渲染分辨率相同
+    encoding.maxDpi = ui->cBoxExportDpi->currentText().section(' ', 0, 0).toInt();
+    thread->setEncoding(encoding);
     //ui->textEditLog->append("分辨率:"   + ui->cBoxResolution->currentText());
 
     // 使用原子计数器管理完成状态，避免多次触发完成逻辑
     connect(thread, &pdf2imageThreadSingle::addFinish, this, 
-        [this, originalPdfDirPath]() {
+        [this]() {
             int completed = m_completedCount.fetchAndAddRelaxed(1) + 1;
             if (completed == m_totalFiles) {
                 // 只在最后一个线程完成时执行完成逻辑
@@ -737,15 +831,6 @@ void MainWindow::exportPdf(QDir pdfdir) {
                                        "导出PDF完成！<br>共" +
                                            QString::number(m_totalFiles) +
                                            "个文件参与处理");
-                
-                // 获取图片根目录，转换工作完成后删除之
-                QDir imageRootDir(QString(originalPdfDirPath).replace("_out_", "_image_"));
-                bool success = imageRootDir.removeRecursively();
-                if (success) {
-                    ui->textEditLog->append("图片目录：" + imageRootDir.path() + "删除成功.");
-                } else {
-                    ui->textEditLog->append("图片目录：" + imageRootDir.path() + "删除失败");
-                }
             }
         });
 
@@ -840,11 +925,47 @@ void MainWindow::on_btnTransformBat_clicked() {
   QDir dir(ui->lineEditImageDir->text());
   QStringList files;
   tDirectory(dir, files, {"png", "jpg", "bmp"});
-  for (QString &file : files) {
-    image2pdf(file.toStdString(), (file + ".pdf").toStdString());
+  if (files.isEmpty()) {
+    QMessageBox::information(nullptr, "提示信息！", "目录中没有图像文件");
+    return;
+  }
+  // 合并时按文件名排序作为页面顺序，输出为"目录/目录名.pdf"
+  QString target;
+  if (ui->checkBoxCombine->isChecked()) {
+    files.sort();
+    target = dir.filePath(dir.dirName() + ".pdf");
   }
-  QMessageBox::information(nullptr, "PDF转换完成！", "PDF保存在图片源目录中");
-  ui->textEditLog->append("PDF保存源目录中:" + ui->lineEditImageDir->text());
+  image2pdfThread *thread = new image2pdfThread();
+  thread->setImages(files);
+  thread->setTargetFile(target);
+  thread->setWorkers(0);
+  // "300 DPI"这类选项取数字作为分辨率上限，"原始分辨率"为0即不限制
+  thread->setMaxDpi(ui->cBoxMaxDpi->currentText().section(' ', 0, 0).toInt());
+  connect(thread, &image2pdfThread::progress, this, [=](int done, int total) {
+    emit this->Progress(QString("正在转换：%1/%2").arg(done).arg(total));
+  });
+  connect(thread, &image2pdfThread::addFinish, this,
+          [=](int succeeded, int total, const QString &summary) {
+            emit this->Finished();
+            ui->textEditLog->append("图片嵌入方式：" + summary);
+            if (target.isEmpty()) {
+              ui->textEditLog->append(
+                  QString("PDF保存源目录中:%1，成功%2个，失败%3个")
+                      .arg(ui->lineEditImageDir->text())
+                      .arg(succeeded)
+                      .arg(total - succeeded));
+              QMessageBox::information(nullptr, "PDF转换完成！",
+                                       "PDF保存在图片源目录中");
+            } else if (succeeded == total) {
+              ui->textEditLog->append("PDF转换完成保存在：" + target);
+              QMessageBox::information(nullptr, "PDF转换完成！",
+                                       "PDF保存在：" + target);
+            } else {
+              QMessageBox::information(nullptr, "提示信息！", "合并图片失败");
+            }
+          });
+  threadPool.start(thread);
+  qprogresssindicat();
 }
 
 /**
@@ -898,6 +1019,8 @@ void MainWindow::on_btnPdfToImage_clicked() {
   }
   pdf2imageThread->setImagePath(path);
   pdf2imageThread->setResolution(100);
+  // 单个文档转换，所有CPU核心参与渲染
+  pdf2imageThread->setWorkers(0);
   //为每个线程连接一个信号，用于监测线程池的线程工作完成情况，建议Qthreadpoll增加一个finish信号。
   connect(pdf2imageThread, &pdf2imageThreadSingle::addFinish, this, [=]() {
     // 判断线程池中的活动线程数，如果为0则认为所有工作线程结束。
@@ -932,6 +1055,8 @@ void MainWindow::qprogresssindicat() {
   hLayout->setMargin(1);           // 与窗体边无距离 尽量占满
   hLayout->addWidget(pIndicator);  // 加入控件
   hLayout->addWidget(l1);
+  // 长时间任务通过Progress信号更新提示文字
+  QObject::connect(this, &MainWindow::Progress, l1, &QLabel::setText);
   hLayout->setAlignment(pIndicator, Qt::AlignCenter);  // 控件居中
   hLayout->setAlignment(l1, Qt::AlignCenter);          // 控件居中
   // ui->tab_2->setLayout(hLayout);
@@ -954,10 +1079,9 @@ void MainWindow::on_btnSelectFilesplit_clicked() {
     if (err != QPdfDocument::NoError) {
       QMessageBox::information(nullptr, "警告！", "请选择正确的pdf文件");
     } else {
-      ui->lineEditSplitpages->setText(
-          QString::number(getPages(fileName.toStdString())));
-      ui->lineEditSplitEnd->setText(
-          QString::number(getPages(fileName.toStdString())));
+      QString pages = QString::number(getPages(fileName.toStdString()));
+      ui->lineEditSplitpages->setText(pages);
+      ui->lineEditSplitEnd->setText(pages);
       QFileInfo path(fileName);
       ui->lineEditSplitOutput->setText(path.absolutePath());
     }
@@ -976,10 +1100,9 @@ void MainWindow::on_lineEditInputFilesplit_textChanged(
       QMessageBox::information(nullptr, "警告！", "目标文件错误");
 
     } else {
-      ui->lineEditSplitpages->setText(
-          QString::number(getPages(filename.toStdString())));
-      ui->lineEditSplitEnd->setText(
-          QString::number(getPages(filename.toStdString())));
+      QString pages = QString::number(getPages(filename.toStdString()));
+      ui->lineEditSplitpages->setText(pages);
+      ui->lineEditSplitEnd->setText(pages);
       QFileInfo path(filename);
       ui->lineEditSplitOutput->setText(path.absolutePath());
     }
@@ -1045,52 +1168,19 @@ void MainWindow::on_btnSplitPdf_clicked() {
   //通过radiobutton来选择两种拆分方式
   if (ui->radioButtonSpliterange->isChecked()) {
     //第一种拆分方式：从原始文件中提取区间页数为新文件
-    QString range, sub_range;
-    QStringList parts, sub_parts;
-    int start = 0, end = 0;
-    range = ui->lineEditSplitscope->text();
-    // 通过正则表达式来验证拆分规则的有效性
-    QRegularExpression regex("^\\d+-\\d+(,\\d+-\\d+)*$");
-    QRegularExpressionMatch match = regex.match(range);
-    if (match.hasMatch()) {
-      if (regex.match(range).hasMatch()) {
-        parts = range.split(",");
-        for (int i = 0; i < parts.size(); ++i) {
-          sub_range = parts.at(i);
-          sub_parts = sub_range.split("-");
-          start = sub_parts[0].toInt() - 1;
-          end = sub_parts[1].toInt();
-          qDebug() << "start:" << start;
-          qDebug() << "end:" << end;
-          if (end > pages) {
-            QMessageBox::information(nullptr, "警告！",
-                                     "拆分范围不能大于文档总页数");
-            return;
-          }
-          if (start > end) {
-            QMessageBox::information(nullptr, "警告！",
-                                     "拆分范围开始值不能大于结束值");
-            return;
-          }
-        }
-      }
-    } else {
-      QMessageBox::information(nullptr, "警告！",
-                               "目前只支持n-n,n-n...格式的拆分");
+    // 支持单页、n-m、n-（到末页）以及odd/even，每一项生成一个文件
+    QList<PdfOperations::SplitSection> sections;
+    QString error;
+    if (!PdfOperations::parseSplitSpec(ui->lineEditSplitscope->text(), pages,
+                                       &sections, &error)) {
+      QMessageBox::information(nullptr, "警告！", error);
       return;
     }
-
-    if (regex.match(range).hasMatch()) {
-      parts = range.split(",");
-      for (int i = 0; i < parts.size(); ++i) {
-        sub_range = parts.at(i);
-        sub_parts = sub_range.split("-");
-        start = sub_parts[0].toInt() - 1;
-        end = sub_parts[1].toInt();
-        string sub_out = out + "_" + sub_parts[0].toStdString() + "-" +
-                         sub_parts[1].toStdString();
-        splitPdf(in, sub_out, start, end);
-      }
+    // 输入文件只打开一次，所有范围依次写出
+    if (PdfOperations::splitPdf(QString::fromStdString(in),
+                                QString::fromStdString(out), sections) != 0) {
+      ui->textEditLog->append("部分范围拆分失败：" +
+                              ui->lineEditInputFilesplit->text());
     }
 
     QMessageBox::information(
@@ -1102,8 +1192,8 @@ void MainWindow::on_btnSplitPdf_clicked() {
 
   } else {
     /*第二种拆分方式：
-    先按照拆分范围生成一个临时文件保存在临时文件夹
-    再将临时文件按照规则拆分成多个文件
+    从原文件的拆分范围内按每个文件的页数分块，
+    各分块文件在线程池中并行写出
     */
     int start = ui->lineEditSplitStart->text().toInt() - 1;
     int end = ui->lineEditSplitEnd->text().toInt();
@@ -1116,18 +1206,15 @@ void MainWindow::on_btnSplitPdf_clicked() {
                                "拆分范围开始值不能大于结束值");
       return;
     }
-    QString tempDir =
-        QStandardPaths::writableLocation(QStandardPaths::TempLocation);
-    // 第一次拆分生成中间结果文件
-    splitPdf(in, tempDir.toStdString() + "/" + filename, start, end);
     // 每个拆分子文件的页数
     int subPages = ui->lineEditSubPages->text().toInt();
-    // 第二次拆分
-    splitPdf(tempDir.toStdString() + "/" + filename + "_split.pdf", out,
-             subPages);
-    QFile tempfile(tempDir + "/" + QString::fromStdString(filename) +
-                   "_split.pdf");
-    tempfile.remove();
+    // 直接从原文件按范围分块并行写出，不再生成中间文件
+    if (PdfOperations::splitPdfChunks(QString::fromStdString(in),
+                                      QString::fromStdString(out), subPages,
+                                      start, end) != 0) {
+      ui->textEditLog->append("PDF拆分失败：" +
+                              ui->lineEditInputFilesplit->text());
+    }
     QMessageBox::information(
         nullptr, "PDF拆分完成！",
         "文件保存在保存：" + ui->lineEditSplitOutput->text());
@@ -1191,12 +1278,10 @@ void MainWindow::on_btnSelectMergeDir_clicked() {
  * @note 合并顺序按照表格中文件的显示顺序
  */
 void MainWindow::on_btnMerge_clicked() {
-  // 临时文件列表
-  std::list<std::string> fileList;
+  // 各行的文件和页面范围，合并时直接从原文件导入
+  QList<PdfOperations::MergeSource> sources;
   QString outDir = ui->lineEditOutMerge->text();
   QString outfileName = ui->lineEditMergeOutFile->text();
-  // 合并前的临时文件目录
-  QString tempFile = outDir + "/" + "YXNkZmRzZmFzZGZhZHNmYWRzZgo";
   if (outfileName == "") {
     QMessageBox::information(nullptr, "提示信息！", "请输入合并后的文件名");
     ui->lineEditMergeOutFile->setFocus();
@@ -1211,8 +1296,7 @@ void MainWindow::on_btnMerge_clicked() {
   if (outfileName.right(4).toUpper() != ".PDF") {
     outfileName = outfileName + ".pdf";
   }
-  // 创建临时目录
-  if (!createDirectory(tempFile)) {
+  if (!QFileInfo(outDir).isDir()) {
     QMessageBox::information(nullptr, "提示信息！", "请选择正确的输出目录");
     ui->lineEditOutMerge->setFocus();
     return;
@@ -1234,18 +1318,19 @@ void MainWindow::on_btnMerge_clicked() {
     QList<QLineEdit *> currLine = currenCell->findChildren<QLineEdit *>();
     pStart = currLine[0]->text().toInt();
     pEnd = currLine[1]->text().toInt();
-    // 按行拆到临时文件
-    if (splitPdf(infilename.toStdString(),
-                 tempFile.toStdString() + "/" + std::to_string(row), pStart - 1,
-                 pEnd) == 0) {
-      //临时文件放到列表中
-      fileList.push_back(tempFile.toStdString() + "/" + std::to_string(row) +
-                         "_split.pdf");
-    }
+    PdfOperations::PageRange range;
+    range.start = pStart - 1;
+    range.end = pEnd;
+    PdfOperations::MergeSource source;
+    source.file = infilename;
+    source.ranges.append(range);
+    source.bookmark = infilename;
+    sources.append(source);
   }
   outfileName = outDir + "/" + outfileName;
-  // 将临时文件列表中的文件进行合并
-  if (mergePdf(fileList, outfileName.toStdString()) == 0) {
+  // 各行页面从原文件导入，一次写出；各文件中相同的信头图片、字体只保留一份
+  if (PdfOperations::mergePdf(sources, outfileName,
+                              PdfOperations::CopyBackend::Graft) == 0) {
     QFileInfo info(outfileName);
     QPdfDocument::DocumentError err;
 
@@ -1255,9 +1340,6 @@ void MainWindow::on_btnMerge_clicked() {
     ui->textEditLog->append("PDF合并完成保存在：" + info.filePath());
     QMessageBox::information(nullptr, "PDF合并完成！",
                              "文件保存在：" + info.filePath() + "\n");
-    QDir temp(tempFile);
-    // 删除整个目录及其子目录
-    temp.removeRecursively();
   }
 }
 
@@ -11,6 +11,7 @@
 #include "include/mark/multiWatermarkThreadSingle.h "
 #include "include/mark/watermarkThread.h"
 #include "include/mark/watermarkThreadSingle.h"
+#include "include/pdf2image/image2pdfThread.h"
 #include "include/pdf2image/pdf2ImageThreadSingle.h"
 #include "include/search/SearchThread.h"
 #include <QMetaType>
@@ -73,6 +74,7 @@ class MainWindow : public QMainWindow {
   void on_btnSelectOutput_clicked();
 
   void on_btnExportPDF_clicked();
+  void on_btnPersonalize_clicked();
   void on_cBoxFont_currentIndexChanged();
 
   void on_btnSelectImageFile_clicked();
@@ -129,6 +131,7 @@ class MainWindow : public QMainWindow {
 
 signals:
   void Finished();
+  void Progress(const QString &text);
 
  private:
   Ui::MainWindow *ui;
@@ -183,6 +183,8 @@ void MainWindow::connectUIToControllers()
     // 水印功能
     connect(ui->btnAddWater, &QPushButton::clicked,
             m_watermarkController, &WatermarkController::onBtnAddWaterClicked);
+    connect(ui->btnPersonalize, &QPushButton::clicked,
+            m_watermarkController, &WatermarkController::onBtnPersonalizeClicked);
     connect(ui->btnColorSelect, &QPushButton::clicked,
             m_watermarkController, &WatermarkController::onBtnColorSelectClicked);
     connect(ui->cBoxFont, SIGNAL(currentIndexChanged(int)),
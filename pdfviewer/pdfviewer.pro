@@ -6,7 +6,7 @@ QMAKE_CXXFLAGS += /utf-8
 CONFIG += utf8_source
 
 
-QT += core gui widgets pdfwidgets printsupport svg
+QT += core gui widgets pdfwidgets printsupport svg concurrent
 QMAKE_CXXFLAGS_RELEASE += -O2       #开启深度优化O3
 QMAKE_GENERATOR = ninja
 SOURCES += \
@@ -14,13 +14,25 @@ SOURCES += \
     main.cpp \
     mainwindow.cpp \
     pageselector.cpp \
+    src/function/DisplayListCache.cpp \
     src/function/FileDetector.cpp \
     src/function/FormatConverter.cpp \
     src/function/FileSystemUtils.cpp \
+    src/function/FlattenPipeline.cpp \
     src/function/GeometryUtils.cpp \
+    src/function/GraftAnnotations.cpp \
+    src/function/GraftCopy.cpp \
+    src/function/ImageBatch.cpp \
+    src/function/ImageResample.cpp \
+    src/function/MemoryBudget.cpp \
+    src/function/PageRasterizer.cpp \
+    src/function/ParallelWatermark.cpp \
     src/function/PdfOperations.cpp \
+    src/function/RasterAnalysis.cpp \
+    src/function/ResultCache.cpp \
     src/QProgressIndicator.cpp \
     src/function/StringConverter.cpp \
+    src/function/TextMetrics.cpp \
     src/function/WatermarkProcessor.cpp \
     src/controllers/ExcelSearchController.cpp \
     src/controllers/PdfConverterController.cpp \
@@ -35,10 +47,14 @@ SOURCES += \
     src/function/StringConverter.cpp \
     src/function/WatermarkProcessor.cpp \
     src/lineedit/CustomLineEdit.cpp \
+    src/mark/incrementalStamp.cpp \
     src/mark/multiWatermarkThreadSingle.cpp \
+    src/mark/personalize.cpp \
     src/mark/watermarkThread.cpp \
+    src/mark/watermarkSession.cpp \
     src/mark/watermarkThreadSingle.cpp \
     src/mark/wmark.cpp \
+    src/pdf2image/image2pdfThread.cpp \
     src/pdf2image/pdf2ImageThreadSingle.cpp \
     src/search/SearchThread.cpp \
     src/slider/CustomSlider.cpp \
@@ -55,19 +71,36 @@ HEADERS += \
     include/QProgressIndicator.h \
     include/StringConverter.h \
     include/WatermarkProcessor.h \
+    include/function/BoundedQueue.h \
+    include/function/DisplayListCache.h \
     include/function/FileDetector.h \
     include/function/FileSystemUtils.h \
+    include/function/FlattenPipeline.h \
     include/function/FormatConverter.h \
     include/function/GeometryUtils.h \
+    include/function/GraftAnnotations.h \
+    include/function/GraftCopy.h \
+    include/function/ImageBatch.h \
+    include/function/ImageResample.h \
+    include/function/MemoryBudget.h \
+    include/function/PageRasterizer.h \
+    include/function/ParallelWatermark.h \
     include/function/PdfOperations.h \
+    include/function/RasterAnalysis.h \
+    include/function/ResultCache.h \
     include/function/StringConverter.h \
+    include/function/TextMetrics.h \
     include/function/WatermarkProcessor.h \
     include/lineedit/CustomLineEdit.h \
+    include/mark/incrementalStamp.h \
     include/mark/mark.h \
     include/mark/multiWatermarkThreadSingle.h \
+    include/mark/personalize.h \
     include/mark/watermarkThread.h \
+    include/mark/watermarkSession.h \
     include/mark/watermarkThreadSingle.h \
     include/mytable.h \
+    include/pdf2image/image2pdfThread.h \
     include/pdf2image/pdf2ImageThreadSingle.h \
     include/search/SearchThread.h \
     include/slider/CustomSlider.h \
@@ -151,18 +184,6 @@ else:win32:!win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += $$PWD/lib/
 
 
 
-win32:CONFIG(release, debug|release): LIBS += -L$$PWD/lib/libxml2/lib/release/ -llibxml2
-else:win32:CONFIG(debug, debug|release): LIBS += -L$$PWD/lib/libxml2/lib/debug/ -llibxml2d
-
-INCLUDEPATH += $$PWD/lib/libxml2/include/libxml2
-DEPENDPATH += $$PWD/lib/libxml2/include/libxml2
-
-win32:CONFIG(release, debug|release): LIBS += -L$$PWD/lib/iconv/lib/release/ -llibiconv
-else:win32:CONFIG(debug, debug|release): LIBS += -L$$PWD/lib/iconv/lib/debug/ -llibiconv
-
-INCLUDEPATH += $$PWD/lib/iconv/include
-DEPENDPATH += $$PWD/lib/iconv/include
-
 
 
 win32:CONFIG(release, debug|release): LIBS += -L$$PWD/lib/qtxlsx/lib/release/ -lQt5Xlsx
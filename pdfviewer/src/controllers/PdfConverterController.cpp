@@ -5,6 +5,7 @@
 
 #include "PdfConverterController.h"
 #include "ui_mainwindow.h"
+#include "../../include/pdf2image/image2pdfThread.h"
 #include "../../include/pdf2image/pdf2ImageThreadSingle.h"
 #include "../../include/QProgressIndicator.h"
 #include <QFileDialog>
@@ -15,6 +16,7 @@
 #include <QLabel>
 #include <QStandardPaths>
 #include <QPdfDocument>
+#include <QThread>
 
 /**
  * @brief 构造函数
@@ -146,13 +148,47 @@ void PdfConverterController::onBtnTransformBatClicked()
     QDir dir(m_ui->lineEditImageDir->text());
     QStringList files;
     tDirectory(dir, files, {"png", "jpg", "bmp"});
+    if (files.isEmpty()) {
+        QMessageBox::information(nullptr, "提示信息！", "目录中没有图像文件");
+        return;
+    }
     
-    for (QString &file : files) {
-        image2pdf(file.toStdString(), (file + ".pdf").toStdString());
+    // 合并时按文件名排序作为页面顺序，输出为"目录/目录名.pdf"
+    QString target;
+    if (m_ui->checkBoxCombine->isChecked()) {
+        files.sort();
+        target = dir.filePath(dir.dirName() + ".pdf");
     }
     
-    QMessageBox::information(nullptr, "PDF转换完成！", "PDF保存在图片源目录中");
-    emit logMessage("PDF保存源目录中:" + m_ui->lineEditImageDir->text());
+    image2pdfThread *thread = new image2pdfThread();
+    thread->setImages(files);
+    thread->setTargetFile(target);
+    thread->setWorkers(0);
+    // "300 DPI"这类选项取数字作为分辨率上限，"原始分辨率"为0即不限制
+    thread->setMaxDpi(m_ui->cBoxMaxDpi->currentText().section(' ', 0, 0).toInt());
+    
+    connect(thread, &image2pdfThread::progress, this, [this](int done, int total) {
+        emit Progress(QString("正在转换：%1/%2").arg(done).arg(total));
+    });
+    connect(thread, &image2pdfThread::addFinish, this, [this, target](int succeeded, int total, const QString &summary) {
+        emit Finished();
+        emit logMessage("图片嵌入方式：" + summary);
+        if (target.isEmpty()) {
+            emit logMessage(QString("PDF保存源目录中:%1，成功%2个，失败%3个")
+                                .arg(m_ui->lineEditImageDir->text())
+                                .arg(succeeded)
+                                .arg(total - succeeded));
+            QMessageBox::information(nullptr, "PDF转换完成！", "PDF保存在图片源目录中");
+        } else if (succeeded == total) {
+            emit logMessage("PDF转换完成保存在：" + target);
+            QMessageBox::information(nullptr, "PDF转换完成！", "PDF保存在：" + target);
+        } else {
+            QMessageBox::information(nullptr, "提示信息！", "合并图片失败");
+        }
+    });
+    
+    m_threadPool.start(thread);
+    showProgressIndicator();
 }
 
 /**
@@ -194,6 +230,8 @@ void PdfConverterController::onBtnPdfToImageClicked()
     
     m_pdf2imageThread->setImagePath(path);
     m_pdf2imageThread->setResolution(100);
+    // 单个文档转换，所有CPU核心参与渲染
+    m_pdf2imageThread->setWorkers(0);
     
     // 连接完成信号
     connect(m_pdf2imageThread, &pdf2imageThreadSingle::addFinish, this, [this, path]() {
@@ -253,18 +291,16 @@ void PdfConverterController::exportPdf(QDir pdfdir)
     // 初始化计数器
     m_completedCount.storeRelaxed(0);
     m_totalFiles = files.length();
-    
-    QString originalPdfDirPath = pdfdir.path();
+    // 文件之间已经并行，按同时处理的文件数分摊每个文档的渲染线程
+    int workers = qMax(1, QThread::idealThreadCount() /
+                              qMin(m_totalFiles, m_threadPool.maxThreadCount()));
     
     for (const QString &originalFile : files) {
         auto* thread = new pdf2imageThreadSingle();
         QString file = originalFile;
         
-        // 设置转换路径
-        QString imagePath = QString(file).replace("_out_", "_image_");
-        createDirectory(imagePath);
-        
-        QString pdfPath = QString(imagePath).replace("_image_", "_pdf_");
+        // 设置转换路径，页面图片只在内存中传递，不再创建_image_图片目录
+        QString pdfPath = QString(file).replace("_out_", "_pdf_");
         QFileInfo fileInfo(pdfPath);
         QString path = fileInfo.absolutePath();
         QString filename = fileInfo.fileName();
@@ -272,14 +308,19 @@ void PdfConverterController::exportPdf(QDir pdfdir)
         
         // 设置线程参数
         thread->setSourceFile(file);
-        thread->setImagePath(imagePath);
         thread->setTargetFile(path + "/" + filename);
         thread->setIs2pdf(true);
         thread->setResolution(m_ui->cBoxResolution->currentText().toInt());
+        thread->setWorkers(workers);
+        FlattenPipeline::Encoding encoding =
+            FlattenPipeline::parseEncoding(m_ui->cBoxCodec->currentText());
+        // "300 DPI"这类选项取数字作为分辨率上限，"原始"为0即与渲染分辨率相同
+        encoding.maxDpi = m_ui->cBoxExportDpi->currentText().section(' ', 0, 0).toInt();
+        thread->setEncoding(encoding);
         
         // 连接完成信号
         connect(thread, &pdf2imageThreadSingle::addFinish, this, 
-            [this, originalPdfDirPath]() {
+            [this]() {
                 int completed = m_completedCount.fetchAndAddRelaxed(1) + 1;
                 if (completed == m_totalFiles) {
                     emit Finished();
@@ -287,15 +328,6 @@ void PdfConverterController::exportPdf(QDir pdfdir)
                     QMessageBox::information(nullptr, "导出PDF完成！",
                                            QString("导出PDF完成！<br>共%1个文件参与处理")
                                            .arg(m_totalFiles));
-                    
-                    // 删除临时图片目录
-                    QDir imageRootDir(QString(originalPdfDirPath).replace("_out_", "_image_"));
-                    bool success = imageRootDir.removeRecursively();
-                    if (success) {
-                        emit logMessage("图片目录：" + imageRootDir.path() + "删除成功.");
-                    } else {
-                        emit logMessage("图片目录：" + imageRootDir.path() + "删除失败");
-                    }
                 }
             });
         
@@ -328,6 +360,8 @@ void PdfConverterController::showProgressIndicator()
     hLayout->setMargin(1);
     hLayout->addWidget(pIndicator);
     hLayout->addWidget(l1);
+    // 长时间任务通过Progress信号更新提示文字
+    QObject::connect(this, &PdfConverterController::Progress, l1, &QLabel::setText);
     hLayout->setAlignment(pIndicator, Qt::AlignCenter);
     hLayout->setAlignment(l1, Qt::AlignCenter);
     dialog.setLayout(hLayout);
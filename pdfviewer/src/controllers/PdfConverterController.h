@@ -101,6 +101,12 @@ signals:
      */
     void Finished();
     
+    /**
+     * @brief 进度文字更新信号
+     * @param text 显示在进度对话框中的文字
+     */
+    void Progress(const QString &text);
+    
     /**
      * @brief 请求打开PDF文件信号
      * @param url 文件URL
@@ -199,37 +199,17 @@ void PdfSplitMergeController::performRangeSplit(const std::string &input,
                                                const std::string &output,
                                                int pages, const QString &range)
 {
-    QString sub_range;
-    QStringList parts, sub_parts;
-    int start = 0, end = 0;
-    
-    // 通过正则表达式来验证拆分规则的有效性
-    QRegularExpression regex("^\\d+-\\d+(,\\d+-\\d+)*$");
-    QRegularExpressionMatch match = regex.match(range);
-    
-    if (match.hasMatch()) {
-        parts = range.split(",");
-        for (int i = 0; i < parts.size(); ++i) {
-            sub_range = parts.at(i);
-            sub_parts = sub_range.split("-");
-            start = sub_parts[0].toInt() - 1;
-            end = sub_parts[1].toInt();
-            
-            if (end > pages) {
-                QMessageBox::information(nullptr, "警告！", "拆分范围不能大于文档总页数");
-                return;
-            }
-            if (start > end) {
-                QMessageBox::information(nullptr, "警告！", "拆分范围开始值不能大于结束值");
-                return;
-            }
-            
-            std::string sub_out = output + "_" + sub_parts[0].toStdString() + "-" +
-                                 sub_parts[1].toStdString();
-            splitPdf(input, sub_out, start, end);
-        }
-    } else {
-        QMessageBox::information(nullptr, "警告！", "目前只支持n-n,n-n...格式的拆分");
+    // 支持单页、n-m、n-（到末页）以及odd/even，每一项生成一个文件
+    QList<PdfOperations::SplitSection> sections;
+    QString error;
+    if (!PdfOperations::parseSplitSpec(range, pages, &sections, &error)) {
+        QMessageBox::information(nullptr, "警告！", error);
+        return;
+    }
+
+    // 输入文件只打开一次，所有范围依次写出
+    if (PdfOperations::splitPdf(QString::fromStdString(input), QString::fromStdString(output), sections) != 0) {
+        emit logMessage("部分范围拆分失败：" + QString::fromStdString(input));
     }
 }
 
@@ -251,21 +231,14 @@ void PdfSplitMergeController::performPageSplit(const std::string &input,
         return;
     }
     
-    QString tempDir = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
-    QFileInfo file(QString::fromStdString(input));
-    std::string filename = file.fileName().left(file.fileName().length() - 4).toStdString();
-    
-    // 第一次拆分生成中间结果文件
-    splitPdf(input, tempDir.toStdString() + "/" + filename, start, end);
-    
     // 每个拆分子文件的页数
     int subPages = m_ui->lineEditSubPages->text().toInt();
     
-    // 第二次拆分
-    splitPdf(tempDir.toStdString() + "/" + filename + "_split.pdf", output, subPages);
-    
-    QFile tempfile(tempDir + "/" + QString::fromStdString(filename) + "_split.pdf");
-    tempfile.remove();
+    // 直接从原文件按范围分块并行写出，不再生成中间文件
+    if (PdfOperations::splitPdfChunks(QString::fromStdString(input), QString::fromStdString(output),
+                                      subPages, start, end) != 0) {
+        emit logMessage("PDF拆分失败：" + QString::fromStdString(input));
+    }
 }
 
 /**
@@ -330,20 +303,16 @@ void PdfSplitMergeController::onBtnMergeClicked()
         return;
     }
     
-    // 临时文件列表
-    std::list<std::string> fileList;
+    // 各行的文件和页面范围，合并时直接从原文件导入
+    QList<PdfOperations::MergeSource> sources;
     QString outDir = m_ui->lineEditOutMerge->text();
     QString outfileName = m_ui->lineEditMergeOutFile->text();
     
-    // 合并前的临时文件目录
-    QString tempFile = outDir + "/" + "YXNkZmRzZmFzZGZhZHNmYWRzZgo";
-    
     if (outfileName.right(4).toUpper() != ".PDF") {
         outfileName = outfileName + ".pdf";
     }
     
-    // 创建临时目录
-    if (!createDirectory(tempFile)) {
+    if (!QFileInfo(outDir).isDir()) {
         QMessageBox::information(nullptr, "提示信息！", "请选择正确的输出目录");
         m_ui->lineEditOutMerge->setFocus();
         return;
@@ -366,18 +335,20 @@ void PdfSplitMergeController::onBtnMergeClicked()
         pStart = currLine[0]->text().toInt();
         pEnd = currLine[1]->text().toInt();
         
-        // 按行拆到临时文件
-        if (splitPdf(infilename.toStdString(),
-                    tempFile.toStdString() + "/" + std::to_string(row), pStart - 1, pEnd) == 0) {
-            // 临时文件放到列表中
-            fileList.push_back(tempFile.toStdString() + "/" + std::to_string(row) + "_split.pdf");
-        }
+        PdfOperations::PageRange range;
+        range.start = pStart - 1;
+        range.end = pEnd;
+        PdfOperations::MergeSource source;
+        source.file = infilename;
+        source.ranges.append(range);
+        source.bookmark = infilename;
+        sources.append(source);
     }
     
     outfileName = outDir + "/" + outfileName;
     
-    // 将临时文件列表中的文件进行合并
-    if (mergePdf(fileList, outfileName.toStdString()) == 0) {
+    // 各行页面从原文件导入，一次写出；各文件中相同的信头图片、字体只保留一份
+    if (PdfOperations::mergePdf(sources, outfileName, PdfOperations::CopyBackend::Graft) == 0) {
         QFileInfo info(outfileName);
         
         // 在预览中打开合并完成的文件
@@ -387,9 +358,5 @@ void PdfSplitMergeController::onBtnMergeClicked()
         
         QMessageBox::information(nullptr, "PDF合并完成！",
                                "文件保存在：" + info.filePath() + "\n");
-        
-        QDir temp(tempFile);
-        // 删除整个目录及其子目录
-        temp.removeRecursively();
     }
 }
\ No newline at end of file
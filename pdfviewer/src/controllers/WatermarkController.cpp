@@ -8,11 +8,21 @@
 #include "../../include/mark/watermarkThreadSingle.h"
 #include "../../include/mark/multiWatermarkThreadSingle.h"
 #include "../../include/mark/mark.h"
+#include "../../include/mark/personalize.h"
 #include "../../include/textedit/CustomTextEdit.h"
+#include "../../include/QProgressIndicator.h"
 #include <QMessageBox>
 #include <QColorDialog>
+#include <QDir>
+#include <QFileDialog>
 #include <QFileInfo>
 #include <QElapsedTimer>
+#include <QDialog>
+#include <QFutureWatcher>
+#include <QLabel>
+#include <QSharedPointer>
+#include <QVBoxLayout>
+#include <QtConcurrent/QtConcurrent>
 
 /**
  * @brief 构造函数
@@ -163,10 +173,6 @@ void WatermarkController::viewWatermark()
             m_ui->cBoxFont->currentText(), m_ui->lineEdit_fs->text().toInt(),
             m_ui->lineEditColor->text(), m_ui->lineEditRotate->text().toDouble(),
             m_ui->lineEditOpacity->text().toDouble() / 100);
-        
-        // 由于多行文本用create_annotation处理，在预览中不显示，所以做转换处理
-        pdf2image("doc/2.pdf", "doc/", 72);
-        image2pdf("doc/0.png", "doc/2.pdf");
     } else {
         // 单行文本处理
         addWatermark("doc/1.pdf", "doc/2.pdf", text, opacity, color, "-" + rotate, font);
@@ -228,6 +234,106 @@ void WatermarkController::onBtnAddWaterClicked()
     emit exportButtonStateChanged(true);
 }
 
+/**
+ * @brief 按名单生成按钮点击处理
+ * @note 生成过程在线程池中进行，进度显示在进度对话框中
+ */
+void WatermarkController::onBtnPersonalizeClicked()
+{
+    QString outputDir = m_ui->lineEditOutput->text();
+    if (outputDir.isEmpty() || !QFileInfo(outputDir).isDir()) {
+        QMessageBox::information(nullptr, "提示", "输入目录或者选择正确目录");
+        m_ui->lineEditOutput->setFocus();
+        return;
+    }
+    QString inFile = QFileDialog::getOpenFileName(
+        nullptr, "选择PDF文件", m_ui->lineEditInput->text(), "PDF文件 (*.pdf *.PDF)");
+    if (inFile.isEmpty()) {
+        return;
+    }
+    QString csvFile = QFileDialog::getOpenFileName(
+        nullptr, "选择收件人名单", QFileInfo(inFile).absolutePath(), "CSV文件 (*.csv *.txt)");
+    if (csvFile.isEmpty()) {
+        return;
+    }
+
+    QString outDir = outputDir + "/_out_";
+    QDir().mkpath(outDir);
+    QList<Recipient> recipients = readRecipients(csvFile, inFile, outDir);
+    if (recipients.isEmpty()) {
+        QMessageBox::information(nullptr, "提示！", "收件人名单为空");
+        return;
+    }
+
+    WatermarkParams params;
+    params.opacity = m_ui->lineEditOpacity->text() + "%";
+    params.color = m_ui->lineEditColor->text();
+    params.rotate = "-" + m_ui->lineEditRotate->text();
+    params.font = getCurrentFont();
+
+    QElapsedTimer time;
+    time.start();
+    QSharedPointer<QMap<QString, int>> results(new QMap<QString, int>());
+    QFutureWatcher<void> *watcher = new QFutureWatcher<void>(this);
+    connect(watcher, &QFutureWatcher<void>::finished, this, [=]() {
+        emit Finished();
+        int succeeded = 0;
+        for (int r : *results) {
+            if (r == 0) {
+                succeeded++;
+            }
+        }
+
+        m_ui->textEditLog->append(QString("按名单生成用时:%1毫秒,结果文件保存在:%2/")
+                                  .arg(time.elapsed()).arg(outDir));
+        QString message = QString("按名单生成完成！<br>共%1份，<br>成功%2份")
+                          .arg(recipients.size())
+                          .arg(succeeded);
+        QMessageBox::information(nullptr, "提示！", message);
+        emit watermarkCompleted(message);
+        watcher->deleteLater();
+    });
+    watcher->setFuture(QtConcurrent::run(&m_threadPool, [=]() {
+        personalize(inFile, recipients, params, results.data(),
+                    [this](int done, int total) {
+                        emit Progress(QString("正在生成：%1/%2").arg(done).arg(total));
+                    });
+    }));
+    showProgressIndicator();
+}
+
+/**
+ * @brief 显示进度指示器
+ */
+void WatermarkController::showProgressIndicator()
+{
+    QProgressIndicator *pIndicator = nullptr;
+    QDialog dialog;
+
+    QObject::connect(this, &WatermarkController::Finished, &dialog, &QDialog::close);
+
+    dialog.setWindowTitle("文件转换处理...");
+    dialog.resize(200, 20);
+    dialog.setWindowFlags(dialog.windowFlags() | Qt::FramelessWindowHint);
+
+    pIndicator = new QProgressIndicator(&dialog);
+    QVBoxLayout *hLayout = new QVBoxLayout(&dialog);
+    QLabel *l1 = new QLabel("正在生成。。。。");
+
+    hLayout->setMargin(1);
+    hLayout->addWidget(pIndicator);
+    hLayout->addWidget(l1);
+    // 长时间任务通过Progress信号更新提示文字
+    QObject::connect(this, &WatermarkController::Progress, l1, &QLabel::setText);
+    hLayout->setAlignment(pIndicator, Qt::AlignCenter);
+    hLayout->setAlignment(l1, Qt::AlignCenter);
+    dialog.setLayout(hLayout);
+
+    pIndicator->setColor(QColor(12, 52, 255));
+    pIndicator->startAnimation();
+    dialog.exec();
+}
+
 /**
  * @brief 颜色选择按钮点击处理
  */
@@ -307,6 +413,10 @@ void WatermarkController::addWatermarkSingle(QString text, QString inputDir,
             m_wmThreadSingle->setFontsize(fontSize);
             m_wmThreadSingle->setInputFilename(file);
             m_wmThreadSingle->setOutputFilename(outfile);
+            m_wmThreadSingle->setAppendMode(m_ui->checkBoxAppend->isChecked());
+            // "平铺 列×行"，第一项"单个水印"解析为0×0
+            QStringList grid = m_ui->cBoxTile->currentText().section(' ', 1).split("×");
+            m_wmThreadSingle->setTileGrid(grid.value(0).toInt(), grid.value(1).toInt());
             m_threadPool.start(m_wmThreadSingle);
         }
     }
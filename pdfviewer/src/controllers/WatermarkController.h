@@ -65,6 +65,13 @@ public slots:
      * 批量为PDF文件添加水印
      */
     void onBtnAddWaterClicked();
+
+    /**
+     * @brief 按名单生成按钮点击处理
+     * 
+     * 为一个PDF按收件人CSV各生成一份带不同水印文本的文件
+     */
+    void onBtnPersonalizeClicked();
     
     /**
      * @brief 颜色选择按钮点击处理
@@ -119,6 +126,17 @@ signals:
      */
     void exportButtonStateChanged(bool enabled);
 
+    /**
+     * @brief 后台任务完成信号，用于关闭进度对话框
+     */
+    void Finished();
+
+    /**
+     * @brief 进度文字更新信号
+     * @param text 显示在进度对话框中的文字
+     */
+    void Progress(const QString &text);
+
 private:
     /**
      * @brief 验证水印输入参数
@@ -132,6 +150,11 @@ private:
      */
     QString getCurrentFont() const;
 
+    /**
+     * @brief 显示进度指示器，收到Finished信号后关闭
+     */
+    void showProgressIndicator();
+
     /**
      * @brief 连接信号槽
      */
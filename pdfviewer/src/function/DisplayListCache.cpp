@@ -0,0 +1,457 @@
+/**
+ * @file DisplayListCache.cpp
+ * @brief 页面显示列表缓存实现
+ *
+ * 基础上下文使用带计数的内存分配器，按线程统计净分配字节数，
+ * 据此估算每个文档和显示列表的内存占用。缓存结构由m_mutex保护，
+ * 同一文档的页面解析由文档自己的互斥锁串行化，渲染不需要任何锁。
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma execution_character_set("utf-8") // 设置编译器使用UTF-8字符集
+#include "include/function/DisplayListCache.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+/**
+ * @brief MuPDF全局锁，fz_locks_context回调按编号加锁
+ */
+QMutex g_fzLocks[FZ_LOCK_MAX];
+
+void lockMutex(void* user, int lock) {
+    static_cast<QMutex*>(user)[lock].lock();
+}
+
+void unlockMutex(void* user, int lock) {
+    static_cast<QMutex*>(user)[lock].unlock();
+}
+
+/**
+ * @brief 当前线程通过MuPDF分配的净字节数
+ */
+thread_local qint64 t_allocated = 0;
+
+/**
+ * @brief 分配块头部大小，保存块长度并保持16字节对齐
+ */
+const size_t kHeader = 16;
+
+void* countingMalloc(void*, size_t size) {
+    unsigned char* block = static_cast<unsigned char*>(std::malloc(size + kHeader));
+    if (!block) {
+        return nullptr;
+    }
+    *reinterpret_cast<size_t*>(block) = size;
+    t_allocated += (qint64)size;
+    return block + kHeader;
+}
+
+void* countingRealloc(void* user, void* old, size_t size) {
+    if (!old) {
+        return countingMalloc(user, size);
+    }
+    unsigned char* block = static_cast<unsigned char*>(old) - kHeader;
+    size_t oldSize = *reinterpret_cast<size_t*>(block);
+    block = static_cast<unsigned char*>(std::realloc(block, size + kHeader));
+    if (!block) {
+        return nullptr;
+    }
+    *reinterpret_cast<size_t*>(block) = size;
+    t_allocated += (qint64)size - (qint64)oldSize;
+    return block + kHeader;
+}
+
+void countingFree(void*, void* ptr) {
+    if (!ptr) {
+        return;
+    }
+    unsigned char* block = static_cast<unsigned char*>(ptr) - kHeader;
+    t_allocated -= (qint64) * reinterpret_cast<size_t*>(block);
+    std::free(block);
+}
+
+/**
+ * @brief 估算条目占用时的下限，避免期间释放其他对象导致计数为负或为零
+ */
+const qint64 kMinEntryBytes = 4096;
+
+} // namespace
+
+/**
+ * @brief 已打开的文档
+ */
+struct DisplayListCache::Document {
+    QMutex mutex;               ///< 串行化页面解析，MuPDF文档对象不可并发访问
+    QByteArray data;            ///< 文件内容，文档通过内存流打开
+    fz_document* doc = nullptr;
+    QString key;                ///< "绝对路径|修改时间|文件大小"
+    int pages = 0;
+    qint64 bytes = 0;
+    quint64 stamp = 0;          ///< 最近使用时刻，用于LRU淘汰
+    int users = 0;              ///< 正在使用的调用数，大于0时不淘汰
+    bool stale = false;         ///< 文件已改写，最后一个使用者释放时关闭
+};
+
+/**
+ * @brief 一个页面的显示列表
+ */
+struct DisplayListCache::Entry {
+    fz_display_list* list = nullptr;
+    fz_rect bounds;
+    qint64 bytes = 0;
+    quint64 stamp = 0;
+};
+
+/**
+ * @brief 获取进程共享的缓存实例
+ */
+DisplayListCache* DisplayListCache::instance() {
+    static DisplayListCache cache;
+    return &cache;
+}
+
+DisplayListCache::DisplayListCache() {
+    fz_alloc_context alloc;
+    alloc.user = nullptr;
+    alloc.malloc = countingMalloc;
+    alloc.realloc = countingRealloc;
+    alloc.free = countingFree;
+
+    fz_locks_context locks;
+    locks.user = g_fzLocks;
+    locks.lock = lockMutex;
+    locks.unlock = unlockMutex;
+
+    m_base = fz_new_context(&alloc, &locks, FZ_STORE_DEFAULT);
+    if (!m_base) {
+        qDebug() << "创建MuPDF上下文失败";
+        return;
+    }
+    fz_try(m_base) { fz_register_document_handlers(m_base); }
+    fz_catch(m_base) {
+        qDebug() << "注册文档处理器失败：" << fz_caught_message(m_base);
+    }
+}
+
+DisplayListCache::~DisplayListCache() {
+    if (!m_base) {
+        return;
+    }
+    for (Entry* entry : m_entries) {
+        fz_drop_display_list(m_base, entry->list);
+        delete entry;
+    }
+    for (Document* doc : m_documents) {
+        dropDocument(m_base, doc);
+    }
+    fz_drop_context(m_base);
+}
+
+/**
+ * @brief 为调用线程创建上下文
+ * @return 克隆的上下文，失败返回nullptr
+ *
+ * 基础上下文本身不用于任何操作，只作为克隆的来源，
+ * 因此可以在任意线程中同时调用。
+ */
+fz_context* DisplayListCache::newContext() {
+    return m_base ? fz_clone_context(m_base) : nullptr;
+}
+
+/**
+ * @brief 获取PDF文件页数
+ * @return 页数，文件无法打开时返回-1
+ */
+int DisplayListCache::pageCount(fz_context* ctx, const QString& pdfFile) {
+    Document* doc = acquireDocument(ctx, pdfFile);
+    if (!doc) {
+        return -1;
+    }
+    int pages = doc->pages;
+    releaseDocument(ctx, doc);
+    return pages;
+}
+
+/**
+ * @brief 获取页面的显示列表
+ * @return 已增加引用的显示列表，失败返回nullptr
+ *
+ * 未命中时在文档锁内解析页面，解析期间不持有缓存锁，
+ * 其他文档和已缓存页面的访问不受影响。两个线程同时解析同一页时，
+ * 后完成的一方改用先入缓存的结果。
+ */
+fz_display_list* DisplayListCache::displayList(fz_context* ctx, const QString& pdfFile,
+                                               int page, fz_rect* bounds) {
+    Document* doc = acquireDocument(ctx, pdfFile);
+    if (!doc) {
+        return nullptr;
+    }
+    const QString key = doc->key + QLatin1Char('|') + QString::number(page);
+
+    m_mutex.lock();
+    Entry* entry = m_entries.value(key);
+    if (entry) {
+        entry->stamp = ++m_clock;
+        *bounds = entry->bounds;
+        fz_display_list* list = fz_keep_display_list(ctx, entry->list);
+        m_mutex.unlock();
+        releaseDocument(ctx, doc);
+        return list;
+    }
+    m_mutex.unlock();
+
+    fz_page* fzPage = nullptr;
+    fz_display_list* list = nullptr;
+    fz_rect pageBounds = fz_empty_rect;
+    qint64 before = t_allocated;
+    fz_var(fzPage);
+    fz_var(list);
+
+    doc->mutex.lock();
+    fz_try(ctx) {
+        fzPage = fz_load_page(ctx, doc->doc, page);
+        pageBounds = fz_bound_page(ctx, fzPage);
+        list = fz_new_display_list_from_page(ctx, fzPage);
+    }
+    fz_always(ctx) { fz_drop_page(ctx, fzPage); }
+    fz_catch(ctx) {
+        qDebug() << "解析页面失败：" << pdfFile << page << fz_caught_message(ctx);
+        list = nullptr;
+    }
+    doc->mutex.unlock();
+
+    if (list) {
+        qint64 bytes = std::max(t_allocated - before, kMinEntryBytes);
+        m_mutex.lock();
+        entry = m_entries.value(key);
+        if (entry) {
+            fz_drop_display_list(ctx, list);
+            list = fz_keep_display_list(ctx, entry->list);
+            pageBounds = entry->bounds;
+            entry->stamp = ++m_clock;
+        } else {
+            entry = new Entry;
+            entry->list = fz_keep_display_list(ctx, list);
+            entry->bounds = pageBounds;
+            entry->bytes = bytes;
+            entry->stamp = ++m_clock;
+            m_entries.insert(key, entry);
+            m_used += bytes;
+            evict(ctx);
+        }
+        m_mutex.unlock();
+        *bounds = pageBounds;
+    }
+    releaseDocument(ctx, doc);
+    return list;
+}
+
+/**
+ * @brief 设置缓存预算
+ */
+void DisplayListCache::setBudget(qint64 bytes) {
+    fz_context* ctx = newContext();
+    if (!ctx) {
+        return;
+    }
+    m_mutex.lock();
+    m_budget = std::max<qint64>(bytes, 0);
+    evict(ctx);
+    m_mutex.unlock();
+    fz_drop_context(ctx);
+}
+
+/**
+ * @brief 当前缓存占用（字节，估算值）
+ */
+qint64 DisplayListCache::used() const {
+    QMutexLocker locker(&m_mutex);
+    return m_used;
+}
+
+/**
+ * @brief 清空缓存，正在使用的文档在使用结束后关闭
+ */
+void DisplayListCache::clear() {
+    fz_context* ctx = newContext();
+    if (!ctx) {
+        return;
+    }
+    m_mutex.lock();
+    qint64 budget = m_budget;
+    m_budget = 0;
+    evict(ctx);
+    m_budget = budget;
+    m_mutex.unlock();
+    fz_drop_context(ctx);
+}
+
+/**
+ * @brief 取得文件对应的文档并登记使用
+ * @return 文档，文件无法打开时返回nullptr
+ *
+ * 文件修改时间或大小变化后，旧文档和它的全部显示列表立即移出缓存。
+ * 文件内容整体读入内存后打开，缓存不持有文件句柄。
+ */
+DisplayListCache::Document* DisplayListCache::acquireDocument(fz_context* ctx,
+                                                              const QString& pdfFile) {
+    QFileInfo info(pdfFile);
+    if (!info.isFile()) {
+        qDebug() << "文件不存在：" << pdfFile;
+        return nullptr;
+    }
+    const QString path = info.absoluteFilePath();
+    const QString key = path + QLatin1Char('|') +
+                        QString::number(info.lastModified().toMSecsSinceEpoch()) +
+                        QLatin1Char('|') + QString::number(info.size());
+
+    m_mutex.lock();
+    Document* doc = m_documents.value(path);
+    if (doc && doc->key == key) {
+        doc->users++;
+        doc->stamp = ++m_clock;
+        m_mutex.unlock();
+        return doc;
+    }
+    if (doc) {
+        const QString prefix = doc->key + QLatin1Char('|');
+        for (auto it = m_entries.begin(); it != m_entries.end();) {
+            if (it.key().startsWith(prefix)) {
+                m_used -= it.value()->bytes;
+                fz_drop_display_list(ctx, it.value()->list);
+                delete it.value();
+                it = m_entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        m_documents.remove(path);
+        m_used -= doc->bytes;
+        if (doc->users > 0) {
+            doc->stale = true;
+        } else {
+            dropDocument(ctx, doc);
+        }
+    }
+    m_mutex.unlock();
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "打开文件失败：" << pdfFile;
+        return nullptr;
+    }
+    doc = new Document;
+    doc->data = file.readAll();
+    file.close();
+    doc->key = key;
+
+    fz_stream* stm = nullptr;
+    qint64 before = t_allocated;
+    bool ok = true;
+    fz_var(stm);
+    fz_try(ctx) {
+        stm = fz_open_memory(ctx, (const unsigned char*)doc->data.constData(),
+                             doc->data.size());
+        doc->doc = fz_open_document_with_stream(ctx, "application/pdf", stm);
+        doc->pages = fz_count_pages(ctx, doc->doc);
+    }
+    fz_always(ctx) { fz_drop_stream(ctx, stm); }
+    fz_catch(ctx) {
+        qDebug() << "文件处理错误：" << pdfFile << fz_caught_message(ctx);
+        ok = false;
+    }
+    if (!ok) {
+        dropDocument(ctx, doc);
+        return nullptr;
+    }
+    doc->bytes = doc->data.size() + std::max<qint64>(t_allocated - before, 0);
+
+    m_mutex.lock();
+    Document* other = m_documents.value(path);
+    if (other && other->key == key) {
+        // 其他线程已先打开同一文件
+        other->users++;
+        other->stamp = ++m_clock;
+        m_mutex.unlock();
+        dropDocument(ctx, doc);
+        return other;
+    }
+    doc->users = 1;
+    doc->stamp = ++m_clock;
+    m_documents.insert(path, doc);
+    m_used += doc->bytes;
+    evict(ctx);
+    m_mutex.unlock();
+    return doc;
+}
+
+/**
+ * @brief 结束对文档的使用
+ */
+void DisplayListCache::releaseDocument(fz_context* ctx, Document* doc) {
+    m_mutex.lock();
+    doc->users--;
+    bool drop = doc->stale && doc->users == 0;
+    if (!drop) {
+        evict(ctx);
+    }
+    m_mutex.unlock();
+    if (drop) {
+        dropDocument(ctx, doc);
+    }
+}
+
+/**
+ * @brief 关闭文档并释放其内存
+ */
+void DisplayListCache::dropDocument(fz_context* ctx, Document* doc) {
+    fz_drop_document(ctx, doc->doc);
+    delete doc;
+}
+
+/**
+ * @brief 按LRU淘汰条目直到占用不超过预算，调用方需持有m_mutex
+ *
+ * 缓存条目数通常只有几百到几千，直接线性查找最久未使用的条目。
+ * 正在使用的文档不淘汰；已交给调用方的显示列表由引用计数保持有效。
+ */
+void DisplayListCache::evict(fz_context* ctx) {
+    while (m_used > m_budget) {
+        QString oldestEntry;
+        QString oldestDocument;
+        quint64 oldest = ~0ULL;
+        for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+            if (it.value()->stamp < oldest) {
+                oldest = it.value()->stamp;
+                oldestEntry = it.key();
+            }
+        }
+        for (auto it = m_documents.cbegin(); it != m_documents.cend(); ++it) {
+            if (it.value()->users == 0 && it.value()->stamp < oldest) {
+                oldest = it.value()->stamp;
+                oldestDocument = it.key();
+            }
+        }
+        if (!oldestDocument.isEmpty()) {
+            Document* doc = m_documents.take(oldestDocument);
+            m_used -= doc->bytes;
+            dropDocument(ctx, doc);
+        } else if (!oldestEntry.isEmpty()) {
+            Entry* entry = m_entries.take(oldestEntry);
+            m_used -= entry->bytes;
+            fz_drop_display_list(ctx, entry->list);
+            delete entry;
+        } else {
+            break;
+        }
+    }
+}
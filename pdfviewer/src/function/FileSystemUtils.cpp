@@ -11,6 +11,8 @@
 
 #pragma execution_character_set("utf-8") // 设置编译器使用UTF-8字符集
 #include "include/function/FileSystemUtils.h"
+#include <QFile>
+#include <QSaveFile>
 
 namespace FileSystemUtils {
 
@@ -165,4 +167,34 @@ bool createDirectory(const QString& path) {
     }
 }
 
+/**
+ * @brief 读取整个文件到内存
+ * @param path 文件路径
+ * @return 文件内容，读取失败返回空数组
+ */
+QByteArray readFileBytes(const QString& path) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Failed to read file: " << path;
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+/**
+ * @brief 把内存数据写入文件（覆盖）
+ * @param path 文件路径
+ * @param data 文件内容
+ * @return true表示写入成功
+ */
+bool writeFileBytes(const QString& path, const QByteArray& data) {
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size()) {
+        qWarning() << "Failed to write file: " << path;
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
 } // namespace FileSystemUtils
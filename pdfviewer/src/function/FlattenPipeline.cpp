@@ -0,0 +1,718 @@
+/**
+ * @file FlattenPipeline.cpp
+ * @brief 扁平化流水线模块实现
+ *
+ * 预算按数据的实际持有方计量：渲染前由PageRasterizer申请整页（或条带）像素，
+ * 复制到渲染队列时记入副本，压缩完成后换成压缩数据的大小，
+ * 条带按顺序到达写入阶段时立即写成图片对象并归还，不等同页的其余条带。
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma execution_character_set("utf-8") // 设置编译器使用UTF-8字符集
+#include "include/function/FlattenPipeline.h"
+
+#include <QAtomicInt>
+#include <QBuffer>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+#include <functional>
+
+#include "include/function/BoundedQueue.h"
+#include "include/function/ImageResample.h"
+#include "include/function/PageRasterizer.h"
+#include "include/function/RasterAnalysis.h"
+#include "mupdf/fitz.h"
+#include "mupdf/pdf.h"
+
+namespace FlattenPipeline {
+
+namespace {
+
+/**
+ * @brief 页面图片数据的编码格式
+ */
+enum class Format {
+    Raw,    ///< 未压缩的RGB像素（渲染阶段输出）
+    Flate,  ///< FlateDecode
+    Dct,    ///< DCTDecode（JPEG）
+    Fax     ///< CCITTFaxDecode（G4）
+};
+
+/**
+ * @brief 条带数据，渲染阶段输出未压缩的像素，压缩阶段输出编码后的数据
+ *
+ * 不分条带时一页就是一个条带。
+ */
+struct PageData {
+    int seq = 0;         ///< 渲染输出顺序，写入阶段按它重新排序
+    int page = 0;
+    int band = 0;        ///< 条带在页内的序号
+    int bands = 1;       ///< 页内条带总数
+    int top = 0;         ///< 条带首行在整页中的像素行号
+    int rows = 0;        ///< 条带在整页中占的像素行数，缩小后height变小但占位不变
+    int pageRows = 0;    ///< 整页像素行数
+    int width = 0;
+    int height = 0;
+    int components = 3;  ///< 颜色分量数，1为灰度，3为RGB
+    int bpc = 8;         ///< 每分量位数
+    bool pageColor = true;  ///< 整页是否含彩色内容（分条带时由渲染阶段检测）
+    Format format = Format::Raw;
+    fz_rect bounds;
+    QByteArray data;
+};
+
+/**
+ * @brief 写入中的页面
+ *
+ * 条带到达时即作为图片对象写入文档，这里只记录引用和位置，
+ * 最后一个条带到达后生成页面内容流和页面对象。
+ */
+struct PageWriter {
+    QList<pdf_obj*> images;  ///< 已写入的条带图片对象，按从上到下顺序
+    QList<int> tops;         ///< 各条带首行在整页中的像素行号
+    QList<int> rows;         ///< 各条带在整页中占的像素行数
+};
+
+/**
+ * @brief 在预算上记账的辅助函数，budget为nullptr时不做任何事
+ */
+void charge(MemoryBudget* budget, qint64 bytes) {
+    if (budget) {
+        budget->charge(bytes);
+    }
+}
+
+void release(MemoryBudget* budget, qint64 bytes) {
+    if (budget) {
+        budget->release(bytes);
+    }
+}
+
+/**
+ * @brief 对像素数据做Flate压缩
+ * @return 压缩后的数据，失败时返回空数组
+ */
+QByteArray deflate(fz_context* ctx, const QByteArray& samples) {
+    QByteArray out;
+    fz_try(ctx) {
+        size_t len = fz_deflate_bound(ctx, samples.size());
+        out.resize((int)len);
+        fz_deflate(ctx, (unsigned char*)out.data(), &len,
+                   (const unsigned char*)samples.constData(), samples.size(),
+                   FZ_DEFLATE_DEFAULT);
+        out.resize((int)len);
+    }
+    fz_catch(ctx) {
+        qDebug() << "压缩页面失败：" << fz_caught_message(ctx);
+        out.clear();
+    }
+    return out;
+}
+
+/**
+ * @brief 对1位黑白数据做CCITT G4编码
+ * @return 编码后的数据，失败时返回空数组
+ */
+QByteArray faxG4(fz_context* ctx, const QByteArray& bits, int width, int height) {
+    QByteArray out;
+    fz_buffer* buf = nullptr;
+    fz_var(buf);
+    fz_try(ctx) {
+        buf = fz_compress_ccitt_fax_g4(ctx, (const unsigned char*)bits.constData(),
+                                       width, height, (width + 7) / 8);
+        unsigned char* data = nullptr;
+        size_t len = fz_buffer_storage(ctx, buf, &data);
+        out = QByteArray((const char*)data, (int)len);
+    }
+    fz_always(ctx) { fz_drop_buffer(ctx, buf); }
+    fz_catch(ctx) {
+        qDebug() << "G4编码失败：" << fz_caught_message(ctx);
+        out.clear();
+    }
+    return out;
+}
+
+/**
+ * @brief 对RGB像素做JPEG编码
+ * @return 编码后的数据，失败时返回空数组
+ */
+QByteArray jpeg(const PageData& raw, int quality) {
+    QImage image((const uchar*)raw.data.constData(), raw.width, raw.height,
+                 raw.width * 3, QImage::Format_RGB888);
+    QByteArray out;
+    QBuffer buffer(&out);
+    buffer.open(QIODevice::WriteOnly);
+    if (!image.save(&buffer, "JPG", quality)) {
+        qDebug() << "JPEG编码失败，第" << raw.page << "页";
+        out.clear();
+    }
+    return out;
+}
+
+/**
+ * @brief 按编码选项编码一页像素数据
+ * @param resolution 渲染分辨率（DPI），用于换算encoding.maxDpi
+ * @param tone 输出实际采用的色调，用于统计
+ * @return 编码后的页面数据，data为空表示编码失败
+ */
+PageData encodePage(fz_context* ctx, const PageData& raw, const Encoding& encoding,
+                    int resolution, RasterAnalysis::Tone* tone) {
+    Codec codec = encoding.codec;
+    if (codec == Codec::Auto && raw.bands > 1) {
+        // 分条带的页面按整页颜色只选一次编码，同一页不会混用G4和JPEG；
+        // 单个条带看不到整页，不做黑白判定，非彩色页面统一用无损灰度
+        codec = raw.pageColor ? Codec::Jpeg : Codec::Gray;
+    } else if (codec == Codec::Auto) {
+        switch (RasterAnalysis::classify((const unsigned char*)raw.data.constData(), raw.width,
+                                         raw.height, raw.width * 3)) {
+        case RasterAnalysis::Tone::Bitonal: codec = Codec::Bitonal; break;
+        case RasterAnalysis::Tone::Gray: codec = Codec::Gray; break;
+        default: codec = Codec::Jpeg; break;
+        }
+    }
+
+    // 黑白页面保持渲染分辨率：G4压缩率高，缩小后再二值化会使文字发虚
+    PageData source = raw;
+    if (codec != Codec::Bitonal && encoding.maxDpi > 0 && encoding.maxDpi < resolution) {
+        int width = 0;
+        int height = 0;
+        ImageResample::scaledSize(raw.width, raw.height, (double)encoding.maxDpi / resolution,
+                                  &width, &height);
+        source.data = ImageResample::downsample((const unsigned char*)raw.data.constData(),
+                                                raw.width, raw.height, raw.width * 3, 3,
+                                                width, height);
+        source.width = width;
+        source.height = height;
+    }
+    const unsigned char* px = (const unsigned char*)source.data.constData();
+    const int stride = source.width * 3;
+
+    PageData packed = source;
+    packed.data.clear();
+    switch (codec) {
+    case Codec::Bitonal:
+        *tone = RasterAnalysis::Tone::Bitonal;
+        packed.components = 1;
+        packed.bpc = 1;
+        packed.format = Format::Fax;
+        packed.data = faxG4(ctx, RasterAnalysis::toBitonal(px, source.width, source.height, stride),
+                            source.width, source.height);
+        break;
+    case Codec::Gray:
+        *tone = RasterAnalysis::Tone::Gray;
+        packed.components = 1;
+        packed.format = Format::Flate;
+        packed.data = deflate(ctx, RasterAnalysis::toGray(px, source.width, source.height, stride));
+        break;
+    case Codec::Jpeg:
+        *tone = RasterAnalysis::Tone::Color;
+        packed.format = Format::Dct;
+        packed.data = jpeg(source, encoding.jpegQuality);
+        break;
+    default:
+        *tone = RasterAnalysis::Tone::Color;
+        packed.format = Format::Flate;
+        packed.data = deflate(ctx, source.data);
+        break;
+    }
+    return packed;
+}
+
+/**
+ * @brief 把一个条带的编码数据作为图片对象加入文档
+ * @return 图片对象的引用，由调用方释放
+ */
+pdf_obj* addImage(fz_context* ctx, pdf_document* doc, const PageData& strip) {
+    pdf_obj* image = nullptr;
+    pdf_obj* ref = nullptr;
+    fz_buffer* data = nullptr;
+    fz_var(image);
+    fz_var(data);
+    fz_try(ctx) {
+        image = pdf_new_dict(ctx, doc, 8);
+        pdf_dict_put(ctx, image, PDF_NAME(Type), PDF_NAME(XObject));
+        pdf_dict_put(ctx, image, PDF_NAME(Subtype), PDF_NAME(Image));
+        pdf_dict_put_int(ctx, image, PDF_NAME(Width), strip.width);
+        pdf_dict_put_int(ctx, image, PDF_NAME(Height), strip.height);
+        pdf_dict_put_int(ctx, image, PDF_NAME(BitsPerComponent), strip.bpc);
+        pdf_dict_put(ctx, image, PDF_NAME(ColorSpace),
+                     strip.components == 1 ? PDF_NAME(DeviceGray) : PDF_NAME(DeviceRGB));
+        if (strip.format == Format::Fax) {
+            pdf_dict_put(ctx, image, PDF_NAME(Filter), PDF_NAME(CCITTFaxDecode));
+            pdf_obj* parms = pdf_dict_put_dict(ctx, image, PDF_NAME(DecodeParms), 3);
+            pdf_dict_put_int(ctx, parms, PDF_NAME(K), -1);
+            pdf_dict_put_int(ctx, parms, PDF_NAME(Columns), strip.width);
+            pdf_dict_put_int(ctx, parms, PDF_NAME(Rows), strip.height);
+        } else if (strip.format == Format::Dct) {
+            pdf_dict_put(ctx, image, PDF_NAME(Filter), PDF_NAME(DCTDecode));
+        } else {
+            pdf_dict_put(ctx, image, PDF_NAME(Filter), PDF_NAME(FlateDecode));
+        }
+        // 数据已在压缩阶段完成编码，按已压缩流写入
+        data = fz_new_buffer_from_copied_data(
+            ctx, (const unsigned char*)strip.data.constData(), strip.data.size());
+        ref = pdf_add_stream(ctx, doc, data, image, 1);
+    }
+    fz_always(ctx) {
+        fz_drop_buffer(ctx, data);
+        pdf_drop_obj(ctx, image);
+    }
+    fz_catch(ctx) { fz_rethrow(ctx); }
+    return ref;
+}
+
+/**
+ * @brief 释放写入中页面持有的图片对象引用
+ */
+void dropStrips(fz_context* ctx, PageWriter* writer) {
+    for (pdf_obj* image : writer->images) {
+        pdf_drop_obj(ctx, image);
+    }
+    writer->images.clear();
+    writer->tops.clear();
+    writer->rows.clear();
+}
+
+/**
+ * @brief 把一个条带作为图片对象写入文档
+ * @return 写入成功返回true
+ */
+bool writeStrip(fz_context* ctx, pdf_document* doc, PageWriter* writer,
+                const PageData& strip) {
+    bool ok = true;
+    fz_var(ok);
+    fz_try(ctx) {
+        writer->images.append(addImage(ctx, doc, strip));
+        writer->tops.append(strip.top);
+        writer->rows.append(strip.rows);
+    }
+    fz_catch(ctx) {
+        qDebug() << "写入第" << strip.page << "页条带失败：" << fz_caught_message(ctx);
+        ok = false;
+    }
+    return ok;
+}
+
+/**
+ * @brief 用已写入的条带生成页面，页面尺寸取原页面尺寸
+ * @param last 页面的最后一个条带，提供页面尺寸和整页像素行数
+ * @return 写入成功返回true
+ *
+ * 各条带按其像素行在整页中的位置换算为点坐标后自上而下拼接，
+ * 整页高度按像素行等比分配，相邻条带之间没有缝隙。
+ */
+bool finishPage(fz_context* ctx, pdf_document* doc, PageWriter* writer,
+                const PageData& last) {
+    pdf_obj* resources = nullptr;
+    pdf_obj* pageobj = nullptr;
+    fz_buffer* contents = nullptr;
+    bool ok = true;
+    fz_var(resources);
+    fz_var(pageobj);
+    fz_var(contents);
+    fz_var(ok);
+
+    fz_try(ctx) {
+        double pw = last.bounds.x1 - last.bounds.x0;
+        double ph = last.bounds.y1 - last.bounds.y0;
+        double rowHeight = ph / std::max(last.pageRows, 1);
+
+        resources = pdf_new_dict(ctx, doc, 1);
+        pdf_obj* xobjects = pdf_dict_put_dict(ctx, resources, PDF_NAME(XObject),
+                                              writer->images.size());
+        contents = fz_new_buffer(ctx, 64 * writer->images.size());
+        for (int i = 0; i < writer->images.size(); i++) {
+            QByteArray name = "Im" + QByteArray::number(i);
+            pdf_dict_puts(ctx, xobjects, name.constData(), writer->images[i]);
+            // PDF坐标原点在左下角，条带底边到页面底边的距离
+            double y = (last.pageRows - writer->tops[i] - writer->rows[i]) * rowHeight;
+            fz_append_printf(ctx, contents, "q %g 0 0 %g 0 %g cm /%s Do Q\n", pw,
+                             writer->rows[i] * rowHeight, y, name.constData());
+        }
+        pageobj = pdf_add_page(ctx, doc, fz_make_rect(0, 0, pw, ph), 0,
+                               resources, contents);
+        pdf_insert_page(ctx, doc, -1, pageobj);
+    }
+    fz_always(ctx) {
+        pdf_drop_obj(ctx, pageobj);
+        fz_drop_buffer(ctx, contents);
+        pdf_drop_obj(ctx, resources);
+        dropStrips(ctx, writer);
+    }
+    fz_catch(ctx) {
+        qDebug() << "写入第" << last.page << "页失败：" << fz_caught_message(ctx);
+        ok = false;
+    }
+    return ok;
+}
+
+/**
+ * @brief 保存文档到内存
+ * @return PDF文件内容，失败时返回空数组
+ */
+QByteArray saveDocument(fz_context* ctx, pdf_document* doc) {
+    QByteArray result;
+    fz_buffer* buf = nullptr;
+    fz_output* out = nullptr;
+    fz_var(buf);
+    fz_var(out);
+    fz_try(ctx) {
+        pdf_obj* info = pdf_add_new_dict(ctx, doc, 2);
+        pdf_dict_put_text_string(ctx, info, PDF_NAME(Creator), "泛生态业务工具集");
+        pdf_dict_put_text_string(ctx, info, PDF_NAME(Title), "本文档来自于泛生态业务投标案例");
+        pdf_dict_put_drop(ctx, pdf_trailer(ctx, doc), PDF_NAME(Info), info);
+
+        buf = fz_new_buffer(ctx, 1024 * 1024);
+        out = fz_new_output_with_buffer(ctx, buf);
+        pdf_write_options opts = pdf_default_write_options;
+        opts.do_compress = 1;
+        pdf_write_document(ctx, doc, out, &opts);
+        fz_close_output(ctx, out);
+
+        unsigned char* data = nullptr;
+        size_t len = fz_buffer_storage(ctx, buf, &data);
+        result = QByteArray((const char*)data, (int)len);
+    }
+    fz_always(ctx) {
+        fz_drop_output(ctx, out);
+        fz_drop_buffer(ctx, buf);
+    }
+    fz_catch(ctx) {
+        qDebug() << "保存扁平化结果失败：" << fz_caught_message(ctx);
+        result.clear();
+    }
+    return result;
+}
+
+} // namespace
+
+/**
+ * @brief 从界面选项文本解析编码选项
+ * @param text 选项文本
+ * @return 编码选项，无法识别时返回默认的自动模式
+ */
+Encoding parseEncoding(const QString& text) {
+    Encoding encoding;
+    QString t = text.trimmed();
+    if (t.startsWith("黑白")) {
+        encoding.codec = Codec::Bitonal;
+    } else if (t.startsWith("灰度")) {
+        encoding.codec = Codec::Gray;
+    } else if (t.startsWith("无损")) {
+        encoding.codec = Codec::Lossless;
+    } else if (t.startsWith("JPEG", Qt::CaseInsensitive)) {
+        encoding.codec = Codec::Jpeg;
+    }
+    // 文本末尾的数字作为JPEG质量，自动模式下用于彩色页面
+    bool ok = false;
+    int quality = t.section(' ', -1).toInt(&ok);
+    if (ok && quality > 0 && quality <= 100) {
+        encoding.jpegQuality = quality;
+    }
+    return encoding;
+}
+
+/**
+ * @brief 阶段利用率
+ * @param wallNs 流水线总耗时（纳秒）
+ * @return 忙碌时间占该阶段全部线程时间的比例（0~1）
+ */
+double StageStats::utilization(qint64 wallNs) const {
+    if (wallNs <= 0 || workers <= 0) {
+        return 0;
+    }
+    return std::min(1.0, (double)busyNs / ((double)wallNs * workers));
+}
+
+/**
+ * @brief 生成一行便于记录日志的摘要
+ */
+QString Stats::summary() const {
+    return QString("页数 %1 耗时 %2s 渲染 %3% 压缩 %4% 写入 %5% 峰值 %6MB 黑白/灰度/彩色 %7/%8/%9")
+        .arg(write.items)
+        .arg(wallNs / 1e9, 0, 'f', 1)
+        .arg(qRound(render.utilization(wallNs) * 100))
+        .arg(qRound(compress.utilization(wallNs) * 100))
+        .arg(qRound(write.utilization(wallNs) * 100))
+        .arg(peakBytes / (1024 * 1024))
+        .arg(bitonalPages)
+        .arg(grayPages)
+        .arg(colorPages);
+}
+
+namespace {
+
+/**
+ * @brief 渲染阶段的栅格化函数，参数为条带处理函数和渲染线程数，返回处理的页数
+ */
+typedef std::function<int(const PageRasterizer::BandSink& sink, int workers)> Rasterizer;
+
+/**
+ * @brief 运行扁平化流水线
+ * @param rasterize 渲染阶段的栅格化函数
+ * @param encoding 页面图片编码选项
+ * @param resolution 渲染分辨率（DPI）
+ * @param workers 渲染线程数，0表示使用CPU核心数
+ * @param budget 内存预算，nullptr表示不限制
+ * @param stats 输出各阶段统计，可为nullptr
+ * @return 扁平化后的PDF文件内容，失败时返回空数组
+ *
+ * 渲染阶段和压缩阶段运行在私有线程池中，写入阶段运行在调用线程。
+ * 写入失败时关闭两个队列，上游随即停止，已入队的数据照常归还预算。
+ */
+QByteArray runPipeline(const Rasterizer& rasterize, const Encoding& encoding, int resolution,
+                       int workers, MemoryBudget* budget, Stats* stats) {
+    if (workers <= 0) {
+        workers = QThread::idealThreadCount();
+    }
+    const int compressWorkers = std::max(1, workers / 2);
+
+    Stats local;
+    local.render.workers = 1;
+    local.compress.workers = compressWorkers;
+    local.write.workers = 1;
+    QMutex statsMutex;
+    QElapsedTimer wall;
+    wall.start();
+
+    BoundedQueue<PageData> rawQueue(compressWorkers * 2);
+    BoundedQueue<PageData> packedQueue(compressWorkers * 2);
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(1 + compressWorkers);
+
+    // 渲染阶段：按页码、条带顺序复制像素数据并放入渲染队列
+    QFuture<int> rendered = QtConcurrent::run(&pool, [&]() {
+        QElapsedTimer timer;
+        timer.start();
+        qint64 waitNs = 0;
+        int items = 0;
+        int seq = 0;
+        auto sink = [&](fz_context* ctx, const PageRasterizer::Band& band,
+                        fz_pixmap* pix) -> bool {
+            PageData raw;
+            raw.seq = seq++;
+            raw.page = band.page;
+            raw.band = band.index;
+            raw.bands = band.count;
+            raw.top = band.area.y0 - band.pageArea.y0;
+            raw.pageRows = band.pageArea.y1 - band.pageArea.y0;
+            raw.width = fz_pixmap_width(ctx, pix);
+            raw.height = fz_pixmap_height(ctx, pix);
+            raw.rows = raw.height;
+            raw.bounds = band.bounds;
+            raw.pageColor = band.color;
+            // 副本先记入预算，处理函数返回后原像素数据的预算随即归还
+            qint64 bytes = (qint64)fz_pixmap_stride(ctx, pix) * raw.height;
+            charge(budget, bytes);
+            raw.data = QByteArray((const char*)fz_pixmap_samples(ctx, pix), (int)bytes);
+            if (!rawQueue.push(raw, &waitNs)) {
+                release(budget, bytes);
+                return false;
+            }
+            if (band.index == band.count - 1) {
+                items++;
+            }
+            return true;
+        };
+        int n = rasterize(sink, workers);
+        rawQueue.close();
+
+        QMutexLocker locker(&statsMutex);
+        local.render.items = items;
+        local.render.waitNs = waitNs;
+        local.render.busyNs = timer.nsecsElapsed() - waitNs;
+        return n;
+    });
+
+    // 压缩阶段：并行检测色调并编码，最后一个线程结束时关闭压缩队列
+    QAtomicInt running(compressWorkers);
+    QList<QFuture<void>> compressors;
+    for (int w = 0; w < compressWorkers; w++) {
+        compressors.append(QtConcurrent::run(&pool, [&]() {
+            fz_context* ctx = fz_new_context(NULL, NULL, 0);
+            qint64 busyNs = 0;
+            qint64 waitNs = 0;
+            int items = 0;
+            int tones[3] = {0, 0, 0};
+            PageData raw;
+            while (rawQueue.pop(&raw, &waitNs)) {
+                QElapsedTimer timer;
+                timer.start();
+                RasterAnalysis::Tone tone = RasterAnalysis::Tone::Color;
+                PageData packed = ctx ? encodePage(ctx, raw, encoding, resolution, &tone) : PageData();
+                qint64 rawBytes = raw.data.size();
+                raw.data.clear();
+                packed.data.squeeze();
+                charge(budget, packed.data.size());
+                release(budget, rawBytes);
+                busyNs += timer.nsecsElapsed();
+                if (packed.data.isEmpty() || !packedQueue.push(packed, &waitNs)) {
+                    // 压缩失败或写入阶段已中止，丢弃该页，写入阶段会发现缺页
+                    release(budget, packed.data.size());
+                    if (packed.data.isEmpty()) {
+                        packedQueue.close();
+                        rawQueue.close();
+                    }
+                    continue;
+                }
+                items++;
+                if (packed.band == 0) {
+                    tones[(int)tone]++;  // 同一页各条带编码相同，按页统计
+                }
+            }
+            if (ctx) {
+                fz_drop_context(ctx);
+            }
+            if (!running.deref()) {
+                packedQueue.close();
+            }
+            QMutexLocker locker(&statsMutex);
+            local.compress.items += items;
+            local.compress.busyNs += busyNs;
+            local.compress.waitNs += waitNs;
+            local.colorPages += tones[(int)RasterAnalysis::Tone::Color];
+            local.grayPages += tones[(int)RasterAnalysis::Tone::Gray];
+            local.bitonalPages += tones[(int)RasterAnalysis::Tone::Bitonal];
+        }));
+    }
+
+    // 写入阶段：压缩结果可能乱序到达，按顺序号重新排序；
+    // 每个条带到达即写成图片对象并归还预算，页面的最后一个条带到达后再生成页面
+    QByteArray result;
+    fz_context* ctx = fz_new_context(NULL, NULL, FZ_STORE_DEFAULT);
+    pdf_document* doc = nullptr;
+    fz_var(doc);
+    if (ctx) {
+        fz_try(ctx) { doc = pdf_create_document(ctx); }
+        fz_catch(ctx) {
+            qDebug() << "创建PDF文档失败：" << fz_caught_message(ctx);
+            doc = nullptr;
+        }
+    }
+    bool failed = (doc == nullptr);
+    if (failed) {
+        rawQueue.close();
+        packedQueue.close();
+    }
+
+    QMap<int, PageData> pending;
+    PageWriter writer;  // 当前页已写入的条带
+    int next = 0;
+    int written = 0;
+    PageData packed;
+    while (packedQueue.pop(&packed, &local.write.waitNs)) {
+        pending.insert(packed.seq, packed);
+        packed.data.clear();
+        while (pending.contains(next)) {
+            PageData strip = pending.take(next);
+            next++;
+            QElapsedTimer timer;
+            timer.start();
+            if (!failed && !writeStrip(ctx, doc, &writer, strip)) {
+                failed = true;
+            }
+            bool last = strip.band == strip.bands - 1;
+            if (!failed && last && !finishPage(ctx, doc, &writer, strip)) {
+                failed = true;
+            }
+            if (failed) {
+                rawQueue.close();
+                packedQueue.close();
+            }
+            local.write.busyNs += timer.nsecsElapsed();
+            release(budget, strip.data.size());
+            if (last) {
+                written++;
+            }
+        }
+    }
+    // 中止后残留的条带同样归还预算
+    if (ctx) {
+        dropStrips(ctx, &writer);
+    }
+    for (const PageData& strip : pending) {
+        release(budget, strip.data.size());
+    }
+    local.write.items = written;
+
+    int pages = rendered.result();
+    for (QFuture<void>& compressor : compressors) {
+        compressor.waitForFinished();
+    }
+
+    if (!failed && pages >= 0 && written == pages) {
+        QElapsedTimer timer;
+        timer.start();
+        result = saveDocument(ctx, doc);
+        local.write.busyNs += timer.nsecsElapsed();
+    } else {
+        qDebug() << "扁平化流水线失败，已写入" << written << "页，共" << pages << "页";
+    }
+    if (ctx) {
+        pdf_drop_document(ctx, doc);
+        fz_drop_context(ctx);
+    }
+
+    local.wallNs = wall.nsecsElapsed();
+    local.peakBytes = budget ? budget->peak() : 0;
+    if (stats) {
+        *stats = local;
+    }
+    return result;
+}
+
+} // namespace
+
+/**
+ * @brief 将内存中的PDF栅格化为纯图片PDF
+ * @param pdfData PDF文件内容
+ * @param resolution 栅格化分辨率（DPI）
+ * @param encoding 页面图片编码选项
+ * @param workers 渲染线程数，0表示使用CPU核心数
+ * @param bandHeight 条带高度（像素），0表示整页，小于0表示自动
+ * @param budget 内存预算，nullptr表示不限制
+ * @param stats 输出各阶段统计，可为nullptr
+ * @return 扁平化后的PDF文件内容，失败时返回空数组
+ */
+QByteArray run(const QByteArray& pdfData, int resolution, const Encoding& encoding,
+               int workers, int bandHeight, MemoryBudget* budget, Stats* stats) {
+    auto rasterize = [&](const PageRasterizer::BandSink& sink, int threads) {
+        return PageRasterizer::rasterizeBands(pdfData, resolution, bandHeight, sink,
+                                              threads, budget);
+    };
+    return runPipeline(rasterize, encoding, resolution, workers, budget, stats);
+}
+
+/**
+ * @brief 将PDF文件栅格化为纯图片PDF
+ * @param pdfFile PDF文件路径
+ * @param resolution 栅格化分辨率（DPI）
+ * @param encoding 页面图片编码选项
+ * @param workers 渲染线程数，0表示使用CPU核心数
+ * @param bandHeight 条带高度（像素），0表示整页，小于0表示自动
+ * @param budget 内存预算，nullptr表示不限制
+ * @param stats 输出各阶段统计，可为nullptr
+ * @return 扁平化后的PDF文件内容，失败时返回空数组
+ */
+QByteArray runFile(const QString& pdfFile, int resolution, const Encoding& encoding,
+                   int workers, int bandHeight, MemoryBudget* budget, Stats* stats) {
+    auto rasterize = [&](const PageRasterizer::BandSink& sink, int threads) {
+        return PageRasterizer::rasterizeFileBands(pdfFile, resolution, bandHeight, sink,
+                                                  threads, budget);
+    };
+    return runPipeline(rasterize, encoding, resolution, workers, budget, stats);
+}
+
+} // namespace FlattenPipeline
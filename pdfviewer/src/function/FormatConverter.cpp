@@ -11,161 +11,75 @@
 
 #pragma execution_character_set("utf-8") // 设置编译器使用UTF-8字符集
 #include "include/function/FormatConverter.h"
+#include "include/function/FlattenPipeline.h"
+#include "include/function/ImageBatch.h"
+#include "include/function/PageRasterizer.h"
 #include "include/mark/mark.h" // 包含GetFontsFolder函数声明
+#include <QFile>
 
 namespace FormatConverter {
 
 /**
  * @brief 将PDF文件转换为图片文件
- * 使用MuPDF库将PDF的每一页转换为PNG格式的图片
+ * 使用MuPDF库将PDF的每一页转换为PNG格式的图片，
+ * 页面显示列表取自DisplayListCache，同一文件换分辨率重复转换时不再解析页面
  * @param pdfFile PDF文件路径
  * @param imagePath 图片输出目录路径
  * @param resolution 输出图片的分辨率（DPI），默认72
  * @return 转换的页面数量，出错时返回1
  */
 int pdf2image(string pdfFile, string imagePath, int resolution) {
-    // 创建MuPDF上下文
-    fz_context* ctx = fz_new_context(NULL, NULL, FZ_STORE_DEFAULT);
-    fz_register_document_handlers(ctx);  // 注册文档处理器
-    
-    // 打开PDF文档
-    fz_document* doc = fz_open_document(ctx, pdfFile.c_str());
-    if (!doc) {
+    // 生成输出图片文件名：0.png, 1.png, 2.png...
+    auto savePage = [&imagePath](fz_context* ctx, int page, fz_pixmap* pix,
+                                 const fz_rect&) -> bool {
+        string fileName = imagePath + "/" + to_string(page) + ".png";
+        fz_try(ctx) { fz_save_pixmap_as_png(ctx, pix, fileName.c_str()); }
+        fz_catch(ctx) {
+            qDebug() << "处理第" << page << "页时发生错误：" << fz_caught_message(ctx);
+        }
+        return true;
+    };
+
+    int num = PageRasterizer::rasterizeFile(QString::fromStdString(pdfFile), resolution,
+                                            savePage);
+    if (num < 0) {
         qDebug() << "文件处理错误：" << QString::fromStdString(pdfFile);
         return 1;
     }
-    
-    int num = fz_count_pages(ctx, doc);  // 获取PDF页面数
-    float zoom = (float)resolution / (float)72;  // 计算缩放比例（基于72DPI）
-    fz_matrix ctm = fz_scale(zoom, zoom);  // 创建变换矩阵
-
-    // 逐页转换为图片
-    for (int i = 0; i < num; i++) {
-        string fileName = imagePath + "/" + to_string(i) + ".png";
-        // 创建页面的像素图
-        fz_pixmap* pix =
-            fz_new_pixmap_from_page_number(ctx, doc, i, ctm, fz_device_rgb(ctx), 0);
-        // 保存为PNG文件
-        fz_save_pixmap_as_png(ctx, pix, fileName.c_str());
-        fz_drop_pixmap(ctx, pix);  // 释放像素图内存
-    }
-
-    // 清理资源
-    fz_drop_document(ctx, doc);
-    fz_drop_context(ctx);
     return num;  // 返回转换的页面数
 }
 
 /**
  * @brief 将单个图片文件转换为PDF文件
- * 使用PDFlib库创建包含一页图片的PDF文档
+ * 页面大小等于图片尺寸；JPEG等可直通的图片原样嵌入，由ImageBatch完成
  * @param imageFile 输入图片文件路径
  * @param pdfFile 输出PDF文件路径
  * @return 0表示成功，2表示失败
  */
 int image2pdf(std::string imageFile, std::string pdfFile) {
-    PDFlib p;
-    
-    // 设置PDFlib搜索路径，包括字体映射文件和系统字体目录
-    const wstring searchpath = L"./PDFlib-CMap-5.0/resource/cmap";
-    wostringstream optlist;
-    optlist << L"searchpath={{" << searchpath << L"}";
-    optlist << L" {" << GetFontsFolder() << L"}}";
-    p.set_option(optlist.str());
-
-    // 设置PDF文档信息
-    p.set_info(L"Creator", L"泛生态业务工具集");
-    p.set_info(L"Title", L"本文档来自于泛生态业务投标案例");
-    
-    int image;
-    double imagewidth, imageheight;
-    try {
-        // 开始创建PDF文档
-        if (p.begin_document(StringConverter::String2WString(pdfFile), L"") == -1) {
-            wcerr << L"Error: " << p.get_errmsg() << endl;
-            return 2;
-        }
-        
-        // 加载图片并获取尺寸信息
-        image = p.load_image(L"auto", StringConverter::String2WString(imageFile), L"");
-        imagewidth = p.info_image(image, L"width", L"");   // 获取图片宽度
-        imageheight = p.info_image(image, L"height", L""); // 获取图片高度
-        
-        if (image == 0) {
-            // 图片加载失败的错误处理
-        }
-
-        // 创建与图片尺寸相同的PDF页面
-        p.begin_page_ext(imagewidth, imageheight, L"");
-        p.fit_image(image, 0, 0, L"");  // 将图片放置在页面左下角
-        p.close_image(image);           // 关闭图片资源
-        p.end_page_ext(L"");           // 结束页面
-
-        p.end_document(L"");  // 结束文档创建
-        return 0;
-    } catch (PDFlib::Exception& ex) {
-        // PDFlib异常处理
-        wcerr << L"PDFlib 发生异常: " << endl
-              << L"[" << ex.get_errnum() << L"] " << ex.get_apiname() << L": "
-              << ex.get_errmsg() << endl
-              << L": " << L"错误的参数选项请使用 - h参数查看帮助" << endl;
-        return 2;
-    }
+    ImageBatch::Stats stats;
+    int result = ImageBatch::convertFile(QString::fromStdString(imageFile),
+                                         QString::fromStdString(pdfFile), &stats);
+    qDebug() << "图片转PDF：" << QString::fromStdString(imageFile) << stats.summary();
+    return result;
 }
 
 /**
  * @brief 将图片列表合并到一个PDF文件
- * 每个图片占一页，页面大小自适应图片尺寸
+ * 每个图片占一页，页面大小自适应图片尺寸；图片在多个线程上并行解码，按列表顺序写入
  * @param images 图片文件路径列表
  * @param pdfFile 输出PDF文件路径
+ * @param removeImages 成功后是否删除原图片文件
  * @return 0表示成功，2表示失败
  */
-int images2pdf(QStringList& images, std::string pdfFile) {
-    PDFlib p;
-    const wstring searchpath = L"./PDFlib-CMap-5.0/resource/cmap";
-    wostringstream optlist;
-    optlist << L"searchpath={{" << searchpath << L"}";
-    optlist << L" {" << GetFontsFolder() << L"}}";
-    p.set_option(optlist.str());
-    
-    // 设置PDF文档信息
-    p.set_info(L"Creator", L"泛生态业务工具集");
-    p.set_info(L"Title", L"本文档来自于泛生态业务投标案例");
-    
-    int image;
-    double imagewidth, imageheight;
-    
-    try {
-        if (p.begin_document(StringConverter::String2WString(pdfFile), L"") == -1) {
-            wcerr << L"Error: " << p.get_errmsg() << endl;
-            return 2;
-        }
-        
-        // 遍历图片列表，为每个图片创建一页PDF
+int images2pdf(QStringList& images, std::string pdfFile, bool removeImages) {
+    int result = ImageBatch::combine(images, QString::fromStdString(pdfFile));
+    if (result == 0 && removeImages) {
         for (const QString& file : images) {
-            image = p.load_image(L"auto", StringConverter::QString2WString(file), L"");  // 加载图片
-            imagewidth = p.info_image(image, L"width", L"");           // 获取图片宽度
-            imageheight = p.info_image(image, L"height", L"");         // 获取图片高度
-            
-            if (image == 0) {
-                wcerr << L"Error: " << p.get_errmsg();  // 图片加载失败
-            }
-            
-            p.begin_page_ext(imagewidth, imageheight, L"");  // 创建与图片尺寸相同的页面
-            p.fit_image(image, 0, 0, L"");                   // 将图片放置在页面上
-            p.close_image(image);                            // 关闭图片资源
-            std::remove(file.toUtf8().data());              // 删除原始图片文件
-            p.end_page_ext(L"");                            // 结束页面
+            QFile::remove(file);  // 删除原始图片文件
         }
-        p.end_document(L"");
-        return 0;
-    } catch (PDFlib::Exception& ex) {
-        wcerr << L"PDFlib 发生异常: " << endl
-              << L"[" << ex.get_errnum() << L"] " << ex.get_apiname() << L": "
-              << ex.get_errmsg() << endl
-              << L": " << L"错误的参数选项请使用 - h参数查看帮助" << endl;
-        return 2;
     }
+    return result;
 }
 
 /**
@@ -227,4 +141,140 @@ int images2pdf(std::string imagesDir, std::string pdfFile, int num) {
     }
 }
 
+/**
+ * @brief 将内存中的PDF转换为PNG图片数据
+ * @param pdfData PDF文件内容
+ * @param resolution 输出图片的分辨率（DPI）
+ * @return 每页一个PNG数据，出错时返回空列表
+ */
+QList<QByteArray> pdf2imageBuffers(const QByteArray& pdfData, int resolution) {
+    QList<QByteArray> images;
+    fz_context* ctx = fz_new_context(NULL, NULL, FZ_STORE_DEFAULT);
+    if (!ctx) {
+        qDebug() << "创建MuPDF上下文失败";
+        return images;
+    }
+
+    fz_stream* stm = nullptr;
+    fz_document* doc = nullptr;
+    fz_pixmap* pix = nullptr;
+    fz_buffer* buf = nullptr;
+    fz_var(stm);
+    fz_var(doc);
+    fz_var(pix);
+    fz_var(buf);
+
+    fz_try(ctx) {
+        fz_register_document_handlers(ctx);
+        stm = fz_open_memory(ctx, (const unsigned char*)pdfData.constData(),
+                             pdfData.size());
+        doc = fz_open_document_with_stream(ctx, "application/pdf", stm);
+
+        int num = fz_count_pages(ctx, doc);
+        float zoom = (float)resolution / (float)72;  // 计算缩放比例（基于72DPI）
+        fz_matrix ctm = fz_scale(zoom, zoom);
+        for (int i = 0; i < num; i++) {
+            pix = fz_new_pixmap_from_page_number(ctx, doc, i, ctm, fz_device_rgb(ctx), 0);
+            buf = fz_new_buffer_from_pixmap_as_png(ctx, pix, fz_default_color_params);
+            unsigned char* data = nullptr;
+            size_t len = fz_buffer_storage(ctx, buf, &data);
+            images.append(QByteArray((const char*)data, (int)len));
+            fz_drop_buffer(ctx, buf);
+            buf = nullptr;
+            fz_drop_pixmap(ctx, pix);
+            pix = nullptr;
+        }
+    }
+    fz_always(ctx) {
+        fz_drop_buffer(ctx, buf);
+        fz_drop_pixmap(ctx, pix);
+        fz_drop_document(ctx, doc);
+        fz_drop_stream(ctx, stm);
+    }
+    fz_catch(ctx) {
+        qDebug() << "文件处理错误：" << fz_caught_message(ctx);
+        images.clear();
+    }
+
+    fz_drop_context(ctx);
+    return images;
+}
+
+/**
+ * @brief 将内存中的单个图片转换为PDF
+ * @param imageData 图片文件内容
+ * @return PDF文件内容，失败时返回空数组
+ */
+QByteArray image2pdfBuffer(const QByteArray& imageData) {
+    return images2pdfBuffer(QList<QByteArray>() << imageData);
+}
+
+/**
+ * @brief 将内存中的图片列表合并为一个PDF
+ * 每个图片通过PVF虚拟文件加载，页面大小自适应图片尺寸
+ * @param images 图片文件内容列表
+ * @return PDF文件内容，失败时返回空数组
+ */
+QByteArray images2pdfBuffer(const QList<QByteArray>& images) {
+    PDFlib p;
+    const wstring searchpath = L"./PDFlib-CMap-5.0/resource/cmap";
+    wostringstream optlist;
+    optlist << L"searchpath={{" << searchpath << L"}";
+    optlist << L" {" << GetFontsFolder() << L"}}";
+    p.set_option(optlist.str());
+
+    // 设置PDF文档信息
+    p.set_info(L"Creator", L"泛生态业务工具集");
+    p.set_info(L"Title", L"本文档来自于泛生态业务投标案例");
+
+    try {
+        // 文件名为空时输出到内存，结束后用get_buffer取出
+        if (p.begin_document(L"", L"") == -1) {
+            wcerr << L"Error: " << p.get_errmsg() << endl;
+            return QByteArray();
+        }
+
+        for (int i = 0; i < images.size(); i++) {
+            const wstring pvf = L"/pvf/image/" + to_wstring(i);
+            p.create_pvf(pvf, images[i].constData(), images[i].size(), L"");
+            int image = p.load_image(L"auto", pvf, L"");
+            if (image == -1) {
+                wcerr << L"Error: " << p.get_errmsg() << endl;  // 图片加载失败
+                p.delete_pvf(pvf);
+                continue;
+            }
+            double imagewidth = p.info_image(image, L"width", L"");
+            double imageheight = p.info_image(image, L"height", L"");
+
+            p.begin_page_ext(imagewidth, imageheight, L"");  // 创建与图片尺寸相同的页面
+            p.fit_image(image, 0, 0, L"");
+            p.close_image(image);
+            p.end_page_ext(L"");
+            p.delete_pvf(pvf);  // 图片已写入输出，释放虚拟文件
+        }
+        p.end_document(L"");
+
+        long len = 0;
+        const char* data = p.get_buffer(&len);
+        return QByteArray(data, (int)len);
+    } catch (PDFlib::Exception& ex) {
+        wcerr << L"PDFlib 发生异常: " << endl
+              << L"[" << ex.get_errnum() << L"] " << ex.get_apiname() << L": "
+              << ex.get_errmsg() << endl;
+        return QByteArray();
+    }
+}
+
+/**
+ * @brief 将内存中的PDF栅格化为纯图片PDF（扁平化）
+ * 由FlattenPipeline分渲染、压缩、写入三个阶段并行完成，不限制内存预算
+ * @param pdfData PDF文件内容
+ * @param resolution 栅格化分辨率（DPI）
+ * @param workers 渲染线程数，0表示使用CPU核心数
+ * @return 扁平化后的PDF文件内容，失败时返回空数组
+ */
+QByteArray flattenPdfBuffer(const QByteArray& pdfData, int resolution, int workers) {
+    return FlattenPipeline::run(pdfData, resolution, FlattenPipeline::Encoding(), workers);
+}
+
 } // namespace FormatConverter
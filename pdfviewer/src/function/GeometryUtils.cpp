@@ -11,63 +11,21 @@
 
 #pragma execution_character_set("utf-8") // 设置编译器使用UTF-8字符集
 #include "include/function/GeometryUtils.h"
-
-// 链接Windows GDI库，用于文本宽度计算
-#pragma comment(lib, "Gdi32.lib")
+#include "include/function/TextMetrics.h"
 
 namespace GeometryUtils {
 
 /**
- * @brief 使用Windows GDI获取指定字体和大小的文本宽度
+ * @brief 获取指定字体和大小的文本尺寸
  * 用于水印文本的尺寸计算和布局
  * @param text 要测量的文本内容
  * @param fontName 字体名称
  * @param fontSize 字体大小
- * @return SIZE结构体，包含文本的宽度和高度信息
+ * @return 文本的宽度和高度
  */
-SIZE getTextWidth(QString text, QString fontName, int fontSize) {
-    // 创建兼容的设备上下文
-    HDC hdc = CreateCompatibleDC(NULL);
-    if (hdc == NULL) {
-        qDebug() << "无法创建设备上下文！" << endl;
-    }
-    
-    // 将QString转换为wchar_t数组
-    std::vector<wchar_t> wcharArray(fontName.length() + 1);
-    fontName.toWCharArray(wcharArray.data());
-
-    // 获取wchar_t数组指针
-    wchar_t* wcharPtr_fontname = wcharArray.data();
-    
-    // 选择字体
-    HFONT hFont = CreateFont(fontSize, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
-                           DEFAULT_CHARSET, OUT_DEFAULT_PRECIS,
-                           CLIP_DEFAULT_PRECIS, DEFAULT_QUALITY,
-                           DEFAULT_PITCH | FF_DONTCARE, wcharPtr_fontname);
-    if (hFont == NULL) {
-        qDebug() << "无法创建字体！" << endl;
-        DeleteDC(hdc);
-    }
-    
-    // 选择字体到设备上下文
-    SelectObject(hdc, hFont);
-    
-    // 将QString转换为std::wstring
-    std::wstring wtext = text.toStdWString();
-    // 获取LPCWSTR指针
-    LPCWSTR lpcwstr = wtext.c_str();
-
-    SIZE size;
-    if (!GetTextExtentPoint32(hdc, lpcwstr, wcslen(lpcwstr), &size)) {
-        qDebug() << "无法获取文本尺寸！" << endl;
-        DeleteObject(hFont);
-        DeleteDC(hdc);
-    }
-    
-    // 释放资源
-    DeleteObject(hFont);
-    DeleteDC(hdc);
-    return size;
+QSize getTextWidth(QString text, QString fontName, int fontSize) {
+    QSizeF size = TextMetrics::textSize(text, fontName, fontSize);
+    return QSize(qCeil(size.width()), qCeil(size.height()));
 }
 
 /**
@@ -135,14 +93,13 @@ void createSVG(QString svgName, QString text, int pageWidth, int pageHeight,
     QFont font(fontName, fontSize);
     QStringList textLines = text.split("\n");  // 按换行符分割文本
     
-    // 使用QFontMetrics计算文本尺寸
-    QFontMetrics fontMetrics(font);
-    int lineHeight = fontMetrics.height();  // 单行高度
+    // 计算文本尺寸（结果按字体、字号、文本缓存）
+    int lineHeight = qCeil(TextMetrics::lineHeight(fontName, fontSize));  // 单行高度
     int maxWidth = 0;
     
     // 遍历所有文本行，找出最大宽度
     foreach (const QString& line, textLines) {
-        int lineWidth = getTextWidth(line, fontName, fontSize).cx;
+        int lineWidth = getTextWidth(line, fontName, fontSize).width();
         if (lineWidth > maxWidth) {
             maxWidth = lineWidth;
         }
@@ -0,0 +1,100 @@
+/**
+ * @file GraftAnnotations.cpp
+ * @brief 嫁接页面的注释复制模块实现
+ *
+ * 复制分两步：detach()把源文档所有注释的/P删除、链接目标暂存为页序号，
+ * copyPage()嫁接一页的/Annots后再把/P和链接目标指向目标文档的页面。
+ * 先处理全部页面再复制，表单域/Kids中其他页面上的控件也不会带出页面树。
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma execution_character_set("utf-8") // 设置编译器使用UTF-8字符集
+#include "include/function/GraftAnnotations.h"
+
+namespace GraftAnnotations {
+
+namespace {
+
+/**
+ * @brief 取链接注释的显式目标数组（/Dest或GoTo动作的/D）
+ */
+pdf_obj* linkDest(fz_context* ctx, pdf_obj* annot) {
+    pdf_obj* dest = pdf_dict_get(ctx, annot, PDF_NAME(Dest));
+    if (!dest) {
+        pdf_obj* action = pdf_dict_get(ctx, annot, PDF_NAME(A));
+        if (pdf_name_eq(ctx, pdf_dict_get(ctx, action, PDF_NAME(S)), PDF_NAME(GoTo))) {
+            dest = pdf_dict_get(ctx, action, PDF_NAME(D));
+        }
+    }
+    return pdf_is_array(ctx, dest) ? dest : nullptr;
+}
+
+} // namespace
+
+/**
+ * @brief 断开源文档注释对页面对象的引用
+ * @param src 源文档
+ */
+void detach(fz_context* ctx, pdf_document* src) {
+    int n = pdf_count_pages(ctx, src);
+    for (int i = 0; i < n; i++) {
+        pdf_obj* annots = pdf_dict_get(ctx, pdf_lookup_page_obj(ctx, src, i),
+                                       PDF_NAME(Annots));
+        int count = pdf_array_len(ctx, annots);
+        for (int k = 0; k < count; k++) {
+            pdf_obj* annot = pdf_array_get(ctx, annots, k);
+            pdf_dict_del(ctx, annot, PDF_NAME(P));
+            pdf_obj* dest = linkDest(ctx, annot);
+            if (dest && pdf_is_dict(ctx, pdf_array_get(ctx, dest, 0))) {
+                int target = pdf_lookup_page_number(ctx, src, pdf_array_get(ctx, dest, 0));
+                pdf_array_put_drop(ctx, dest, 0, pdf_new_int(ctx, target));
+            }
+        }
+    }
+}
+
+/**
+ * @brief 把源文档一页的注释复制到已嫁接的目标页面
+ * @param map 嫁接映射，nullptr表示单独深复制
+ * @param dst 目标文档
+ * @param src 源文档
+ * @param srcPage 源页序号
+ * @param dstPage 目标页序号
+ * @param dstPageOf 源页序号到目标页序号的对应关系
+ */
+void copyPage(fz_context* ctx, pdf_graft_map* map, pdf_document* dst,
+              pdf_document* src, int srcPage, int dstPage, const int* dstPageOf) {
+    pdf_obj* annots = pdf_dict_get(ctx, pdf_lookup_page_obj(ctx, src, srcPage),
+                                   PDF_NAME(Annots));
+    int count = pdf_array_len(ctx, annots);
+    if (count == 0) {
+        return;
+    }
+
+    pdf_obj* page = pdf_lookup_page_obj(ctx, dst, dstPage);
+    pdf_obj* copy = map ? pdf_graft_mapped_object(ctx, map, annots)
+                        : pdf_graft_object(ctx, dst, annots);
+    pdf_dict_put_drop(ctx, page, PDF_NAME(Annots), copy);
+    annots = pdf_dict_get(ctx, page, PDF_NAME(Annots));
+
+    int n = pdf_count_pages(ctx, src);
+    for (int k = 0; k < count; k++) {
+        pdf_obj* annot = pdf_array_get(ctx, annots, k);
+        pdf_dict_put(ctx, annot, PDF_NAME(P), page);
+        pdf_obj* dest = linkDest(ctx, annot);
+        if (dest && pdf_is_int(ctx, pdf_array_get(ctx, dest, 0))) {
+            // 指向未复制页面的链接在目标文档中已失效，保留注释、去掉目标
+            int target = pdf_array_get_int(ctx, dest, 0);
+            if (target >= 0 && target < n && dstPageOf[target] >= 0) {
+                pdf_array_put(ctx, dest, 0, pdf_lookup_page_obj(ctx, dst, dstPageOf[target]));
+            } else {
+                pdf_dict_del(ctx, annot, PDF_NAME(Dest));
+                pdf_dict_del(ctx, annot, PDF_NAME(A));
+            }
+        }
+    }
+}
+
+} // namespace GraftAnnotations
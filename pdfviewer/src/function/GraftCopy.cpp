@@ -0,0 +1,787 @@
+/**
+ * @file GraftCopy.cpp
+ * @brief 基于MuPDF对象嫁接的页面复制模块实现
+ *
+ * 页面通过pdf_graft_mapped_page复制到新文档，页面树上继承的属性
+ * （MediaBox、Rotate、Resources）由MuPDF展开到页面字典中；
+ * 页面注释（链接、表单域、批注）由GraftAnnotations另外复制。
+ * 嫁接会把流数据一并复制，因此输出组装完成后即可关闭输入。
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma execution_character_set("utf-8") // 设置编译器使用UTF-8字符集
+#include "include/function/GraftCopy.h"
+
+#include <QAtomicInt>
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+#include <limits>
+
+#include "include/function/FileSystemUtils.h"
+#include "include/function/GraftAnnotations.h"
+#include "mupdf/fitz.h"
+#include "mupdf/pdf.h"
+
+namespace GraftCopy {
+
+namespace {
+
+using PdfOperations::CopyBackend;
+using PdfOperations::MergeSource;
+using PdfOperations::PageRange;
+
+/**
+ * @brief 写入文档信息并把文档写到内存
+ * @return 调用方负责释放的缓冲区，出错时抛出MuPDF异常
+ * @note 只调用MuPDF的C接口，可以在fz_try中使用
+ */
+fz_buffer* writeToBuffer(fz_context* ctx, pdf_document* dst) {
+    pdf_obj* info = pdf_add_new_dict(ctx, dst, 2);
+    pdf_dict_put_text_string(ctx, info, PDF_NAME(Creator), "泛生态业务工具集");
+    pdf_dict_put_text_string(ctx, info, PDF_NAME(Title), "本文档来自于泛生态业务投标案例");
+    pdf_dict_put_drop(ctx, pdf_trailer(ctx, dst), PDF_NAME(Info), info);
+
+    pdf_write_options opts = pdf_default_write_options;
+    opts.do_compress = 1;
+    opts.do_garbage = 1;
+
+    fz_buffer* buf = fz_new_buffer(ctx, 1024 * 1024);
+    fz_output* out = nullptr;
+    fz_var(out);
+    fz_try(ctx) {
+        out = fz_new_output_with_buffer(ctx, buf);
+        pdf_write_document(ctx, dst, out, &opts);
+        fz_close_output(ctx, out);
+    }
+    fz_always(ctx) { fz_drop_output(ctx, out); }
+    fz_catch(ctx) {
+        fz_drop_buffer(ctx, buf);
+        fz_rethrow(ctx);
+    }
+    return buf;
+}
+
+/**
+ * @brief 把写好的文档保存为文件
+ * @return 成功返回true
+ *
+ * 由QSaveFile写出：文件名由Qt按系统编码处理，不经过MuPDF的文件接口；
+ * 写到临时文件后改名，输出覆盖某个输入文件时中途失败也不会留下写了一半的文件。
+ * 用到Qt对象，只能在fz_try之外调用。
+ */
+bool saveBuffer(fz_context* ctx, fz_buffer* buf, const QString& outFile) {
+    unsigned char* storage = nullptr;
+    size_t len = fz_buffer_storage(ctx, buf, &storage);
+    return FileSystemUtils::writeFileBytes(
+        outFile, QByteArray::fromRawData((const char*)storage, (int)len));
+}
+
+/**
+ * @brief 把src中各范围的页面依次追加到映射的目标文档，并复制页面注释
+ * @param dst 映射的目标文档
+ * @param src 源文档，需已经过GraftAnnotations::detach
+ * @param copied 可选，按src页序号标记注释已经通过map复制过的页面；
+ *        同一页面再次出现时注释另外深复制一份，不与之前的页面共用注释对象
+ * @return 追加的页数
+ * @note 链接只在本次追加的页面之间保留，页面重复时指向第一次出现的位置
+ */
+int appendRanges(fz_context* ctx, pdf_graft_map* map, pdf_document* dst,
+                 pdf_document* src, const QList<PageRange>& ranges,
+                 unsigned char* copied = nullptr) {
+    const int pageCount = pdf_count_pages(ctx, src);
+    const int base = pdf_count_pages(ctx, dst);
+    int* dstPageOf = nullptr;
+    int written = 0;
+    fz_var(dstPageOf);
+    fz_var(written);
+
+    fz_try(ctx) {
+        dstPageOf = fz_malloc_array(ctx, pageCount, int);
+        for (int i = 0; i < pageCount; i++) {
+            dstPageOf[i] = -1;
+        }
+        for (const PageRange& range : ranges) {
+            for (int page = std::max(0, range.start); page < std::min(range.end, pageCount);
+                 page += std::max(1, range.step)) {
+                pdf_graft_mapped_page(ctx, map, -1, src, page);
+                if (dstPageOf[page] < 0) {
+                    dstPageOf[page] = base + written;
+                }
+                written++;
+            }
+        }
+
+        // 链接可能指向后面的页面，全部页面复制完后再复制注释
+        int dstPage = base;
+        for (const PageRange& range : ranges) {
+            for (int page = std::max(0, range.start); page < std::min(range.end, pageCount);
+                 page += std::max(1, range.step)) {
+                bool repeated = dstPageOf[page] != dstPage || (copied && copied[page]);
+                GraftAnnotations::copyPage(ctx, repeated ? nullptr : map, dst, src, page,
+                                           dstPage, dstPageOf);
+                if (copied) {
+                    copied[page] = 1;
+                }
+                dstPage++;
+            }
+        }
+    }
+    fz_always(ctx) { fz_free(ctx, dstPageOf); }
+    fz_catch(ctx) { fz_rethrow(ctx); }
+    return written;
+}
+
+/**
+ * @brief 从已打开的输入写出一个提取文件
+ * @return 0: 成功, 2: 失败
+ */
+int writeExtract(fz_context* ctx, pdf_document* src, const Extract& output) {
+    pdf_document* dst = nullptr;
+    pdf_graft_map* map = nullptr;
+    fz_buffer* buf = nullptr;
+    int written = 0;
+    fz_var(dst);
+    fz_var(map);
+    fz_var(buf);
+    fz_var(written);
+
+    // fz_try中只调用C接口：出错时longjmp跳出，其中构造的C++对象不会被析构
+    fz_try(ctx) {
+        dst = pdf_create_document(ctx);
+        // 一个输出文件共用一个嫁接映射，各页引用的同一资源只复制一次
+        map = pdf_new_graft_map(ctx, dst);
+        written = appendRanges(ctx, map, dst, src, output.ranges);
+        if (written > 0) {
+            buf = writeToBuffer(ctx, dst);
+        }
+    }
+    fz_always(ctx) {
+        pdf_drop_graft_map(ctx, map);
+        pdf_drop_document(ctx, dst);
+    }
+    fz_catch(ctx) {
+        qDebug() << "写出拆分文件失败：" << output.file << fz_caught_message(ctx);
+        return 2;
+    }
+
+    if (!buf) {
+        qDebug() << "没有可拆分的页面：" << output.file;
+        return 2;
+    }
+    int result = 0;
+    if (!saveBuffer(ctx, buf, output.file)) {
+        qDebug() << "写出拆分文件失败：" << output.file;
+        result = 2;
+    }
+    fz_drop_buffer(ctx, buf);
+    return result;
+}
+
+/**
+ * @brief 一个工作线程：解析一次输入，领取并写出提取文件
+ * @return 0: 全部成功, 2: 有文件失败
+ */
+int extractWorker(const QByteArray& pdfData, const QList<Extract>& outputs, QAtomicInt& next) {
+    fz_context* ctx = fz_new_context(NULL, NULL, FZ_STORE_DEFAULT);
+    if (!ctx) {
+        qDebug() << "创建MuPDF上下文失败";
+        return 2;
+    }
+
+    fz_stream* stm = nullptr;
+    pdf_document* src = nullptr;
+    int result = 0;
+    fz_var(stm);
+    fz_var(src);
+
+    fz_try(ctx) {
+        stm = fz_open_memory(ctx, (const unsigned char*)pdfData.constData(), pdfData.size());
+        src = pdf_open_document_with_stream(ctx, stm);
+        // 每个工作线程有自己的输入文档，可以直接修改其注释
+        GraftAnnotations::detach(ctx, src);
+    }
+    fz_catch(ctx) {
+        qDebug() << "打开输入文档失败：" << fz_caught_message(ctx);
+        result = 2;
+    }
+
+    if (src && result == 0) {
+        int i;
+        while ((i = next.fetchAndAddRelaxed(1)) < outputs.size()) {
+            if (writeExtract(ctx, src, outputs[i]) != 0) {
+                result = 2;
+            }
+        }
+    }
+
+    pdf_drop_document(ctx, src);
+    fz_drop_stream(ctx, stm);
+    fz_drop_context(ctx);
+    return result;
+}
+
+/**
+ * @brief 合并时的一个输入文件
+ */
+struct OpenSource {
+    QByteArray path;                ///< UTF-8文件名，MuPDF在Windows上按UTF-8解释
+    bool tried = false;             ///< 是否已尝试打开
+    pdf_document* doc = nullptr;
+    pdf_graft_map* map = nullptr;
+    unsigned char* copied = nullptr;  ///< 按页序号标记注释已通过map复制过的页面
+};
+
+/**
+ * @brief 合并时的一个书签
+ */
+struct Bookmark {
+    QByteArray title;
+    QByteArray uri;  ///< "#page=N"，N为输出文档中的页码（从1开始）
+};
+
+/**
+ * @brief 按页码为合并结果创建一级书签
+ * @note 标题和uri在调用前准备好，fz_try中只调用C接口
+ */
+void addBookmarks(fz_context* ctx, pdf_document* dst, const QList<Bookmark>& bookmarks) {
+    if (bookmarks.isEmpty()) {
+        return;
+    }
+    fz_outline_iterator* it = nullptr;
+    fz_var(it);
+    fz_try(ctx) {
+        it = fz_new_outline_iterator(ctx, (fz_document*)dst);
+        for (const Bookmark& bookmark : bookmarks) {
+            fz_outline_item item = {};
+            item.title = (char*)bookmark.title.constData();
+            item.uri = (char*)bookmark.uri.constData();
+            item.is_open = 0;
+            fz_outline_iterator_insert(ctx, it, &item);
+        }
+    }
+    fz_always(ctx) { fz_drop_outline_iterator(ctx, it); }
+    fz_catch(ctx) {
+        // 书签创建失败不影响页面内容，记录后继续保存
+        qDebug() << "创建书签失败：" << fz_caught_message(ctx);
+    }
+}
+
+/**
+ * @brief 加载对象，失败时返回nullptr
+ */
+pdf_obj* loadObject(fz_context* ctx, pdf_document* doc, int num) {
+    pdf_obj* obj = nullptr;
+    fz_var(obj);
+    fz_try(ctx) { obj = pdf_load_object(ctx, doc, num); }
+    fz_catch(ctx) { obj = nullptr; }
+    return obj;
+}
+
+/**
+ * @brief 加载未解码的流数据，失败时返回nullptr
+ */
+fz_buffer* loadRawStream(fz_context* ctx, pdf_document* doc, int num) {
+    fz_buffer* buf = nullptr;
+    fz_var(buf);
+    fz_try(ctx) { buf = pdf_load_raw_stream_number(ctx, doc, num); }
+    fz_catch(ctx) { buf = nullptr; }
+    return buf;
+}
+
+/**
+ * @brief 判断流是否参与跨文档去重：字体程序、图片和ICC配置文件
+ *
+ * 图片以/Subtype /Image识别；TrueType、Type1字体程序带/Length1，
+ * FontFile3的/Subtype为Type1C、CIDFontType0C或OpenType；
+ * ICC配置文件带/N，且没有/Type和/Subtype。
+ */
+bool isSharedResource(fz_context* ctx, pdf_obj* dict) {
+    pdf_obj* subtype = pdf_dict_get(ctx, dict, PDF_NAME(Subtype));
+    if (pdf_name_eq(ctx, subtype, PDF_NAME(Image)) || pdf_dict_get(ctx, dict, PDF_NAME(Length1)) ||
+        pdf_name_eq(ctx, subtype, PDF_NAME(Type1C)) ||
+        pdf_name_eq(ctx, subtype, PDF_NAME(CIDFontType0C)) ||
+        pdf_name_eq(ctx, subtype, PDF_NAME(OpenType))) {
+        return true;
+    }
+    return !subtype && !pdf_dict_get(ctx, dict, PDF_NAME(Type)) &&
+           pdf_is_int(ctx, pdf_dict_get(ctx, dict, PDF_NAME(N)));
+}
+
+/**
+ * @brief 对象内容摘要
+ *
+ * 摘要覆盖对象本身和流的原始字节；间接引用按被引用对象的摘要展开，
+ * 因此来自不同输入、对象号不同但内容相同的资源得到相同的摘要，
+ * 例如引用同一ICC配置文件或同一SMask的两张图片。
+ */
+struct ContentDigests {
+    fz_context* ctx = nullptr;
+    pdf_document* doc = nullptr;
+    QHash<int, QByteArray> done;
+    QSet<int> visiting;
+
+    QByteArray of(int num) {
+        if (done.contains(num)) {
+            return done.value(num);
+        }
+        // 循环引用和无法读取的对象带上对象号，不会与其他对象相同
+        if (visiting.contains(num)) {
+            return "cycle:" + QByteArray::number(num);
+        }
+        pdf_obj* obj = loadObject(ctx, doc, num);
+        if (!obj) {
+            return "missing:" + QByteArray::number(num);
+        }
+        visiting.insert(num);
+        QByteArray data;
+        serialize(obj, data);
+        pdf_drop_obj(ctx, obj);
+
+        QCryptographicHash sha(QCryptographicHash::Sha256);
+        sha.addData(data);
+        if (pdf_obj_num_is_stream(ctx, doc, num)) {
+            fz_buffer* raw = loadRawStream(ctx, doc, num);
+            if (!raw) {
+                visiting.remove(num);
+                return "missing:" + QByteArray::number(num);
+            }
+            unsigned char* bytes = nullptr;
+            size_t len = fz_buffer_storage(ctx, raw, &bytes);
+            sha.addData((const char*)bytes, (int)len);
+            fz_drop_buffer(ctx, raw);
+        }
+        visiting.remove(num);
+
+        QByteArray digest = sha.result();
+        done.insert(num, digest);
+        return digest;
+    }
+
+    void serialize(pdf_obj* obj, QByteArray& out) {
+        if (!obj) {
+            out += "n";
+        } else if (pdf_is_indirect(ctx, obj)) {
+            out += "R" + of(pdf_to_num(ctx, obj));
+        } else if (pdf_is_name(ctx, obj)) {
+            out += "/" + QByteArray(pdf_to_name(ctx, obj));
+        } else if (pdf_is_int(ctx, obj)) {
+            out += "i" + QByteArray::number(pdf_to_int(ctx, obj));
+        } else if (pdf_is_real(ctx, obj)) {
+            out += "f" + QByteArray::number(pdf_to_real(ctx, obj), 'g', 9);
+        } else if (pdf_is_bool(ctx, obj)) {
+            out += pdf_to_bool(ctx, obj) ? "T" : "F";
+        } else if (pdf_is_string(ctx, obj)) {
+            const int len = (int)pdf_to_str_len(ctx, obj);
+            out += "s" + QByteArray::number(len) + ":" + QByteArray(pdf_to_str_buf(ctx, obj), len);
+        } else if (pdf_is_array(ctx, obj)) {
+            out += "[";
+            for (int i = 0; i < pdf_array_len(ctx, obj); i++) {
+                serialize(pdf_array_get(ctx, obj, i), out);
+            }
+            out += "]";
+        } else if (pdf_is_dict(ctx, obj)) {
+            // 键按名称排序，不同生成器写出的键顺序不影响摘要
+            QMap<QByteArray, pdf_obj*> entries;
+            for (int i = 0; i < pdf_dict_len(ctx, obj); i++) {
+                entries.insert(pdf_to_name(ctx, pdf_dict_get_key(ctx, obj, i)),
+                               pdf_dict_get_val(ctx, obj, i));
+            }
+            out += "<<";
+            for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+                out += "/" + it.key();
+                serialize(it.value(), out);
+            }
+            out += ">>";
+        } else {
+            out += "n";
+        }
+    }
+};
+
+/**
+ * @brief 把对象内指向重复资源的间接引用改指向保留的一份
+ */
+void remapReferences(fz_context* ctx, pdf_document* doc, pdf_obj* obj,
+                     const QHash<int, int>& replace) {
+    if (pdf_is_indirect(ctx, obj)) {
+        return;
+    }
+    if (pdf_is_array(ctx, obj)) {
+        for (int i = 0; i < pdf_array_len(ctx, obj); i++) {
+            pdf_obj* val = pdf_array_get(ctx, obj, i);
+            if (pdf_is_indirect(ctx, val) && replace.contains(pdf_to_num(ctx, val))) {
+                pdf_array_put_drop(ctx, obj, i,
+                                   pdf_new_indirect(ctx, doc, replace.value(pdf_to_num(ctx, val)), 0));
+            } else {
+                remapReferences(ctx, doc, val, replace);
+            }
+        }
+    } else if (pdf_is_dict(ctx, obj)) {
+        for (int i = 0; i < pdf_dict_len(ctx, obj); i++) {
+            pdf_obj* val = pdf_dict_get_val(ctx, obj, i);
+            if (pdf_is_indirect(ctx, val) && replace.contains(pdf_to_num(ctx, val))) {
+                pdf_dict_put_drop(ctx, obj, pdf_dict_get_key(ctx, obj, i),
+                                  pdf_new_indirect(ctx, doc, replace.value(pdf_to_num(ctx, val)), 0));
+            } else {
+                remapReferences(ctx, doc, val, replace);
+            }
+        }
+    }
+}
+
+/**
+ * @brief 改写一个对象中指向重复资源的引用
+ * @return 成功返回true，MuPDF出错时返回false
+ * @note 改写可能分配内存而抛出异常，在这里捕获，不越过调用方的Qt容器
+ */
+bool remapObject(fz_context* ctx, pdf_document* doc, int num, const QHash<int, int>& replace) {
+    pdf_obj* obj = loadObject(ctx, doc, num);
+    if (!obj) {
+        return true;
+    }
+    bool ok = true;
+    fz_try(ctx) { remapReferences(ctx, doc, obj, replace); }
+    fz_always(ctx) { pdf_drop_obj(ctx, obj); }
+    fz_catch(ctx) {
+        qDebug() << "改写资源引用失败：" << num << fz_caught_message(ctx);
+        ok = false;
+    }
+    return ok;
+}
+
+/**
+ * @brief 跨文档资源去重
+ *
+ * 每个输入使用独立的嫁接映射，多个文件中相同的信头图片、标志和嵌入字体
+ * 会各复制一份。这里按内容摘要找出重复的字体程序、图片和ICC配置文件，
+ * 把所有引用改指向第一份，不再被引用的副本在保存时由垃圾回收丢弃。
+ * 不抛出MuPDF异常：改写中途出错时停止去重，已改写的引用指向内容相同的
+ * 资源，文档仍然完整，只是少去掉一部分重复。
+ * @param savedBytes 输出去掉的重复流数据字节数（按/Length估算）
+ * @return 去掉的重复资源数，中途出错时为0
+ */
+int dedupeResources(fz_context* ctx, pdf_document* doc, qint64* savedBytes) {
+    ContentDigests digests;
+    digests.ctx = ctx;
+    digests.doc = doc;
+    QHash<QByteArray, int> kept;
+    QHash<int, int> replace;
+    qint64 saved = 0;
+
+    const int count = pdf_xref_len(ctx, doc);
+    for (int num = 1; num < count; num++) {
+        if (!pdf_obj_num_is_stream(ctx, doc, num)) {
+            continue;
+        }
+        pdf_obj* dict = loadObject(ctx, doc, num);
+        if (!dict) {
+            continue;
+        }
+        if (isSharedResource(ctx, dict)) {
+            const QByteArray digest = digests.of(num);
+            if (kept.contains(digest)) {
+                replace.insert(num, kept.value(digest));
+                saved += pdf_dict_get_int(ctx, dict, PDF_NAME(Length));
+            } else {
+                kept.insert(digest, num);
+            }
+        }
+        pdf_drop_obj(ctx, dict);
+    }
+
+    if (!replace.isEmpty()) {
+        for (int num = 1; num < count; num++) {
+            if (replace.contains(num)) {
+                continue;
+            }
+            if (!remapObject(ctx, doc, num, replace)) {
+                qDebug() << "跨文档资源去重中止";
+                replace.clear();
+                saved = 0;
+                break;
+            }
+        }
+    }
+
+    if (savedBytes) {
+        *savedBytes = saved;
+    }
+    return replace.size();
+}
+
+/**
+ * @brief 输出目录中以prefix开头的PDF文件总大小
+ */
+qint64 outputSize(const QString& dir, const QString& prefix) {
+    qint64 total = 0;
+    for (const QFileInfo& info : QDir(dir).entryInfoList(QStringList() << prefix + "*.pdf", QDir::Files)) {
+        total += info.size();
+    }
+    return total;
+}
+
+} // namespace
+
+/**
+ * @brief 从同一个输入提取多个输出文件
+ * @param pdfData 输入PDF的完整内容
+ * @param outputs 各输出文件及其页面范围
+ * @param workers 并发数，0表示使用CPU核心数
+ * @return 0表示全部成功，2表示有文件失败
+ */
+int extract(const QByteArray& pdfData, const QList<Extract>& outputs, int workers) {
+    if (pdfData.isEmpty() || outputs.isEmpty()) {
+        return 2;
+    }
+    if (workers <= 0) {
+        workers = QThread::idealThreadCount();
+    }
+    workers = std::min(workers, (int)outputs.size());
+    QAtomicInt next(0);
+    if (workers == 1) {
+        return extractWorker(pdfData, outputs, next);
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(workers);
+    QList<QFuture<int>> futures;
+    for (int w = 0; w < workers; w++) {
+        futures.append(QtConcurrent::run(&pool, [&]() {
+            return extractWorker(pdfData, outputs, next);
+        }));
+    }
+    int result = 0;
+    for (QFuture<int>& future : futures) {
+        if (future.result() != 0) {
+            result = 2;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief 按页面范围合并多个文件
+ * 同一文件只打开一次并共用一个嫁接映射，文件内多页引用的资源只复制一次；
+ * 不同文件中内容相同的字体程序、图片和ICC配置文件在保存前合并为一份
+ * @param sources 输入列表
+ * @param outFile 输出PDF文件路径
+ * @return 0表示成功，2表示失败
+ */
+int merge(const QList<MergeSource>& sources, const QString& outFile) {
+    // 文件名、页面范围和书签标题在进入fz_try之前准备好：MuPDF出错时以longjmp
+    // 跳出，fz_try中构造的C++对象不会被析构
+    const int count = sources.size();
+    QVector<OpenSource> opened;
+    QVector<int> fileOf(count);
+    QList<QList<PageRange>> rangesOf;
+    QHash<QString, int> fileIndex;
+    for (int i = 0; i < count; i++) {
+        const MergeSource& source = sources[i];
+        if (!fileIndex.contains(source.file)) {
+            fileIndex.insert(source.file, opened.size());
+            OpenSource entry;
+            entry.path = source.file.toUtf8();
+            opened.append(entry);
+        }
+        fileOf[i] = fileIndex.value(source.file);
+        QList<PageRange> ranges = source.ranges;
+        if (ranges.isEmpty()) {
+            PageRange all;
+            all.end = std::numeric_limits<int>::max();  // appendRanges按实际页数截断
+            ranges.append(all);
+        }
+        rangesOf.append(ranges);
+    }
+    QVector<int> firstPage(count, 0);
+    QVector<int> pagesOf(count, 0);
+    // fz_try中只通过指针访问，不会触发容器的写时复制
+    OpenSource* files = opened.data();
+    const int fileCount = opened.size();
+    const int* fileOfSource = fileOf.constData();
+    int* first = firstPage.data();
+    int* pages = pagesOf.data();
+
+    fz_context* ctx = fz_new_context(NULL, NULL, FZ_STORE_DEFAULT);
+    if (!ctx) {
+        qDebug() << "创建MuPDF上下文失败";
+        return 2;
+    }
+
+    pdf_document* dst = nullptr;
+    fz_buffer* buf = nullptr;
+    int written = 0;
+    int removed = 0;
+    qint64 saved = 0;
+    int result = 0;
+    fz_var(dst);
+    fz_var(buf);
+    fz_var(written);
+    fz_var(result);
+
+    fz_try(ctx) {
+        dst = pdf_create_document(ctx);
+        for (int i = 0; i < count; i++) {
+            OpenSource* entry = &files[fileOfSource[i]];
+            if (!entry->tried) {
+                entry->tried = true;
+                // 在fz_try中赋值、在fz_catch之后读取的局部变量需要fz_var
+                pdf_document* doc = nullptr;
+                pdf_graft_map* map = nullptr;
+                unsigned char* copied = nullptr;
+                fz_var(doc);
+                fz_var(map);
+                fz_var(copied);
+                fz_try(ctx) {
+                    doc = pdf_open_document(ctx, entry->path.constData());
+                    // 输入只在合并期间打开，不保存，可以直接修改其注释
+                    GraftAnnotations::detach(ctx, doc);
+                    copied = (unsigned char*)fz_calloc(ctx, pdf_count_pages(ctx, doc), 1);
+                    map = pdf_new_graft_map(ctx, dst);
+                }
+                fz_catch(ctx) {
+                    // 与PDI后端一致，打不开的输入跳过
+                    fz_warn(ctx, "cannot open %s: %s", entry->path.constData(),
+                            fz_caught_message(ctx));
+                }
+                entry->doc = doc;
+                entry->map = map;
+                entry->copied = copied;
+            }
+            if (!entry->map) {
+                continue;
+            }
+
+            first[i] = written;
+            pages[i] = appendRanges(ctx, entry->map, dst, entry->doc, rangesOf.at(i),
+                                    entry->copied);
+            written += pages[i];
+        }
+    }
+    fz_always(ctx) {
+        // 页面和流数据已复制到输出，先关闭输入，输出可以覆盖原文件
+        for (int f = 0; f < fileCount; f++) {
+            fz_free(ctx, files[f].copied);
+            pdf_drop_graft_map(ctx, files[f].map);
+            pdf_drop_document(ctx, files[f].doc);
+            files[f].copied = nullptr;
+            files[f].map = nullptr;
+            files[f].doc = nullptr;
+        }
+    }
+    fz_catch(ctx) {
+        qDebug() << "合并失败：" << outFile << fz_caught_message(ctx);
+        result = 2;
+    }
+
+    if (result == 0 && written == 0) {
+        qDebug() << "没有可合并的页面";
+        result = 2;
+    }
+
+    if (result == 0) {
+        QList<Bookmark> bookmarks;
+        for (int i = 0; i < count; i++) {
+            if (pagesOf[i] > 0 && !sources[i].bookmark.isEmpty()) {
+                Bookmark bookmark;
+                bookmark.title = sources[i].bookmark.toUtf8();
+                bookmark.uri = "#page=" + QByteArray::number(firstPage[i] + 1);
+                bookmarks.append(bookmark);
+            }
+        }
+        addBookmarks(ctx, dst, bookmarks);
+        // 去重自行处理MuPDF异常，不放在fz_try中
+        removed = dedupeResources(ctx, dst, &saved);
+
+        fz_try(ctx) {
+            buf = writeToBuffer(ctx, dst);
+        }
+        fz_catch(ctx) {
+            qDebug() << "合并失败：" << outFile << fz_caught_message(ctx);
+            result = 2;
+        }
+    }
+    if (removed > 0) {
+        qDebug() << "跨文档资源去重：" << removed << "个，约" << saved / 1024 << "KB";
+    }
+
+    if (buf && !saveBuffer(ctx, buf, outFile)) {
+        qDebug() << "写出合并文件失败：" << outFile;
+        result = 2;
+    }
+    fz_drop_buffer(ctx, buf);
+    pdf_drop_document(ctx, dst);
+    fz_drop_context(ctx);
+    return result;
+}
+
+/**
+ * @brief 在相同输入上对比PDI与对象嫁接两种后端
+ * 合并全部输入、按页数拆分第一个输入，各后端分别计时并统计输出大小
+ * @param inputs 输入PDF文件列表
+ * @param workDir 输出目录
+ * @param subpages 拆分时每个文件的页数
+ * @return 制表符分隔的报告
+ */
+QString benchmark(const QStringList& inputs, const QString& workDir, int subpages) {
+    QString report;
+    if (inputs.isEmpty()) {
+        return report;
+    }
+    FileSystemUtils::createDirectory(workDir);
+
+    QList<MergeSource> sources;
+    int mergePages = 0;
+    for (const QString& input : inputs) {
+        MergeSource source;
+        source.file = input;
+        source.bookmark = QFileInfo(input).fileName();
+        sources.append(source);
+        mergePages += PdfOperations::getPages(input.toStdString());
+    }
+    const int splitPages = PdfOperations::getPages(inputs.first().toStdString());
+
+    QTextStream out(&report);
+    out << "操作\t后端\t结果\t耗时(ms)\t页/秒\t输出大小(KB)\n";
+    const CopyBackend backends[] = {CopyBackend::Pdi, CopyBackend::Graft};
+    for (CopyBackend backend : backends) {
+        const QString name = (backend == CopyBackend::Pdi) ? "pdi" : "graft";
+
+        const QString mergePrefix = "bench_merge_" + name;
+        QFile::remove(workDir + "/" + mergePrefix + ".pdf");
+        QElapsedTimer timer;
+        timer.start();
+        int result = PdfOperations::mergePdf(sources, workDir + "/" + mergePrefix + ".pdf", backend);
+        qint64 ms = std::max<qint64>(1, timer.elapsed());
+        out << "合并\t" << name << "\t" << result << "\t" << ms << "\t"
+            << mergePages * 1000 / ms << "\t" << outputSize(workDir, mergePrefix) / 1024 << "\n";
+
+        const QString splitPrefix = "bench_split_" + name;
+        for (const QFileInfo& old : QDir(workDir).entryInfoList(QStringList() << splitPrefix + "_*.pdf", QDir::Files)) {
+            QFile::remove(old.absoluteFilePath());
+        }
+        timer.restart();
+        result = PdfOperations::splitPdfChunks(inputs.first(), workDir + "/" + splitPrefix, subpages,
+                                               0, -1, 0, backend);
+        ms = std::max<qint64>(1, timer.elapsed());
+        out << "拆分\t" << name << "\t" << result << "\t" << ms << "\t"
+            << splitPages * 1000 / ms << "\t" << outputSize(workDir, splitPrefix + "_") / 1024 << "\n";
+    }
+    return report;
+}
+
+} // namespace GraftCopy
@@ -0,0 +1,553 @@
+/**
+ * @file ImageBatch.cpp
+ * @brief 批量图片转PDF模块实现
+ *
+ * 工作线程从共享的原子序号中领取下一个图片，负载自动均衡；
+ * 每个线程的PDFlib对象保存在QThreadStorage中，线程退出时释放。
+ * PDFlib发生异常后对象不能再使用，此时丢弃并在下次调用时重建。
+ *
+ * 嵌入方式由文件头决定：JPEG显式要求直通；PNG只有非隔行、
+ * 每通道不超过8位且没有Alpha通道时PDFlib才能直接使用IDAT数据，
+ * 其他情况和BMP等格式由PDFlib解码后按文档的Flate级别重新压缩。
+ * 设置了分辨率上限且图片超出时，用QImage解码、ImageResample缩小，
+ * 再通过PVF交给PDFlib，缩小在各工作线程中进行。
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma execution_character_set("utf-8") // 设置编译器使用UTF-8字符集
+#include "include/function/ImageBatch.h"
+
+#include <QAtomicInt>
+#include <QBuffer>
+#include <QDebug>
+#include <QFile>
+#include <QImage>
+#include <QList>
+#include <QMap>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+#include <QThreadStorage>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+#include "include/function/BoundedQueue.h"
+#include "include/function/ImageResample.h"
+#include "include/function/StringConverter.h"
+#include "include/mark/mark.h" // 包含GetFontsFolder函数声明
+#include "lib/pdflib.hpp"
+
+using namespace std;
+using namespace pdflib;
+
+namespace ImageBatch {
+
+namespace {
+
+/**
+ * @brief 合并模式下一个解码完成的页面
+ */
+struct PageItem {
+    int index = 0;     ///< 图片在列表中的序号
+    QByteArray pdf;    ///< 单页PDF，解码失败时为空
+};
+
+/**
+ * @brief 文档选项：转码的图片只用最快的Flate级别压缩一次
+ *
+ * 直通的图片数据不受该选项影响；大图片在级别1和默认级别6之间体积相差很小，
+ * 压缩耗时却相差数倍。
+ */
+const wchar_t* const kDocumentOptions = L"compress=1";
+
+/**
+ * @brief 缩小后的图片所用的虚拟文件名，每个PDFlib对象同时只有一个
+ */
+const wchar_t* const kResampledPvf = L"/pvf/image/resampled";
+
+/**
+ * @brief JPEG缩小后重新编码的质量
+ */
+const int kJpegQuality = 85;
+
+/**
+ * @brief 多个工作线程共用的嵌入方式计数
+ */
+struct Counters {
+    QAtomicInt expectedPassthrough;
+    QAtomicInt transcoded;
+    QAtomicInt downsampled;
+    QAtomicInt failed;
+
+    void fill(Stats* stats) const {
+        if (stats) {
+            stats->expectedPassthrough = expectedPassthrough.loadRelaxed();
+            stats->transcoded = transcoded.loadRelaxed();
+            stats->downsampled = downsampled.loadRelaxed();
+            stats->failed = failed.loadRelaxed();
+        }
+    }
+};
+
+/**
+ * @brief 图片的嵌入方式
+ */
+enum class Embedding {
+    JpegPassthrough, ///< JPEG，DCT数据原样复制
+    PngPassthrough,  ///< PNG，IDAT数据原样复制
+    Transcode        ///< 解码后重新压缩
+};
+
+/**
+ * @brief 读取文件头判断图片能否原样嵌入
+ */
+Embedding embeddingFor(const QString& imageFile) {
+    QFile file(imageFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return Embedding::Transcode;
+    }
+    const QByteArray head = file.read(29);
+    const uchar* h = (const uchar*)head.constData();
+    if (head.size() >= 3 && h[0] == 0xFF && h[1] == 0xD8 && h[2] == 0xFF) {
+        return Embedding::JpegPassthrough;
+    }
+    // PNG签名之后第一个块必须是IHDR：位深度、颜色类型、隔行标志分别位于第24、25、28字节
+    if (head.size() >= 29 && head.startsWith("\x89PNG\r\n\x1a\n") && head.mid(12, 4) == "IHDR") {
+        const int bitDepth = h[24];
+        const int colorType = h[25];
+        const int interlace = h[28];
+        // 颜色类型4、6带Alpha通道，需要拆分为软蒙版，不能直通
+        if (interlace == 0 && bitDepth <= 8 &&
+            (colorType == 0 || colorType == 2 || colorType == 3)) {
+            return Embedding::PngPassthrough;
+        }
+    }
+    return Embedding::Transcode;
+}
+
+QThreadStorage<PDFlib*> g_pdflib;
+
+/**
+ * @brief 获取当前线程的PDFlib对象，首次使用时创建并设置搜索路径
+ */
+PDFlib& threadPdflib() {
+    if (!g_pdflib.hasLocalData() || !g_pdflib.localData()) {
+        PDFlib* p = new PDFlib();
+        const wstring searchpath = L"./PDFlib-CMap-5.0/resource/cmap";
+        wostringstream optlist;
+        optlist << L"searchpath={{" << searchpath << L"}";
+        optlist << L" {" << GetFontsFolder() << L"}}";
+        p->set_option(optlist.str());
+        g_pdflib.setLocalData(p);
+    }
+    return *g_pdflib.localData();
+}
+
+/**
+ * @brief 丢弃当前线程的PDFlib对象（发生过异常或需要放弃未完成的文档）
+ */
+void resetThreadPdflib() {
+    g_pdflib.setLocalData(nullptr);
+}
+
+/**
+ * @brief 输出PDFlib异常信息
+ */
+void reportException(PDFlib::Exception& ex) {
+    wcerr << L"PDFlib 发生异常: " << endl
+          << L"[" << ex.get_errnum() << L"] " << ex.get_apiname() << L": "
+          << ex.get_errmsg() << endl;
+}
+
+/**
+ * @brief 解码并缩小图片，通过虚拟文件载入PDFlib
+ * @param scale 缩放比例（0~1）
+ * @param data 虚拟文件的数据，页面结束并删除虚拟文件后才能释放
+ * @return 图片句柄，无法缩小时返回-1且不保留虚拟文件
+ */
+int loadResampled(PDFlib& p, const QString& imageFile, Embedding embedding, double scale,
+                  QByteArray* data) {
+    QImage source(imageFile);
+    if (source.isNull() || source.hasAlphaChannel()) {
+        return -1;
+    }
+    const bool gray = source.isGrayscale();
+    const QImage::Format format = gray ? QImage::Format_Grayscale8 : QImage::Format_RGB888;
+    const int components = gray ? 1 : 3;
+    source = source.convertToFormat(format);
+    int width = 0;
+    int height = 0;
+    ImageResample::scaledSize(source.width(), source.height(), scale, &width, &height);
+    QByteArray pixels = ImageResample::downsample(source.constBits(), source.width(),
+                                                  source.height(), source.bytesPerLine(),
+                                                  components, width, height);
+    source = QImage();
+    if (pixels.isEmpty()) {
+        return -1;
+    }
+
+    wstring type = L"raw";
+    wostringstream optlist;
+    if (embedding == Embedding::JpegPassthrough) {
+        // 原图是JPEG时仍以JPEG嵌入，避免缩小后的照片按无损数据存储
+        QImage small((const uchar*)pixels.constData(), width, height, width * components, format);
+        QBuffer buffer(data);
+        buffer.open(QIODevice::WriteOnly);
+        if (!small.save(&buffer, "JPG", kJpegQuality)) {
+            data->clear();
+            return -1;
+        }
+        type = L"jpeg";
+        optlist << L"passthrough=true";
+    } else {
+        *data = pixels;
+        optlist << L"width=" << width << L" height=" << height
+                << L" components=" << components << L" bpc=8";
+    }
+    p.create_pvf(kResampledPvf, data->constData(), data->size(), L"");
+    int image = p.load_image(type, kResampledPvf, optlist.str());
+    if (image == -1) {
+        wcerr << L"Error: " << p.get_errmsg() << endl;
+        p.delete_pvf(kResampledPvf);
+        data->clear();
+    }
+    return image;
+}
+
+/**
+ * @brief 在已开始的文档中写入一页图片
+ * @param maxDpi 分辨率上限，0表示页面大小等于图片尺寸
+ * @return 图片无法加载时返回false
+ */
+bool writeImagePage(PDFlib& p, const QString& imageFile, Counters* counters, int maxDpi) {
+    p.set_info(L"Creator", L"泛生态业务工具集");
+    p.set_info(L"Title", L"本文档来自于泛生态业务投标案例");
+    const Embedding embedding = embeddingFor(imageFile);
+    int image = p.load_image(L"auto", StringConverter::QString2WString(imageFile),
+                             embedding == Embedding::JpegPassthrough ? L"passthrough=true" : L"");
+    if (image == -1) {
+        wcerr << L"Error: " << p.get_errmsg() << endl;  // 图片加载失败
+        if (counters) {
+            counters->failed.fetchAndAddRelaxed(1);
+        }
+        return false;
+    }
+    double imagewidth = p.info_image(image, L"width", L"");
+    double imageheight = p.info_image(image, L"height", L"");
+    double pagewidth = imagewidth;  // 默认创建与图片尺寸相同的页面
+    double pageheight = imageheight;
+    QByteArray resampled;
+
+    const double longEdge = std::max(imagewidth, imageheight);
+    if (maxDpi > 0 && longEdge > ImageResample::kPageLongEdge) {
+        const double scale = ImageResample::kPageLongEdge / longEdge;
+        pagewidth = imagewidth * scale;
+        pageheight = imageheight * scale;
+        // 页面长边对应的像素上限
+        const double maxPixels = maxDpi * ImageResample::kPageLongEdge / 72;
+        if (longEdge > maxPixels) {
+            int small = loadResampled(p, imageFile, embedding, maxPixels / longEdge, &resampled);
+            if (small != -1) {
+                p.close_image(image);
+                image = small;
+            }
+        }
+    }
+
+    if (counters) {
+        QAtomicInt& counter = !resampled.isEmpty()                 ? counters->downsampled
+                              : embedding == Embedding::Transcode ? counters->transcoded
+                                                                  : counters->expectedPassthrough;
+        counter.fetchAndAddRelaxed(1);
+    }
+    wostringstream fitlist;
+    fitlist << L"boxsize={" << pagewidth << L" " << pageheight << L"} fitmethod=meet";
+    p.begin_page_ext(pagewidth, pageheight, L"");
+    p.fit_image(image, 0, 0, fitlist.str());
+    p.close_image(image);
+    p.end_page_ext(L"");
+    if (!resampled.isEmpty()) {
+        p.delete_pvf(kResampledPvf);  // 图片已写入输出，释放虚拟文件
+    }
+    return true;
+}
+
+/**
+ * @brief 把单个图片转换为PDF文件
+ * @return 0: 成功, 2: 失败
+ */
+int convertOne(const QString& imageFile, const QString& pdfFile, Counters* counters,
+               int maxDpi) {
+    PDFlib& p = threadPdflib();
+    try {
+        if (p.begin_document(StringConverter::QString2WString(pdfFile), kDocumentOptions) == -1) {
+            wcerr << L"Error: " << p.get_errmsg() << endl;
+            return 2;
+        }
+        if (!writeImagePage(p, imageFile, counters, maxDpi)) {
+            // 没有页面的文档不能正常结束，丢弃PDFlib对象即放弃该文档
+            resetThreadPdflib();
+            QFile::remove(pdfFile);
+            return 2;
+        }
+        p.end_document(L"");
+        return 0;
+    } catch (PDFlib::Exception& ex) {
+        reportException(ex);
+        resetThreadPdflib();
+        return 2;
+    }
+}
+
+/**
+ * @brief 把单个图片转换为只有一页的内存PDF
+ */
+QByteArray renderPage(const QString& imageFile, Counters* counters, int maxDpi) {
+    PDFlib& p = threadPdflib();
+    try {
+        // 文件名为空时输出到内存，结束后用get_buffer取出
+        if (p.begin_document(L"", kDocumentOptions) == -1) {
+            wcerr << L"Error: " << p.get_errmsg() << endl;
+            return QByteArray();
+        }
+        if (!writeImagePage(p, imageFile, counters, maxDpi)) {
+            resetThreadPdflib();
+            return QByteArray();
+        }
+        p.end_document(L"");
+        long len = 0;
+        const char* data = p.get_buffer(&len);
+        return QByteArray(data, (int)len);
+    } catch (PDFlib::Exception& ex) {
+        reportException(ex);
+        resetThreadPdflib();
+        return QByteArray();
+    }
+}
+
+/**
+ * @brief 进度计数并回调
+ */
+void advance(QAtomicInt& done, int total, const Progress& progress) {
+    int n = done.fetchAndAddRelaxed(1) + 1;
+    if (progress) {
+        progress(n, total);
+    }
+}
+
+} // namespace
+
+/**
+ * @brief 生成一行便于记录日志的摘要
+ * @return 如"预计直通 118 转码 2 降采样 0 失败 0 跳过 0"
+ */
+QString Stats::summary() const {
+    return QString("预计直通 %1 转码 %2 降采样 %3 失败 %4 跳过 %5")
+        .arg(expectedPassthrough)
+        .arg(transcoded)
+        .arg(downsampled)
+        .arg(failed)
+        .arg(skipped);
+}
+
+/**
+ * @brief 把单个图片转换为只有一页的内存PDF
+ * @param imageFile 图片文件路径
+ * @param maxDpi 分辨率上限，0表示不限制
+ * @return PDF文件内容，失败时返回空数组
+ */
+QByteArray imagePage(const QString& imageFile, int maxDpi) {
+    return renderPage(imageFile, nullptr, maxDpi);
+}
+
+/**
+ * @brief 把单个图片转换为PDF文件
+ * @param imageFile 图片文件路径
+ * @param pdfFile 输出PDF文件路径
+ * @param stats 输出嵌入方式统计
+ * @param maxDpi 分辨率上限，0表示不限制
+ * @return 0: 成功, 2: 失败
+ */
+int convertFile(const QString& imageFile, const QString& pdfFile, Stats* stats,
+                int maxDpi) {
+    Counters counters;
+    int result = convertOne(imageFile, pdfFile, &counters, maxDpi);
+    counters.fill(stats);
+    return result;
+}
+
+/**
+ * @brief 把每个图片分别转换为PDF
+ * @param images 图片文件路径列表
+ * @param workers 工作线程数，0表示使用CPU核心数
+ * @param progress 进度回调
+ * @param stats 输出嵌入方式统计
+ * @param maxDpi 分辨率上限，0表示不限制
+ * @return 成功转换的图片数
+ *
+ * 每个工作线程在整个批次中只领取任务、不退出，PDFlib对象随线程复用。
+ */
+int convertEach(const QStringList& images, int workers, const Progress& progress,
+                Stats* stats, int maxDpi) {
+    if (workers <= 0) {
+        workers = QThread::idealThreadCount();
+    }
+    const int total = images.size();
+    QAtomicInt next(0);
+    QAtomicInt done(0);
+    QAtomicInt succeeded(0);
+    Counters counters;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(workers);
+    QList<QFuture<void>> futures;
+    for (int w = 0; w < qMin(workers, total); w++) {
+        futures.append(QtConcurrent::run(&pool, [&]() {
+            int i;
+            while ((i = next.fetchAndAddRelaxed(1)) < total) {
+                if (convertOne(images[i], images[i] + ".pdf", &counters, maxDpi) == 0) {
+                    succeeded.fetchAndAddRelaxed(1);
+                }
+                advance(done, total, progress);
+            }
+        }));
+    }
+    for (QFuture<void>& future : futures) {
+        future.waitForFinished();
+    }
+    counters.fill(stats);
+    return succeeded.loadRelaxed();
+}
+
+/**
+ * @brief 把图片列表按顺序合并为一个多页PDF
+ * @param images 图片文件路径列表
+ * @param pdfFile 输出PDF文件路径
+ * @param workers 解码线程数，0表示使用CPU核心数
+ * @param progress 进度回调
+ * @param stats 输出嵌入方式统计
+ * @param maxDpi 分辨率上限，0表示不限制
+ * @return 0: 成功, 2: 失败（包括有图片被跳过）
+ *
+ * 工作线程领取序号前先占用一个窗口名额，写入线程每写完一页归还一个，
+ * 因此已解码未写入的页面不超过窗口大小，与图片总数无关。
+ * 单页PDF通过PVF交给PDI导入，图片数据按原样复制，不再重新编码。
+ */
+int combine(const QStringList& images, const QString& pdfFile, int workers,
+            const Progress& progress, Stats* stats, int maxDpi) {
+    if (workers <= 0) {
+        workers = QThread::idealThreadCount();
+    }
+    const int total = images.size();
+    if (total == 0) {
+        return 2;
+    }
+    const int window = workers * 2;
+    QAtomicInt next(0);
+    QAtomicInt done(0);
+    QAtomicInt aborted(0);
+    QSemaphore room(window);
+    BoundedQueue<PageItem> decoded(window);
+    Counters counters;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(workers);
+    QAtomicInt running(qMin(workers, total));
+    QList<QFuture<void>> futures;
+    for (int w = 0; w < qMin(workers, total); w++) {
+        futures.append(QtConcurrent::run(&pool, [&]() {
+            while (true) {
+                room.acquire();
+                int i = next.fetchAndAddRelaxed(1);
+                if (i >= total || aborted.loadRelaxed()) {
+                    break;
+                }
+                PageItem item;
+                item.index = i;
+                item.pdf = renderPage(images[i], &counters, maxDpi);
+                if (!decoded.push(item)) {
+                    break;
+                }
+            }
+            if (!running.deref()) {
+                decoded.close();
+            }
+        }));
+    }
+
+    PDFlib p;
+    int result = 0;
+    int written = 0;  // 已处理（写入或跳过）的序号
+    int placed = 0;   // 实际写入输出的页数
+    try {
+        if (p.begin_document(StringConverter::QString2WString(pdfFile), L"") == -1) {
+            wcerr << L"Error: " << p.get_errmsg() << endl;
+            result = 2;
+        } else {
+            p.set_info(L"Creator", L"泛生态业务工具集");
+            p.set_info(L"Title", L"本文档来自于泛生态业务投标案例");
+
+            QMap<int, QByteArray> pending;
+            PageItem item;
+            while (written < total && decoded.pop(&item)) {
+                pending.insert(item.index, item.pdf);
+                while (pending.contains(written)) {
+                    QByteArray page = pending.take(written);
+                    if (page.isEmpty()) {
+                        qDebug() << "图片无法转换，已跳过：" << images[written];
+                    } else {
+                        const wstring pvf = L"/pvf/image/" + to_wstring(written);
+                        p.create_pvf(pvf, page.constData(), page.size(), L"");
+                        int indoc = p.open_pdi_document(pvf, L"");
+                        int pdiPage = indoc == -1 ? -1 : p.open_pdi_page(indoc, 1, L"");
+                        if (pdiPage == -1) {
+                            wcerr << L"Error: " << p.get_errmsg() << endl;
+                            qDebug() << "图片无法导入，已跳过：" << images[written];
+                        } else {
+                            p.begin_page_ext(0, 0, L"width=a4.width height=a4.height");
+                            p.fit_pdi_page(pdiPage, 0, 0, L"adjustpage");
+                            p.close_pdi_page(pdiPage);
+                            p.end_page_ext(L"");
+                            placed++;
+                        }
+                        if (indoc != -1) {
+                            p.close_pdi_document(indoc);
+                        }
+                        p.delete_pvf(pvf);
+                    }
+                    written++;
+                    room.release();
+                    advance(done, total, progress);
+                }
+            }
+            p.end_document(L"");
+        }
+    } catch (PDFlib::Exception& ex) {
+        reportException(ex);
+        result = 2;
+    }
+
+    // 写入失败时让工作线程尽快退出：关闭队列并放行所有等待窗口的线程
+    aborted.storeRelaxed(1);
+    decoded.close();
+    room.release(workers + window);
+    for (QFuture<void>& future : futures) {
+        future.waitForFinished();
+    }
+    // 文档没有正常结束时输出无效，全部按跳过计
+    const int skipped = result == 0 ? total - placed : total;
+    if (skipped > 0) {
+        result = 2;
+    }
+    counters.fill(stats);
+    if (stats) {
+        stats->skipped = skipped;
+    }
+    return result;
+}
+
+} // namespace ImageBatch
@@ -0,0 +1,81 @@
+/**
+ * @file MemoryBudget.cpp
+ * @brief 内存预算模块实现
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma execution_character_set("utf-8") // 设置编译器使用UTF-8字符集
+#include "include/function/MemoryBudget.h"
+
+#include <QMutexLocker>
+#include <algorithm>
+
+MemoryBudget::MemoryBudget(qint64 limit) : m_limit(limit) {}
+
+MemoryBudget* MemoryBudget::shared() {
+    static MemoryBudget budget(kDefaultLimit);
+    return &budget;
+}
+
+void MemoryBudget::setLimit(qint64 limit) {
+    QMutexLocker locker(&m_mutex);
+    m_limit = limit;
+    m_released.wakeAll();
+}
+
+qint64 MemoryBudget::limit() const {
+    QMutexLocker locker(&m_mutex);
+    return m_limit;
+}
+
+/**
+ * @brief 判断请求能否满足，调用方需持有m_mutex
+ *
+ * 没有任何占用时总是允许，超过上限的单个请求因此不会永久阻塞。
+ */
+bool MemoryBudget::fits(qint64 bytes) const {
+    return m_used == 0 || m_used + bytes <= m_limit;
+}
+
+void MemoryBudget::acquire(qint64 bytes) {
+    QMutexLocker locker(&m_mutex);
+    while (!fits(bytes)) {
+        m_released.wait(&m_mutex);
+    }
+    m_used += bytes;
+    m_peak = std::max(m_peak, m_used);
+}
+
+bool MemoryBudget::tryAcquire(qint64 bytes) {
+    QMutexLocker locker(&m_mutex);
+    if (!fits(bytes)) {
+        return false;
+    }
+    m_used += bytes;
+    m_peak = std::max(m_peak, m_used);
+    return true;
+}
+
+void MemoryBudget::charge(qint64 bytes) {
+    QMutexLocker locker(&m_mutex);
+    m_used += bytes;
+    m_peak = std::max(m_peak, m_used);
+}
+
+void MemoryBudget::release(qint64 bytes) {
+    QMutexLocker locker(&m_mutex);
+    m_used -= bytes;
+    m_released.wakeAll();
+}
+
+qint64 MemoryBudget::used() const {
+    QMutexLocker locker(&m_mutex);
+    return m_used;
+}
+
+qint64 MemoryBudget::peak() const {
+    QMutexLocker locker(&m_mutex);
+    return m_peak;
+}
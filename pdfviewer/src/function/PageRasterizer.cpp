@@ -0,0 +1,404 @@
+/**
+ * @file PageRasterizer.cpp
+ * @brief 单文档分页并行栅格化模块实现
+ *
+ * 调用线程负责打开文档、生成显示列表和按顺序消费结果，
+ * 工作线程只做显示列表到像素数据的渲染，互不访问文档对象。
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma execution_character_set("utf-8") // 设置编译器使用UTF-8字符集
+#include "include/function/PageRasterizer.h"
+
+#include <QDebug>
+#include <QList>
+#include <QQueue>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+
+#include "include/function/DisplayListCache.h"
+
+namespace PageRasterizer {
+
+namespace {
+
+/**
+ * @brief 显示列表来源
+ *
+ * 返回第page页（从0开始）已增加引用的显示列表并输出页面显示区域，
+ * 失败时返回nullptr，不抛出MuPDF异常。
+ */
+typedef std::function<fz_display_list*(fz_context* ctx, int page, fz_rect* bounds)>
+    ListSource;
+
+/**
+ * @brief 一个条带的渲染任务
+ */
+struct BandJob {
+    fz_display_list* list = nullptr;  ///< 持有一个显示列表引用
+    Band band;
+    qint64 bytes = 0;  ///< 从预算中申请的像素数据字节数
+    QFuture<fz_pixmap*> future;
+};
+
+/**
+ * @brief 在工作线程中把显示列表渲染到条带区域
+ *
+ * 每个任务使用一个从缓存基础上下文克隆的上下文，克隆只复制异常栈等线程相关状态，
+ * 资源缓存和内存分配器与基础上下文共享。像素数据只分配条带大小，
+ * 显示列表按条带区域裁剪执行。
+ */
+fz_pixmap* renderBand(fz_display_list* list, fz_matrix ctm, fz_irect area) {
+    fz_context* ctx = DisplayListCache::instance()->newContext();
+    if (!ctx) {
+        return nullptr;
+    }
+    fz_pixmap* pix = nullptr;
+    fz_device* dev = nullptr;
+    fz_var(pix);
+    fz_var(dev);
+    fz_try(ctx) {
+        pix = fz_new_pixmap_with_bbox(ctx, fz_device_rgb(ctx), area, NULL, 0);
+        fz_clear_pixmap_with_value(ctx, pix, 0xFF);
+        dev = fz_new_draw_device(ctx, fz_identity, pix);
+        fz_run_display_list(ctx, list, dev, ctm, fz_rect_from_irect(area), NULL);
+        fz_close_device(ctx, dev);
+    }
+    fz_always(ctx) { fz_drop_device(ctx, dev); }
+    fz_catch(ctx) {
+        qDebug() << "渲染页面失败：" << fz_caught_message(ctx);
+        fz_drop_pixmap(ctx, pix);
+        pix = nullptr;
+    }
+    fz_drop_context(ctx);
+    return pix;
+}
+
+/**
+ * @brief 检测页面是否含彩色内容
+ *
+ * 用MuPDF的测试设备执行显示列表，只判断颜色、不生成像素。
+ * 分条带的页面据此在各条带之间统一编码方式。
+ * @return 含彩色内容或检测失败时返回true
+ */
+bool pageHasColor(fz_context* ctx, fz_display_list* list) {
+    int color = 0;
+    fz_device* dev = nullptr;
+    fz_var(color);
+    fz_var(dev);
+    fz_try(ctx) {
+        // 阈值与RasterAnalysis::kGrayTolerance（12/255）相当
+        dev = fz_new_test_device(ctx, &color, 0.05f,
+                                 FZ_TEST_OPT_IMAGES | FZ_TEST_OPT_SHADINGS, NULL);
+        fz_run_display_list(ctx, list, dev, fz_identity, fz_infinite_rect, NULL);
+        fz_close_device(ctx, dev);
+    }
+    fz_always(ctx) { fz_drop_device(ctx, dev); }
+    fz_catch(ctx) {
+        // 测试设备发现彩色后以异常中止执行，与其他错误一样按彩色处理
+        color = 1;
+    }
+    return color != 0;
+}
+
+/**
+ * @brief 计算页面的条带高度
+ * @param bandHeight 调用方指定的条带高度，含义见rasterizeBands
+ * @return 条带高度（像素），整页不分条带时返回页面高度
+ */
+int bandRows(fz_irect pageArea, int bandHeight) {
+    int rows = std::max(pageArea.y1 - pageArea.y0, 1);
+    if (bandHeight > 0) {
+        return bandHeight;
+    }
+    qint64 rowBytes = (qint64)std::max(pageArea.x1 - pageArea.x0, 1) * 3;
+    if (bandHeight == 0 || rowBytes * rows <= kAutoBandBytes) {
+        return rows;
+    }
+    // 自动模式：条带高度取16的倍数，JPEG编码时条带边界与8x8/16x16块对齐
+    int step = (int)(kAutoBandBytes / rowBytes) / 16 * 16;
+    return std::max(step, 16);
+}
+
+/**
+ * @brief 等待队首条带完成并交给处理函数
+ * @return 处理函数返回值，渲染失败时返回false
+ */
+bool emitFront(fz_context* ctx, QQueue<BandJob>& jobs, const BandSink& sink,
+               MemoryBudget* budget) {
+    BandJob job = jobs.dequeue();
+    fz_pixmap* pix = job.future.result();
+    fz_drop_display_list(ctx, job.list);
+    bool ok = pix && sink(ctx, job.band, pix);
+    fz_drop_pixmap(ctx, pix);
+    if (budget) {
+        budget->release(job.bytes);
+    }
+    return ok;
+}
+
+/**
+ * @brief 从已打开的文档解析一页显示列表
+ * @return 显示列表，失败返回nullptr
+ */
+fz_display_list* loadList(fz_context* ctx, fz_document* doc, int page, fz_rect* bounds) {
+    fz_page* fzPage = nullptr;
+    fz_display_list* list = nullptr;
+    fz_var(fzPage);
+    fz_var(list);
+    fz_try(ctx) {
+        fzPage = fz_load_page(ctx, doc, page);
+        *bounds = fz_bound_page(ctx, fzPage);
+        list = fz_new_display_list_from_page(ctx, fzPage);
+    }
+    fz_always(ctx) { fz_drop_page(ctx, fzPage); }
+    fz_catch(ctx) {
+        qDebug() << "解析页面失败：" << page << fz_caught_message(ctx);
+        list = nullptr;
+    }
+    return list;
+}
+
+/**
+ * @brief 按条带并行栅格化显示列表来源提供的全部页面
+ * @param ctx 调用线程的上下文
+ * @param num 页数
+ * @param source 显示列表来源
+ * @return 处理的页数，失败时返回-1
+ *
+ * 调用线程每取得一个显示列表就为其各条带提交渲染任务，
+ * 在途任务达到上限时先按顺序消费队首条带，再继续提交。
+ * 指定预算时，预算不足也先消费队首条带；只有没有在途任务时才阻塞等待，
+ * 此时预算全部由下游持有，下游归还后即可继续。
+ */
+int rasterizeList(fz_context* ctx, int num, const ListSource& source, int resolution,
+                  int bandHeight, const BandSink& sink, int workers,
+                  MemoryBudget* budget) {
+    if (workers <= 0) {
+        workers = QThread::idealThreadCount();
+    }
+    const int window = workers * 2;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(workers);
+    QQueue<BandJob> jobs;
+    fz_display_list* list = nullptr;
+    int result = -1;
+    fz_var(list);
+    fz_var(result);
+
+    fz_try(ctx) {
+        float zoom = (float)resolution / (float)72;  // 计算缩放比例（基于72DPI）
+        fz_matrix ctm = fz_scale(zoom, zoom);
+        bool ok = true;
+        for (int i = 0; i < num && ok; i++) {
+            fz_rect bounds;
+            list = source(ctx, i, &bounds);
+            if (!list) {
+                fz_throw(ctx, FZ_ERROR_GENERIC, "cannot load page %d", i);
+            }
+
+            fz_irect pageArea = fz_round_rect(fz_transform_rect(bounds, ctm));
+            int rows = pageArea.y1 - pageArea.y0;
+            int step = bandRows(pageArea, bandHeight);
+            int count = std::max(1, (rows + step - 1) / step);
+            bool color = count > 1 ? pageHasColor(ctx, list) : true;
+            for (int b = 0; b < count && ok; b++) {
+                BandJob job;
+                job.band.page = i;
+                job.band.index = b;
+                job.band.count = count;
+                job.band.pageArea = pageArea;
+                job.band.area = pageArea;
+                job.band.area.y0 = pageArea.y0 + b * step;
+                job.band.area.y1 = std::min(pageArea.y1, job.band.area.y0 + step);
+                job.band.bounds = bounds;
+                job.band.color = color;
+                if (budget) {
+                    job.bytes = (qint64)(job.band.area.x1 - job.band.area.x0) *
+                                (job.band.area.y1 - job.band.area.y0) * 3;
+                    while (ok && !budget->tryAcquire(job.bytes)) {
+                        if (jobs.isEmpty()) {
+                            budget->acquire(job.bytes);
+                            break;
+                        }
+                        ok = emitFront(ctx, jobs, sink, budget);
+                    }
+                    if (!ok) {
+                        break;
+                    }
+                }
+                // 每个条带任务各持有一个显示列表引用，最后一个条带完成后释放
+                job.list = fz_keep_display_list(ctx, list);
+                fz_display_list* bandList = job.list;
+                fz_irect area = job.band.area;
+                job.future = QtConcurrent::run(&pool, [bandList, ctm, area]() {
+                    return renderBand(bandList, ctm, area);
+                });
+                jobs.enqueue(job);
+
+                if (jobs.size() >= window) {
+                    ok = emitFront(ctx, jobs, sink, budget);
+                }
+            }
+            fz_drop_display_list(ctx, list);
+            list = nullptr;
+        }
+        while (ok && !jobs.isEmpty()) {
+            ok = emitFront(ctx, jobs, sink, budget);
+        }
+        if (ok) {
+            result = num;
+        }
+    }
+    fz_always(ctx) {
+        // 中止或出错时等待在途任务结束后再释放其显示列表和结果
+        while (!jobs.isEmpty()) {
+            BandJob job = jobs.dequeue();
+            fz_drop_pixmap(ctx, job.future.result());
+            fz_drop_display_list(ctx, job.list);
+            if (budget) {
+                budget->release(job.bytes);
+            }
+        }
+        fz_drop_display_list(ctx, list);
+    }
+    fz_catch(ctx) {
+        qDebug() << "文件处理错误：" << fz_caught_message(ctx);
+        result = -1;
+    }
+    return result;
+}
+
+/**
+ * @brief 把条带处理函数适配为页面处理函数（整页作为一个条带）
+ */
+BandSink pageSinkAdapter(const PageSink& sink) {
+    return [&sink](fz_context* ctx, const Band& band, fz_pixmap* pix) {
+        return sink(ctx, band.page, pix, band.bounds);
+    };
+}
+
+} // namespace
+
+/**
+ * @brief 并行栅格化内存中PDF的全部页面
+ * @param pdfData PDF文件内容
+ * @param resolution 栅格化分辨率（DPI）
+ * @param sink 页面结果处理函数
+ * @param workers 渲染线程数，0表示使用CPU核心数
+ * @param budget 内存预算，nullptr表示不限制
+ * @return 处理的页数，失败时返回-1
+ */
+int rasterize(const QByteArray& pdfData, int resolution, const PageSink& sink,
+              int workers, MemoryBudget* budget) {
+    return rasterizeBands(pdfData, resolution, 0, pageSinkAdapter(sink), workers, budget);
+}
+
+/**
+ * @brief 按水平条带并行栅格化内存中PDF的全部页面
+ * @param pdfData PDF文件内容
+ * @param resolution 栅格化分辨率（DPI）
+ * @param bandHeight 条带高度（像素），0表示整页，小于0表示自动
+ * @param sink 条带结果处理函数
+ * @param workers 渲染线程数，0表示使用CPU核心数
+ * @param budget 内存预算，nullptr表示不限制
+ * @return 处理的页数，失败时返回-1
+ *
+ * 内存中的数据没有文件路径和修改时间可作缓存键，显示列表用完即释放。
+ */
+int rasterizeBands(const QByteArray& pdfData, int resolution, int bandHeight,
+                   const BandSink& sink, int workers, MemoryBudget* budget) {
+    fz_context* ctx = DisplayListCache::instance()->newContext();
+    if (!ctx) {
+        qDebug() << "创建MuPDF上下文失败";
+        return -1;
+    }
+
+    fz_stream* stm = nullptr;
+    fz_document* doc = nullptr;
+    int num = -1;
+    fz_var(stm);
+    fz_var(doc);
+    fz_var(num);
+    fz_try(ctx) {
+        stm = fz_open_memory(ctx, (const unsigned char*)pdfData.constData(),
+                             pdfData.size());
+        doc = fz_open_document_with_stream(ctx, "application/pdf", stm);
+        num = fz_count_pages(ctx, doc);
+    }
+    fz_catch(ctx) {
+        qDebug() << "文件处理错误：" << fz_caught_message(ctx);
+        num = -1;
+    }
+
+    int result = -1;
+    if (num >= 0) {
+        ListSource source = [doc](fz_context* ctx, int page, fz_rect* bounds) {
+            return loadList(ctx, doc, page, bounds);
+        };
+        result = rasterizeList(ctx, num, source, resolution, bandHeight, sink, workers,
+                               budget);
+    }
+
+    fz_drop_document(ctx, doc);
+    fz_drop_stream(ctx, stm);
+    fz_drop_context(ctx);
+    return result;
+}
+
+/**
+ * @brief 并行栅格化PDF文件的全部页面
+ * @param pdfFile PDF文件路径
+ * @param resolution 栅格化分辨率（DPI）
+ * @param sink 页面结果处理函数
+ * @param workers 渲染线程数，0表示使用CPU核心数
+ * @param budget 内存预算，nullptr表示不限制
+ * @return 处理的页数，失败时返回-1
+ */
+int rasterizeFile(const QString& pdfFile, int resolution, const PageSink& sink,
+                  int workers, MemoryBudget* budget) {
+    return rasterizeFileBands(pdfFile, resolution, 0, pageSinkAdapter(sink), workers,
+                              budget);
+}
+
+/**
+ * @brief 按水平条带并行栅格化PDF文件的全部页面
+ * @param pdfFile PDF文件路径
+ * @param resolution 栅格化分辨率（DPI）
+ * @param bandHeight 条带高度（像素），0表示整页，小于0表示自动
+ * @param sink 条带结果处理函数
+ * @param workers 渲染线程数，0表示使用CPU核心数
+ * @param budget 内存预算，nullptr表示不限制
+ * @return 处理的页数，失败时返回-1
+ *
+ * 显示列表取自DisplayListCache，同一文件再次以任意分辨率栅格化时不再解析页面。
+ */
+int rasterizeFileBands(const QString& pdfFile, int resolution, int bandHeight,
+                       const BandSink& sink, int workers, MemoryBudget* budget) {
+    DisplayListCache* cache = DisplayListCache::instance();
+    fz_context* ctx = cache->newContext();
+    if (!ctx) {
+        qDebug() << "创建MuPDF上下文失败";
+        return -1;
+    }
+
+    int result = -1;
+    int num = cache->pageCount(ctx, pdfFile);
+    if (num >= 0) {
+        ListSource source = [cache, &pdfFile](fz_context* ctx, int page, fz_rect* bounds) {
+            return cache->displayList(ctx, pdfFile, page, bounds);
+        };
+        result = rasterizeList(ctx, num, source, resolution, bandHeight, sink, workers,
+                               budget);
+    }
+
+    fz_drop_context(ctx);
+    return result;
+}
+
+} // namespace PageRasterizer
@@ -0,0 +1,273 @@
+/**
+ * @file ParallelWatermark.cpp
+ * @brief 大文档分页并行水印模块实现
+ *
+ * 各页面范围由调用方提供的RangeRenderer在独立线程中生成（内存PDF），
+ * 拼接使用MuPDF的pdf_graft_mapped_page按顺序复制页面并补复制页面注释，
+ * 再从原文档复制页码标签（/PageLabels）并按页码重建书签。
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma execution_character_set("utf-8") // 设置编译器使用UTF-8字符集
+#include "include/function/ParallelWatermark.h"
+#include "include/function/GraftAnnotations.h" // 页面注释复制
+
+#include <QDebug>
+#include <QList>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+
+#include "mupdf/fitz.h"
+#include "mupdf/pdf.h"
+
+namespace ParallelWatermark {
+
+namespace {
+
+/**
+ * @brief 将书签树逐项插入目标文档
+ *
+ * 书签的uri是"#page=N"形式，插入时MuPDF会在目标文档中重新解析为页面引用，
+ * 由于拼接后的页面顺序与原文档一致，书签指向的页码保持不变。
+ */
+void copyOutline(fz_context* ctx, fz_outline_iterator* it, fz_outline* node) {
+    for (; node; node = node->next) {
+        fz_outline_item item;
+        item.title = node->title;
+        item.uri = node->uri;
+        item.is_open = node->is_open;
+        fz_outline_iterator_insert(ctx, it, &item);
+        if (node->down) {
+            // 插入后迭代器停在新项之后，退回到新项再进入其子级
+            fz_outline_iterator_prev(ctx, it);
+            fz_outline_iterator_down(ctx, it);
+            copyOutline(ctx, it, node->down);
+            fz_outline_iterator_up(ctx, it);
+            fz_outline_iterator_next(ctx, it);
+        }
+    }
+}
+
+/**
+ * @brief 从原文档复制页码标签和书签到拼接后的文档
+ */
+void copyNavigation(fz_context* ctx, pdf_document* dst, const QString& inFile) {
+    pdf_document* src = nullptr;
+    fz_outline* outline = nullptr;
+    fz_outline_iterator* it = nullptr;
+
+    fz_var(src);
+    fz_var(outline);
+    fz_var(it);
+
+    fz_try(ctx) {
+        src = pdf_open_document(ctx, inFile.toUtf8().constData());
+
+        // 页码标签数字树中只有标签字典，不引用页面对象，可直接复制
+        pdf_obj* labels = pdf_dict_getp(ctx, pdf_trailer(ctx, src), "Root/PageLabels");
+        if (labels) {
+            pdf_obj* root = pdf_dict_get(ctx, pdf_trailer(ctx, dst), PDF_NAME(Root));
+            pdf_dict_put_drop(ctx, root, PDF_NAME(PageLabels),
+                              pdf_graft_object(ctx, dst, labels));
+        }
+
+        outline = fz_load_outline(ctx, (fz_document*)src);
+        if (outline) {
+            it = fz_new_outline_iterator(ctx, (fz_document*)dst);
+            copyOutline(ctx, it, outline);
+        }
+    }
+    fz_always(ctx) {
+        fz_drop_outline_iterator(ctx, it);
+        fz_drop_outline(ctx, outline);
+        pdf_drop_document(ctx, src);
+    }
+    fz_catch(ctx) {
+        // 导航信息复制失败不影响页面内容，记录后继续保存
+        qDebug() << "复制书签/页码标签失败：" << fz_caught_message(ctx);
+    }
+}
+
+/**
+ * @brief 把各范围的内存PDF按顺序拼接为一个文件
+ */
+int stitch(const QList<QByteArray>& pieces, const QString& inFile,
+           const QString& outFile) {
+    fz_context* ctx = fz_new_context(NULL, NULL, FZ_STORE_DEFAULT);
+    if (!ctx) {
+        qDebug() << "创建MuPDF上下文失败";
+        return 2;
+    }
+
+    pdf_document* dst = nullptr;
+    int result = 0;
+    fz_var(dst);
+
+    fz_try(ctx) {
+        dst = pdf_create_document(ctx);
+        for (const QByteArray& piece : pieces) {
+            fz_stream* stm = fz_open_memory(
+                ctx, (const unsigned char*)piece.constData(), piece.size());
+            pdf_document* src = nullptr;
+            pdf_graft_map* map = nullptr;
+            int* dstPageOf = nullptr;
+            fz_var(src);
+            fz_var(map);
+            fz_var(dstPageOf);
+            fz_try(ctx) {
+                src = pdf_open_document_with_stream(ctx, stm);
+                // 范围文档是拼接时临时打开的内存文档，可以直接修改其注释
+                GraftAnnotations::detach(ctx, src);
+                // 同一范围内的页面共享一个嫁接映射，共用资源只复制一次
+                map = pdf_new_graft_map(ctx, dst);
+                int base = pdf_count_pages(ctx, dst);
+                int n = pdf_count_pages(ctx, src);
+                dstPageOf = fz_malloc_array(ctx, n, int);
+                for (int i = 0; i < n; i++) {
+                    pdf_graft_mapped_page(ctx, map, -1, src, i);
+                    dstPageOf[i] = base + i;
+                }
+                // 指向范围外页面的链接在范围文档中已失效，复制时去掉目标
+                for (int i = 0; i < n; i++) {
+                    GraftAnnotations::copyPage(ctx, map, dst, src, i, base + i, dstPageOf);
+                }
+            }
+            fz_always(ctx) {
+                fz_free(ctx, dstPageOf);
+                pdf_drop_graft_map(ctx, map);
+                pdf_drop_document(ctx, src);
+                fz_drop_stream(ctx, stm);
+            }
+            fz_catch(ctx) { fz_rethrow(ctx); }
+        }
+
+        copyNavigation(ctx, dst, inFile);
+
+        pdf_obj* info = pdf_add_new_dict(ctx, dst, 2);
+        pdf_dict_put_text_string(ctx, info, PDF_NAME(Creator), "泛生态业务工具集");
+        pdf_dict_put_text_string(ctx, info, PDF_NAME(Title), "本文档来自于泛生态业务投标案例");
+        pdf_dict_put_drop(ctx, pdf_trailer(ctx, dst), PDF_NAME(Info), info);
+
+        pdf_write_options opts = pdf_default_write_options;
+        opts.do_compress = 1;
+        opts.do_garbage = 1;
+        pdf_save_document(ctx, dst, outFile.toUtf8().constData(), &opts);
+    }
+    fz_always(ctx) { pdf_drop_document(ctx, dst); }
+    fz_catch(ctx) {
+        qDebug() << "拼接分页结果失败：" << fz_caught_message(ctx);
+        result = 2;
+    }
+
+    fz_drop_context(ctx);
+    return result;
+}
+
+/**
+ * @brief 页面范围共用的线程池
+ *
+ * run()本身通常在批处理线程池的工作线程中调用，多个文件同时切分时
+ * 所有范围都排在这一个池里，总并发不超过CPU核心数。
+ * 调用run()的线程只等待结果，不会占用这里的线程，因此不会互相等待。
+ */
+QThreadPool* rangePool() {
+    static QThreadPool* pool = [] {
+        QThreadPool* p = new QThreadPool;
+        p->setMaxThreadCount(QThread::idealThreadCount());
+        return p;
+    }();
+    return pool;
+}
+
+} // namespace
+
+/**
+ * @brief 判断文档是否应切换到分页并行模式
+ * @param pageCount 文档页数
+ * @return 页数达到阈值且有多个CPU核心时返回true
+ */
+bool shouldSplit(int pageCount) {
+    return pageCount >= kPageThreshold && QThread::idealThreadCount() > 1;
+}
+
+/**
+ * @brief 获取PDF文件页数
+ * @param pdfFile PDF文件路径
+ * @return 页数，文件无法打开时返回0
+ */
+int pageCount(const QString& pdfFile) {
+    fz_context* ctx = fz_new_context(NULL, NULL, FZ_STORE_DEFAULT);
+    if (!ctx) {
+        return 0;
+    }
+    pdf_document* doc = nullptr;
+    int pages = 0;
+    fz_var(doc);
+    fz_try(ctx) {
+        doc = pdf_open_document(ctx, pdfFile.toUtf8().constData());
+        pages = pdf_count_pages(ctx, doc);
+    }
+    fz_always(ctx) { pdf_drop_document(ctx, doc); }
+    fz_catch(ctx) {
+        qDebug() << "文件处理错误：" << pdfFile << fz_caught_message(ctx);
+        pages = 0;
+    }
+    fz_drop_context(ctx);
+    return pages;
+}
+
+/**
+ * @brief 分页并行加水印
+ * @param inFile 输入PDF文件路径
+ * @param outFile 输出PDF文件路径
+ * @param pageCount 输入文档页数
+ * @param render 页面范围水印函数
+ * @param workers 并发数，0表示使用CPU核心数
+ * @return 0: 成功, 2: 失败
+ *
+ * 范围数取并发数的两倍，使耗时不均的范围之间能够互相补位；
+ * 同时保证每个范围不少于kMinPagesPerRange页。
+ * 各范围在进程共用的线程池中执行，workers只决定切分粒度，
+ * 同时处理多个大文档时不会叠加出"文件数×核心数"个线程。
+ */
+int run(const QString& inFile, const QString& outFile, int pageCount,
+        const RangeRenderer& render, int workers) {
+    if (pageCount <= 0) {
+        return 2;
+    }
+    if (workers <= 0) {
+        workers = QThread::idealThreadCount();
+    }
+    int ranges = std::max(1, std::min(workers * 2, pageCount / kMinPagesPerRange));
+    int perRange = (pageCount + ranges - 1) / ranges;
+
+    QList<QFuture<QByteArray>> futures;
+    for (int first = 1; first <= pageCount; first += perRange) {
+        int last = std::min(first + perRange - 1, pageCount);
+        futures.append(QtConcurrent::run(rangePool(), [render, first, last]() {
+            return render(first, last);
+        }));
+    }
+
+    QList<QByteArray> pieces;
+    bool failed = false;
+    for (QFuture<QByteArray>& future : futures) {
+        QByteArray piece = future.result();
+        if (piece.isEmpty()) {
+            failed = true;
+        }
+        pieces.append(piece);
+    }
+    if (failed) {
+        qDebug() << "分页并行水印失败：" << inFile;
+        return 2;
+    }
+
+    return stitch(pieces, inFile, outFile);
+}
+
+} // namespace ParallelWatermark
@@ -11,33 +11,78 @@
 
 #pragma execution_character_set("utf-8") // 设置编译器使用UTF-8字符集
 #include "include/function/PdfOperations.h"
+#include "include/function/DisplayListCache.h"
+#include "include/function/FileSystemUtils.h"
+#include "include/function/GraftCopy.h"
 #include "include/mark/mark.h" // 包含GetFontsFolder函数声明
 
+#include <QAtomicInt>
+#include <QFileInfo>
+#include <QMap>
+#include <QRegularExpression>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+
 namespace PdfOperations {
 
 /**
  * @brief 获取PDF文件的页面数量
- * 使用MuPDF库解析PDF文件并返回页面数
- * @param pdfFile PDF文件路径
+ * 只解析交叉引用表和页面树，不把文件读入DisplayListCache；
+ * 上下文克隆自缓存的基础上下文，文档处理器已注册
+ * @param pdfFile PDF文件路径（UTF-8）
  * @return PDF文件的页面数，出错时返回1
  */
 int getPages(string pdfFile) {
-    // 创建MuPDF上下文和文档处理器
-    fz_context* ctx = fz_new_context(NULL, NULL, FZ_STORE_DEFAULT);
-    fz_register_document_handlers(ctx);
-    
-    // 打开PDF文档
-    fz_document* doc = fz_open_document(ctx, pdfFile.c_str());
-    if (!doc) {
+    fz_context* ctx = DisplayListCache::instance()->newContext();
+    if (!ctx) {
+        return 1;
+    }
+    fz_document* doc = nullptr;
+    int num = -1;
+    fz_var(doc);
+    fz_var(num);
+    fz_try(ctx) {
+        doc = fz_open_document(ctx, pdfFile.c_str());
+        num = fz_count_pages(ctx, doc);
+    }
+    fz_always(ctx) { fz_drop_document(ctx, doc); }
+    fz_catch(ctx) { num = -1; }
+    fz_drop_context(ctx);
+    if (num < 0) {
         qDebug() << "文件处理错误：" << QString::fromStdString(pdfFile);
-        fz_drop_context(ctx);
         return 1;  // 文件打开失败
     }
-    
-    int num = fz_count_pages(ctx, doc);  // 获取页面数
-    
-    // 清理资源
-    fz_drop_document(ctx, doc);
+    return num;
+}
+
+/**
+ * @brief 统计内存中PDF的页数
+ * @param data PDF文件内容
+ * @return 页数，无法解析时返回-1
+ */
+static int countPages(const QByteArray& data) {
+    fz_context* ctx = DisplayListCache::instance()->newContext();
+    if (!ctx) {
+        return -1;
+    }
+    fz_stream* stm = nullptr;
+    fz_document* doc = nullptr;
+    int num = -1;
+    fz_var(stm);
+    fz_var(doc);
+    fz_var(num);
+    fz_try(ctx) {
+        stm = fz_open_memory(ctx, (const unsigned char*)data.constData(), data.size());
+        doc = fz_open_document_with_stream(ctx, "application/pdf", stm);
+        num = fz_count_pages(ctx, doc);
+    }
+    fz_always(ctx) {
+        fz_drop_document(ctx, doc);
+        fz_drop_stream(ctx, stm);
+    }
+    fz_catch(ctx) { num = -1; }
     fz_drop_context(ctx);
     return num;
 }
@@ -80,73 +125,132 @@ int getPageheight(wstring filename) {
  * @return 0表示成功，2表示失败
  */
 int splitPdf(string in, string out, int subpages) {
-    int indoc, page_count;
-    wstring infile = StringConverter::String2WString(in);
-    wstring outfile_basename = StringConverter::String2WString(out);
-    
-    try {
-        PDFlib p;
-        const wstring searchpath = L"./PDFlib-CMap-5.0/resource/cmap";
-        wostringstream optlist;
-        optlist << L"searchpath={{" << searchpath << L"}";
-        optlist << L" {" << GetFontsFolder() << L"}}";
-        p.set_option(optlist.str());
-        
-        // 设置PDF文档信息
-        p.set_info(L"Creator", L"泛生态业务工具集");
-        p.set_info(L"Title", L"本文档来自于泛生态业务投标案例");
-        
-        // 打开输入PDF文档
-        indoc = p.open_pdi_document(infile, L"");
-        if (indoc == -1) {
-            wcerr << L"打开文档错误: " << p.get_errmsg() << endl;
+    return splitPdfChunks(QString::fromStdString(in), QString::fromStdString(out), subpages);
+}
+
+/**
+ * @brief 把[start, end)页按每subpages页并行拆分为多个文件
+ * 输入文件只读入内存一次，页数和后续拆分都使用这份数据；
+ * 每个工作线程使用独立的PDFlib对象，把共享数据挂成PVF后打开一次PDI，
+ * 再按序号领取拆分文件依次写出，耗时不均的文件之间可以互相补位
+ * @param inFile 输入文件路径
+ * @param outBase 输出文件名前缀
+ * @param subpages 每个拆分文件的页数
+ * @param start 起始页（从0开始）
+ * @param end 结束页（不包含此页），-1表示到末页
+ * @param workers 并发数，0表示使用CPU核心数
+ * @return 0表示成功，2表示失败
+ */
+int splitPdfChunks(const QString& inFile, const QString& outBase, int subpages,
+                   int start, int end, int workers, CopyBackend backend) {
+    // PVF不复制数据，各线程只读同一份内存
+    const QByteArray data = FileSystemUtils::readFileBytes(inFile);
+    const int pageCount = data.isEmpty() ? -1 : countPages(data);
+    if (pageCount <= 0 || subpages <= 0) {
+        qDebug() << "文件处理错误：" << inFile;
+        return 2;
+    }
+    start = std::max(0, start);
+    end = (end < 0) ? pageCount : std::min(end, pageCount);
+    if (start >= end) {
+        return 2;
+    }
+    const int outdocCount = (end - start + subpages - 1) / subpages;
+    const wstring infile = StringConverter::QString2WString(inFile);
+
+    if (workers <= 0) {
+        workers = QThread::idealThreadCount();
+    }
+    workers = std::min(workers, outdocCount);
+
+    if (backend == CopyBackend::Graft) {
+        QList<GraftCopy::Extract> outputs;
+        for (int chunk = 0; chunk < outdocCount; chunk++) {
+            GraftCopy::Extract output;
+            output.file = outBase + "_" + QString::number(chunk + 1) + ".pdf";
+            PageRange range;
+            range.start = start + chunk * subpages;
+            range.end = std::min(range.start + subpages, end);
+            output.ranges.append(range);
+            outputs.append(output);
         }
-        
-        page_count = (int)p.pcos_get_number(indoc, L"length:pages");
-        // 计算需要拆分成的文件数
-        int outdoc_count = page_count / subpages + (page_count % subpages > 0 ? 1 : 0);
-        
-        // 逐个创建拆分的PDF文件
-        for (int outdoc_counter = 0, page = 0; outdoc_counter < outdoc_count; outdoc_counter++) {
-            std::wstringstream s1, s0;
-            s0 << outdoc_counter;
-            s1 << outdoc_counter + 1;
-            wstring outfile = outfile_basename + L"_" + s1.str() + L".pdf";
-
-            // 打开新的子文档
-            if (p.begin_document(outfile, L"") == -1) {
-            }
-            p.set_info(L"Creator", L"泛生态业务工具集");
-            p.set_info(L"Title", L"本文档来自于泛生态业务投标案例");
-            p.set_info(L"Subject", L"Sub-document " + s1.str() + L" of " + s0.str() +
-                                       L" of input document '" + infile + L"'");
-            
-            // 复制指定数量的页面到子文档
-            for (int i = 0; page < page_count && i < subpages; page++, i++) {
-                // 页面大小可能会被fit_pdi_page()调整
-                p.begin_page_ext(0, 0, L"width=a4.width height=a4.height");
-                int pagehdl = p.open_pdi_page(indoc, page + 1, L"");
-                if (pagehdl == -1) {
+        return GraftCopy::extract(data, outputs, workers);
+    }
+
+    QAtomicInt next(0);
+    QAtomicInt failed(0);
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(workers);
+    QList<QFuture<void>> futures;
+    for (int w = 0; w < workers; w++) {
+        futures.append(QtConcurrent::run(&pool, [&]() {
+            try {
+                PDFlib p;
+                const wstring searchpath = L"./PDFlib-CMap-5.0/resource/cmap";
+                wostringstream optlist;
+                optlist << L"searchpath={{" << searchpath << L"}";
+                optlist << L" {" << GetFontsFolder() << L"}}";
+                p.set_option(optlist.str());
+
+                const wstring pvf = L"/pvf/pdf/input";
+                p.create_pvf(pvf, data.constData(), data.size(), L"");
+                const int indoc = p.open_pdi_document(pvf, L"");
+                if (indoc == -1) {
+                    wcerr << L"打开文档错误: " << p.get_errmsg() << endl;
+                    p.delete_pvf(pvf);
+                    failed.storeRelaxed(1);
+                    return;
                 }
-                // 将导入的页面放置在输出页面上，并调整页面大小
-                p.fit_pdi_page(pagehdl, 0, 0, L"adjustpage");
-                p.close_pdi_page(pagehdl);
-                p.end_page_ext(L"");
-            }
-            
-            // 关闭子文档
-            p.end_document(L"");
-        }
-        p.close_pdi_document(indoc);
 
-    } catch (PDFlib::Exception& ex) {
-        wcerr << L"PDFlib 发生异常: " << endl
-              << L"[" << ex.get_errnum() << L"] " << ex.get_apiname() << L": "
-              << ex.get_errmsg() << endl
-              << L": " << L"错误的参数选项请使用 - h参数查看帮助" << endl;
-        return 2;
+                int chunk;
+                while ((chunk = next.fetchAndAddRelaxed(1)) < outdocCount) {
+                    const wstring number = to_wstring(chunk + 1);
+                    const wstring outfile = StringConverter::QString2WString(outBase) +
+                                            L"_" + number + L".pdf";
+                    if (p.begin_document(outfile, L"") == -1) {
+                        wcerr << L"Error: " << p.get_errmsg() << endl;
+                        failed.storeRelaxed(1);
+                        continue;
+                    }
+                    p.set_info(L"Creator", L"泛生态业务工具集");
+                    p.set_info(L"Title", L"本文档来自于泛生态业务投标案例");
+                    p.set_info(L"Subject", L"Sub-document " + number + L" of " +
+                                               to_wstring(outdocCount) +
+                                               L" of input document '" + infile + L"'");
+
+                    const int first = start + chunk * subpages;
+                    const int last = std::min(first + subpages, end);
+                    for (int page = first; page < last; page++) {
+                        int pagehdl = p.open_pdi_page(indoc, page + 1, L"");
+                        if (pagehdl == -1) {
+                            wcerr << L"Error: " << p.get_errmsg() << endl;
+                            failed.storeRelaxed(1);
+                            continue;
+                        }
+                        // 页面大小可能会被fit_pdi_page()调整
+                        p.begin_page_ext(0, 0, L"width=a4.width height=a4.height");
+                        // 将导入的页面放置在输出页面上，并调整页面大小
+                        p.fit_pdi_page(pagehdl, 0, 0, L"adjustpage");
+                        p.close_pdi_page(pagehdl);
+                        p.end_page_ext(L"");
+                    }
+                    p.end_document(L"");
+                }
+                p.close_pdi_document(indoc);
+                p.delete_pvf(pvf);
+            } catch (PDFlib::Exception& ex) {
+                wcerr << L"PDFlib 发生异常: " << endl
+                      << L"[" << ex.get_errnum() << L"] " << ex.get_apiname() << L": "
+                      << ex.get_errmsg() << endl;
+                failed.storeRelaxed(1);
+            }
+        }));
     }
-    return 0;
+    for (QFuture<void>& future : futures) {
+        future.waitForFinished();
+    }
+    return failed.loadRelaxed() ? 2 : 0;
 }
 
 /**
@@ -215,6 +319,182 @@ int splitPdf(string in, string out, int start, int end) {
     return 0;
 }
 
+/**
+ * @brief 解析拆分范围说明
+ * 每个逗号分隔的项生成一个输出文件，页码从1开始，开放区间按文档页数展开
+ * @param spec 范围说明，如"1-7,12-,odd"
+ * @param pageCount 文档页数
+ * @param sections 解析结果
+ * @param error 解析失败时的错误说明
+ * @return 解析成功返回true
+ */
+bool parseSplitSpec(const QString& spec, int pageCount, QList<SplitSection>* sections,
+                    QString* error) {
+    static const QRegularExpression rangePattern(QStringLiteral("^(\\d*)\\s*-\\s*(\\d*)$"));
+    static const QRegularExpression pagePattern(QStringLiteral("^\\d+$"));
+
+    QString message;
+    QList<SplitSection> parsed;
+    const QStringList items = QString(spec).replace(QStringLiteral("，"), QStringLiteral(",")).split(',');
+    for (const QString& raw : items) {
+        const QString item = raw.trimmed().toLower();
+        if (item.isEmpty()) {
+            continue;
+        }
+
+        SplitSection section;
+        PageRange range;
+        if (item == QStringLiteral("odd") || item == QStringLiteral("奇数")) {
+            section.label = QStringLiteral("odd");
+            range.start = 0;
+            range.end = pageCount;
+            range.step = 2;
+        } else if (item == QStringLiteral("even") || item == QStringLiteral("偶数")) {
+            section.label = QStringLiteral("even");
+            range.start = 1;
+            range.end = pageCount;
+            range.step = 2;
+            if (pageCount < 2) {
+                message = QStringLiteral("文档只有1页，没有偶数页");
+                break;
+            }
+        } else if (pagePattern.match(item).hasMatch()) {
+            const int page = item.toInt();
+            if (page < 1 || page > pageCount) {
+                message = QStringLiteral("页码%1超出文件页数%2").arg(page).arg(pageCount);
+                break;
+            }
+            section.label = QString::number(page);
+            range.start = page - 1;
+            range.end = page;
+        } else {
+            QRegularExpressionMatch m = rangePattern.match(item);
+            if (!m.hasMatch() || (m.captured(1).isEmpty() && m.captured(2).isEmpty())) {
+                message = QStringLiteral("无法识别的范围：%1").arg(raw.trimmed());
+                break;
+            }
+            // "12-"到末页，"-4"从首页开始
+            const int first = m.captured(1).isEmpty() ? 1 : m.captured(1).toInt();
+            const int last = m.captured(2).isEmpty() ? pageCount : m.captured(2).toInt();
+            if (first < 1 || last > pageCount) {
+                message = QStringLiteral("范围%1超出文件页数%2").arg(raw.trimmed()).arg(pageCount);
+                break;
+            }
+            if (first > last) {
+                message = QStringLiteral("范围%1的起始页大于结束页").arg(raw.trimmed());
+                break;
+            }
+            section.label = QStringLiteral("%1-%2").arg(first).arg(last);
+            range.start = first - 1;
+            range.end = last;
+        }
+        section.ranges.append(range);
+        parsed.append(section);
+    }
+
+    if (message.isEmpty() && parsed.isEmpty()) {
+        message = QStringLiteral("请输入拆分范围");
+    }
+    if (!message.isEmpty()) {
+        if (error) {
+            *error = message;
+        }
+        return false;
+    }
+    if (sections) {
+        *sections = parsed;
+    }
+    return true;
+}
+
+/**
+ * @brief 按多个页面范围拆分PDF
+ * 原来的做法是每个范围调用一次splitPdf，每次都重新打开、解析输入文档；
+ * 这里输入只打开一次，各输出文件依次用同一个PDFlib对象写出
+ * @param inFile 输入文件路径
+ * @param outBase 输出文件名前缀
+ * @param sections 各输出文件的页面范围
+ * @return 0表示全部成功，2表示有文件失败
+ */
+int splitPdf(const QString& inFile, const QString& outBase, const QList<SplitSection>& sections,
+             CopyBackend backend) {
+    if (backend == CopyBackend::Graft) {
+        QList<GraftCopy::Extract> outputs;
+        for (const SplitSection& section : sections) {
+            GraftCopy::Extract output;
+            output.file = outBase + "_" + section.label + "_split.pdf";
+            output.ranges = section.ranges;
+            outputs.append(output);
+        }
+        return GraftCopy::extract(FileSystemUtils::readFileBytes(inFile), outputs);
+    }
+
+    int result = 0;
+    try {
+        PDFlib p;
+        const wstring searchpath = L"./PDFlib-CMap-5.0/resource/cmap";
+        wostringstream optlist;
+        optlist << L"searchpath={{" << searchpath << L"}";
+        optlist << L" {" << GetFontsFolder() << L"}}";
+        p.set_option(optlist.str());
+
+        const int indoc = p.open_pdi_document(StringConverter::QString2WString(inFile), L"");
+        if (indoc == -1) {
+            wcerr << L"打开文档错误: " << p.get_errmsg() << endl;
+            return 2;
+        }
+        const int pageCount = (int)p.pcos_get_number(indoc, L"length:pages");
+
+        for (const SplitSection& section : sections) {
+            // 没有页面的文档不能正常结束，先排除超出页数的范围
+            bool empty = true;
+            for (const PageRange& range : section.ranges) {
+                if (std::max(0, range.start) < std::min(range.end, pageCount)) {
+                    empty = false;
+                }
+            }
+            if (empty) {
+                wcerr << L"没有可拆分的页面: " << StringConverter::QString2WString(section.label) << endl;
+                result = 2;
+                continue;
+            }
+
+            const QString outFile = outBase + "_" + section.label + "_split.pdf";
+            if (p.begin_document(StringConverter::QString2WString(outFile), L"") == -1) {
+                wcerr << L"Error: " << p.get_errmsg() << endl;
+                result = 2;
+                continue;
+            }
+            p.set_info(L"Creator", L"泛生态业务工具集");
+            p.set_info(L"Title", L"本文档来自于泛生态业务投标案例");
+
+            for (const PageRange& range : section.ranges) {
+                for (int page = std::max(0, range.start); page < std::min(range.end, pageCount);
+                     page += std::max(1, range.step)) {
+                    int pagehdl = p.open_pdi_page(indoc, page + 1, L"");
+                    if (pagehdl == -1) {
+                        wcerr << L"Error: " << p.get_errmsg() << endl;
+                        continue;
+                    }
+                    // 页面大小可能会被fit_pdi_page()调整
+                    p.begin_page_ext(0, 0, L"width=a4.width height=a4.height");
+                    p.fit_pdi_page(pagehdl, 0, 0, L"adjustpage");
+                    p.close_pdi_page(pagehdl);
+                    p.end_page_ext(L"");
+                }
+            }
+            p.end_document(L"");
+        }
+        p.close_pdi_document(indoc);
+    } catch (PDFlib::Exception& ex) {
+        wcerr << L"PDFlib 发生异常: " << endl
+              << L"[" << ex.get_errnum() << L"] " << ex.get_apiname() << L": "
+              << ex.get_errmsg() << endl;
+        return 2;
+    }
+    return result;
+}
+
 /**
  * @brief 将文件列表fileList中的文件合并成一个PDF文件
  * @param fileList 文件路径列表
@@ -288,4 +568,244 @@ int mergePdf(std::list<std::string> fileList, string outFile) {
     }
 }
 
+/**
+ * @brief 按页面范围从原文件直接合并为一个文件
+ * 原来的做法是先把每个范围拆分为一个PDF再合并，每页都要导入、写出两次；
+ * 这里直接从原文件导入需要的页面，只写出一次
+ * @param sources 输入列表
+ * @param outFile 合并后的输出文件路径
+ * @return 0表示成功，2表示失败
+ */
+int mergePdf(const QList<MergeSource>& sources, const QString& outFile, CopyBackend backend) {
+    if (backend == CopyBackend::Graft) {
+        return GraftCopy::merge(sources, outFile);
+    }
+
+    // PDI在关闭输入前一直读取原文件，输出覆盖某个输入时不能直接写文件
+    const QString outPath = QFileInfo(outFile).absoluteFilePath();
+    bool inPlace = false;
+    for (const MergeSource& source : sources) {
+        if (QFileInfo(source.file).absoluteFilePath().compare(outPath, Qt::CaseInsensitive) == 0) {
+            inPlace = true;
+        }
+    }
+
+    QByteArray buffered;
+    try {
+        PDFlib p;
+        const wstring searchpath = L"./PDFlib-CMap-5.0/resource/cmap";
+        wostringstream optlist;
+        optlist << L"searchpath={{" << searchpath << L"}";
+        optlist << L" {" << GetFontsFolder() << L"}}";
+        p.set_option(optlist.str());
+
+        if (p.begin_document(inPlace ? wstring() : StringConverter::QString2WString(outFile), L"") == -1) {
+            wcerr << L"Error: " << p.get_errmsg() << endl;
+            return 2;
+        }
+        p.set_info(L"Creator", L"泛生态业务工具集");
+        p.set_info(L"Title", L"本文档来自于泛生态业务投标案例");
+
+        // 同一文件在多个输入中出现时只打开一次，句柄为-1表示打开失败
+        QMap<QString, int> docs;
+        int written = 0;
+        for (const MergeSource& source : sources) {
+            if (!docs.contains(source.file)) {
+                int doc = p.open_pdi_document(StringConverter::QString2WString(source.file), L"");
+                if (doc == -1) {
+                    wcerr << L"Error: " << p.get_errmsg() << endl;
+                }
+                docs.insert(source.file, doc);
+            }
+            const int indoc = docs.value(source.file);
+            if (indoc == -1) {
+                continue;
+            }
+
+            const int pageCount = (int)p.pcos_get_number(indoc, L"length:pages");
+            QList<PageRange> ranges = source.ranges;
+            if (ranges.isEmpty()) {
+                PageRange all;
+                all.end = pageCount;
+                ranges.append(all);
+            }
+            bool first = true;
+            for (const PageRange& range : ranges) {
+                for (int page = std::max(0, range.start); page < std::min(range.end, pageCount);
+                     page += std::max(1, range.step)) {
+                    int pagehdl = p.open_pdi_page(indoc, page + 1, L"");
+                    if (pagehdl == -1) {
+                        wcerr << L"Error: " << p.get_errmsg() << endl;
+                        continue;
+                    }
+                    // 页面大小可能会被fit_pdi_page()调整
+                    p.begin_page_ext(0, 0, L"width=a4.width height=a4.height");
+                    if (first && !source.bookmark.isEmpty()) {
+                        p.create_bookmark(StringConverter::QString2WString(source.bookmark), L"");
+                    }
+                    first = false;
+                    p.fit_pdi_page(pagehdl, 0, 0, L"adjustpage");
+                    p.close_pdi_page(pagehdl);
+                    p.end_page_ext(L"");
+                    written++;
+                }
+            }
+        }
+        if (written == 0) {
+            // 没有页面的文档不能正常结束，放弃该文档
+            wcerr << L"没有可合并的页面" << endl;
+            return 2;
+        }
+        p.end_document(L"");
+
+        if (inPlace) {
+            long len = 0;
+            const char* data = p.get_buffer(&len);
+            buffered = QByteArray(data, (int)len);
+        }
+        for (int doc : docs) {
+            if (doc != -1) {
+                p.close_pdi_document(doc);
+            }
+        }
+    } catch (PDFlib::Exception& ex) {
+        wcerr << L"PDFlib 发生异常: " << endl
+              << L"[" << ex.get_errnum() << L"] " << ex.get_apiname() << L": "
+              << ex.get_errmsg() << endl;
+        return 2;
+    }
+
+    // 输入已全部关闭，可以覆盖原文件
+    if (inPlace && !FileSystemUtils::writeFileBytes(outFile, buffered)) {
+        return 2;
+    }
+    return 0;
+}
+
+/**
+ * @brief 从内存中的PDF提取指定页面范围
+ * @param pdfData 输入PDF文件内容
+ * @param start 截取的起始页（从0开始）
+ * @param end 截取的结束页（不包含此页）
+ * @return 只包含这些页面的PDF文件内容，失败时返回空数组
+ */
+QByteArray splitPdfBuffer(const QByteArray& pdfData, int start, int end) {
+    const wstring pvf = L"/pvf/split/input.pdf";
+
+    try {
+        PDFlib p;
+        const wstring searchpath = L"./PDFlib-CMap-5.0/resource/cmap";
+        wostringstream optlist;
+        optlist << L"searchpath={{" << searchpath << L"}";
+        optlist << L" {" << GetFontsFolder() << L"}}";
+        p.set_option(optlist.str());
+
+        // 输入数据以虚拟文件的形式交给PDI，不复制
+        p.create_pvf(pvf, pdfData.constData(), pdfData.size(), L"");
+        int indoc = p.open_pdi_document(pvf, L"");
+        if (indoc == -1) {
+            wcerr << L"打开文档错误: " << p.get_errmsg() << endl;
+            return QByteArray();
+        }
+
+        if (p.begin_document(L"", L"") == -1) {
+            wcerr << L"Error: " << p.get_errmsg() << endl;
+            return QByteArray();
+        }
+        p.set_info(L"Creator", L"泛生态业务工具集");
+        p.set_info(L"Title", L"本文档来自于泛生态业务投标案例");
+
+        for (int page = start; page < end; page++) {
+            int pagehdl = p.open_pdi_page(indoc, page + 1, L"");
+            if (pagehdl == -1) {
+                wcerr << L"Error: " << p.get_errmsg() << endl;
+                continue;
+            }
+            // 页面大小可能会被fit_pdi_page()调整
+            p.begin_page_ext(0, 0, L"width=a4.width height=a4.height");
+            p.fit_pdi_page(pagehdl, 0, 0, L"adjustpage");
+            p.close_pdi_page(pagehdl);
+            p.end_page_ext(L"");
+        }
+        p.end_document(L"");
+
+        long len = 0;
+        const char* data = p.get_buffer(&len);
+        QByteArray result(data, (int)len);
+        p.close_pdi_document(indoc);
+        p.delete_pvf(pvf);
+        return result;
+    } catch (PDFlib::Exception& ex) {
+        wcerr << L"PDFlib 发生异常: " << endl
+              << L"[" << ex.get_errnum() << L"] " << ex.get_apiname() << L": "
+              << ex.get_errmsg() << endl;
+        return QByteArray();
+    }
+}
+
+/**
+ * @brief 将内存中的多个PDF合并为一个
+ * @param pdfs 要合并的PDF文件内容列表
+ * @param bookmarks 每个输入第一页的书签文本
+ * @return 合并后的PDF文件内容，失败时返回空数组
+ */
+QByteArray mergePdfBuffers(const QList<QByteArray>& pdfs,
+                           const QStringList& bookmarks) {
+    PDFlib p;
+
+    try {
+        const wstring searchpath = L"./PDFlib-CMap-5.0/resource/cmap";
+        wostringstream optlist;
+        optlist << L"searchpath={{" << searchpath << L"}";
+        optlist << L" {" << GetFontsFolder() << L"}}";
+        p.set_option(optlist.str());
+
+        if (p.begin_document(L"", L"") == -1) {
+            wcerr << L"Error: " << p.get_errmsg() << endl;
+            return QByteArray();
+        }
+        p.set_info(L"Creator", L"泛生态业务工具集");
+        p.set_info(L"Title", L"本文档来自于泛生态业务投标案例");
+
+        for (int i = 0; i < pdfs.size(); i++) {
+            const wstring pvf = L"/pvf/merge/" + to_wstring(i) + L".pdf";
+            p.create_pvf(pvf, pdfs[i].constData(), pdfs[i].size(), L"");
+            int indoc = p.open_pdi_document(pvf, L"");
+            if (indoc == -1) {
+                wcerr << L"Error: " << p.get_errmsg() << endl;
+                p.delete_pvf(pvf);
+                continue;
+            }
+
+            int endpage = (int)p.pcos_get_number(indoc, L"length:pages");
+            for (int pageno = 1; pageno <= endpage; pageno++) {
+                int page = p.open_pdi_page(indoc, pageno, L"");
+                if (page == -1) {
+                    wcerr << L"Error: " << p.get_errmsg() << endl;
+                    continue;
+                }
+                p.begin_page_ext(0, 0, L"width=a4.width height=a4.height");
+                if (pageno == 1 && i < bookmarks.size()) {
+                    p.create_bookmark(StringConverter::QString2WString(bookmarks[i]), L"");
+                }
+                p.fit_pdi_page(page, 0, 0, L"adjustpage");
+                p.close_pdi_page(page);
+                p.end_page_ext(L"");
+            }
+            p.close_pdi_document(indoc);
+            p.delete_pvf(pvf);  // 页面已写入输出，释放虚拟文件
+        }
+        p.end_document(L"");
+
+        long len = 0;
+        const char* data = p.get_buffer(&len);
+        return QByteArray(data, (int)len);
+    } catch (PDFlib::Exception& ex) {
+        wcerr << L"PDFlib 发生异常: " << endl
+              << L"[" << ex.get_errnum() << L"] " << ex.get_apiname() << L": "
+              << ex.get_errmsg() << endl;
+        return QByteArray();
+    }
+}
+
 } // namespace PdfOperations
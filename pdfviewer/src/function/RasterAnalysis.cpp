@@ -0,0 +1,197 @@
+/**
+ * @file RasterAnalysis.cpp
+ * @brief 栅格页面色调检测与转换模块实现
+ *
+ * SSE2版本每次处理48字节（16个像素）：把数据与错开一个字节的数据做差，
+ * 得到|R-G|、|G-B|以及跨像素的|B-R'|，跨像素的差值用周期为3的掩码屏蔽。
+ * 中间调比例满足黑白条件的页面再做一次标量扫描，排除成片的灰色区域。
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma execution_character_set("utf-8") // 设置编译器使用UTF-8字符集
+#include "include/function/RasterAnalysis.h"
+
+#include <cstdlib>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RASTER_ANALYSIS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace RasterAnalysis {
+
+namespace {
+
+/**
+ * @brief 16位掩码中置位的个数
+ */
+int popcount16(unsigned int x) {
+    x = x - ((x >> 1) & 0x5555);
+    x = (x & 0x3333) + ((x >> 2) & 0x3333);
+    x = (x + (x >> 4)) & 0x0F0F;
+    return (x + (x >> 8)) & 0x1F;
+}
+
+/**
+ * @brief 单个像素的标量检测
+ * @param midtones 中间调通道计数，像素不是灰色时不修改
+ * @return 像素为灰色时返回true
+ */
+bool scalarPixel(const unsigned char* p, long long* midtones) {
+    if (std::abs(p[0] - p[1]) > kGrayTolerance ||
+        std::abs(p[1] - p[2]) > kGrayTolerance) {
+        return false;
+    }
+    for (int c = 0; c < 3; c++) {
+        int v = p[c] < 255 - p[c] ? p[c] : 255 - p[c];
+        if (v > kBitonalTolerance) {
+            (*midtones)++;
+        }
+    }
+    return true;
+}
+
+#ifdef RASTER_ANALYSIS_SSE2
+/**
+ * @brief 检测一行中前width/16*16个像素
+ * @return 行内出现彩色像素时返回false
+ */
+bool sse2Row(const unsigned char* row, int blocks, long long* midtones) {
+    // 48字节中每3个字节的第3个差值是跨像素的|B-R'|，不参与比较
+    const __m128i mask0 = _mm_setr_epi8(-1, -1, 0, -1, -1, 0, -1, -1, 0, -1, -1, 0, -1, -1, 0, -1);
+    const __m128i mask1 = _mm_setr_epi8(-1, 0, -1, -1, 0, -1, -1, 0, -1, -1, 0, -1, -1, 0, -1, -1);
+    const __m128i mask2 = _mm_setr_epi8(0, -1, -1, 0, -1, -1, 0, -1, -1, 0, -1, -1, 0, -1, -1, 0);
+    const __m128i grayTol = _mm_set1_epi8((char)kGrayTolerance);
+    const __m128i toneTol = _mm_set1_epi8((char)kBitonalTolerance);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i masks[3] = {mask0, mask1, mask2};
+
+    for (int b = 0; b < blocks; b++) {
+        const unsigned char* p = row + b * 48;
+        __m128i colored = zero;
+        for (int k = 0; k < 3; k++) {
+            __m128i a = _mm_loadu_si128((const __m128i*)(p + k * 16));
+            // 最后一块的错位读取会越过16个像素的边界1字节，由调用方保证可读
+            __m128i n = _mm_loadu_si128((const __m128i*)(p + k * 16 + 1));
+            __m128i diff = _mm_or_si128(_mm_subs_epu8(a, n), _mm_subs_epu8(n, a));
+            colored = _mm_or_si128(colored,
+                                   _mm_and_si128(_mm_subs_epu8(diff, grayTol), masks[k]));
+
+            // min(v, 255-v) > 容差即为中间调
+            __m128i dist = _mm_min_epu8(a, _mm_xor_si128(a, _mm_set1_epi8(-1)));
+            __m128i extreme = _mm_cmpeq_epi8(_mm_subs_epu8(dist, toneTol), zero);
+            *midtones += 16 - popcount16((unsigned int)_mm_movemask_epi8(extreme));
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(colored, zero)) != 0xFFFF) {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+/**
+ * @brief 灰色像素是否为中间调（只看G通道，调用前已确认R、G、B接近）
+ */
+inline bool isMidtone(const unsigned char* p) {
+    int v = p[1] < 255 - p[1] ? p[1] : 255 - p[1];
+    return v > kBitonalTolerance;
+}
+
+/**
+ * @brief 统计四邻都是中间调的像素，超过上限即停止
+ * @return 页面中存在成片的中间调区域时返回true
+ */
+bool hasFlatMidtones(const unsigned char* rgb, int width, int height, int stride) {
+    int flat = 0;
+    for (int y = 1; y < height - 1; y++) {
+        const unsigned char* row = rgb + (long long)y * stride;
+        for (int x = 1; x < width - 1; x++) {
+            const unsigned char* p = row + x * 3;
+            if (isMidtone(p) && isMidtone(p - 3) && isMidtone(p + 3) &&
+                isMidtone(p - stride) && isMidtone(p + stride) &&
+                ++flat > kBitonalFlatMidtoneLimit) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+/**
+ * @brief 判断RGB像素数据的色调
+ * @param rgb 像素数据，每像素3字节
+ * @param width 宽度（像素）
+ * @param height 高度（像素）
+ * @param stride 行字节数
+ * @return 页面色调
+ */
+Tone classify(const unsigned char* rgb, int width, int height, int stride) {
+    long long midtones = 0;
+    for (int y = 0; y < height; y++) {
+        const unsigned char* row = rgb + (long long)y * stride;
+        int x = 0;
+#ifdef RASTER_ANALYSIS_SSE2
+        // 错位读取需要块后还有1字节，最后一行的末块交给标量处理
+        int blocks = width / 16;
+        if (y == height - 1 && blocks > 0 && blocks * 48 == stride) {
+            blocks--;
+        }
+        if (!sse2Row(row, blocks, &midtones)) {
+            return Tone::Color;
+        }
+        x = blocks * 16;
+#endif
+        for (; x < width; x++) {
+            if (!scalarPixel(row + x * 3, &midtones)) {
+                return Tone::Color;
+            }
+        }
+    }
+    double samples = (double)width * height * 3;
+    if (midtones > samples * kBitonalMidtoneRatio) {
+        return Tone::Gray;
+    }
+    // 中间调很少但连成一片（浅色或面积小的水印）时二值化会整块丢失
+    return hasFlatMidtones(rgb, width, height, stride) ? Tone::Gray : Tone::Bitonal;
+}
+
+/**
+ * @brief RGB转8位灰度，使用ITU-R BT.601权重
+ */
+QByteArray toGray(const unsigned char* rgb, int width, int height, int stride) {
+    QByteArray gray(width * height, Qt::Uninitialized);
+    unsigned char* out = (unsigned char*)gray.data();
+    for (int y = 0; y < height; y++) {
+        const unsigned char* p = rgb + (long long)y * stride;
+        for (int x = 0; x < width; x++, p += 3) {
+            *out++ = (unsigned char)((p[0] * 77 + p[1] * 150 + p[2] * 29) >> 8);
+        }
+    }
+    return gray;
+}
+
+/**
+ * @brief RGB转1位黑白（阈值128），每行按字节对齐
+ */
+QByteArray toBitonal(const unsigned char* rgb, int width, int height, int stride) {
+    int rowBytes = (width + 7) / 8;
+    QByteArray bits(rowBytes * height, '\0');
+    unsigned char* out = (unsigned char*)bits.data();
+    for (int y = 0; y < height; y++) {
+        const unsigned char* p = rgb + (long long)y * stride;
+        unsigned char* dst = out + (long long)y * rowBytes;
+        for (int x = 0; x < width; x++, p += 3) {
+            if (p[0] * 77 + p[1] * 150 + p[2] * 29 >= (128 << 8)) {
+                dst[x >> 3] |= (unsigned char)(0x80 >> (x & 7));
+            }
+        }
+    }
+    return bits;
+}
+
+} // namespace RasterAnalysis
@@ -0,0 +1,387 @@
+/**
+ * @file ResultCache.cpp
+ * @brief 处理结果缓存实现
+ *
+ * 条目文件按键的前两位分目录存放，索引文件index.txt每行记录
+ * "键 大小 修改时间 最近使用时间"。启动时不在索引中的条目文件
+ * （如上次异常退出时未保存索引）会被删除。
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma execution_character_set("utf-8") // 设置编译器使用UTF-8字符集
+#include "include/function/ResultCache.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <QThread>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+/**
+ * @brief 缓存格式版本，输出内容的生成方式变化时递增，使旧条目全部失效
+ */
+const char kFormatVersion[] = "result-cache-1";
+
+/**
+ * @brief 两次保存索引的最短间隔（毫秒），批量处理时避免每个文件都重写索引
+ */
+const qint64 kSaveInterval = 5000;
+
+/**
+ * @brief 输入文件哈希记忆的条目上限，超过后整体清空
+ */
+const int kMaxInputHashes = 4096;
+
+/**
+ * @brief 为已有文件建立硬链接
+ * @param target 已有文件
+ * @param link 新建的链接路径
+ * @return 成功返回true；跨卷或文件系统不支持时返回false，由调用方退化为复制
+ */
+bool hardLink(const QString& target, const QString& link) {
+#ifdef Q_OS_WIN
+    return CreateHardLinkW(
+               reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(link).utf16()),
+               reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(target).utf16()),
+               NULL) != 0;
+#else
+    return ::link(QFile::encodeName(target).constData(),
+                  QFile::encodeName(link).constData()) == 0;
+#endif
+}
+
+} // namespace
+
+/**
+ * @brief 构造函数
+ * @param dir 缓存目录
+ * @param limit 缓存上限（字节）
+ */
+ResultCache::ResultCache(const QString& dir, qint64 limit) : m_dir(dir), m_limit(limit) {
+    QDir().mkpath(m_dir);
+    load();
+}
+
+/**
+ * @brief 析构函数，保存索引
+ */
+ResultCache::~ResultCache() {
+    QMutexLocker locker(&m_mutex);
+    save(true);
+}
+
+/**
+ * @brief 进程共享的默认缓存
+ */
+ResultCache* ResultCache::shared() {
+    static ResultCache cache(
+        QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/results",
+        kDefaultLimit);
+    return &cache;
+}
+
+/**
+ * @brief 计算缓存键
+ * @return 十六进制SHA-256，输入文件无法读取时返回空字符串
+ *
+ * 各字段之间以'\0'分隔，避免"ab"+"c"与"a"+"bc"得到相同的键。
+ */
+QString ResultCache::key(const QString& operation, const QString& inputFile,
+                         const QStringList& params) {
+    QString hash = inputHash(inputFile);
+    if (hash.isEmpty()) {
+        return QString();
+    }
+    QCryptographicHash sha(QCryptographicHash::Sha256);
+    sha.addData(kFormatVersion, sizeof(kFormatVersion));
+    sha.addData(operation.toUtf8());
+    sha.addData("\0", 1);
+    sha.addData(hash.toLatin1());
+    for (const QString& param : params) {
+        sha.addData("\0", 1);
+        sha.addData(param.toUtf8());
+    }
+    return QString::fromLatin1(sha.result().toHex());
+}
+
+/**
+ * @brief 取出缓存结果
+ * @return 命中并成功写出时返回true
+ *
+ * 条目文件的大小或修改时间与存入时不同，说明经由硬链接被外部改写，
+ * 此时删除该条目并按未命中处理。
+ */
+bool ResultCache::fetch(const QString& key, const QString& outFile) {
+    if (key.isEmpty()) {
+        return false;
+    }
+    m_mutex.lock();
+    if (!m_entries.contains(key)) {
+        m_mutex.unlock();
+        return false;
+    }
+    Entry entry = m_entries.value(key);
+    m_mutex.unlock();
+
+    QString path = entryPath(key);
+    QFileInfo info(path);
+    if (!info.isFile() || info.size() != entry.size ||
+        info.lastModified().toMSecsSinceEpoch() != entry.modified) {
+        qDebug() << "结果缓存条目已失效：" << key;
+        QMutexLocker locker(&m_mutex);
+        remove(key);
+        return false;
+    }
+
+    QDir().mkpath(QFileInfo(outFile).absolutePath());
+    QFile::remove(outFile);
+    if (!hardLink(path, outFile) && !QFile::copy(path, outFile)) {
+        qDebug() << "写出缓存结果失败：" << outFile;
+        return false;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_entries.contains(key)) {
+        m_entries[key].used = QDateTime::currentMSecsSinceEpoch();
+    }
+    return true;
+}
+
+/**
+ * @brief 保存处理结果
+ *
+ * 先复制到临时文件再改名，其他线程不会取到写了一半的条目。
+ * 存入的是独立副本而不是硬链接，之后原地修改输出文件不会影响缓存。
+ */
+void ResultCache::store(const QString& key, const QString& outFile) {
+    if (key.isEmpty()) {
+        return;
+    }
+    QFileInfo out(outFile);
+    m_mutex.lock();
+    bool skip = m_entries.contains(key) || !out.isFile() || out.size() > m_limit;
+    m_mutex.unlock();
+    if (skip) {
+        return;
+    }
+
+    QString path = entryPath(key);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QString temp =
+        path + ".tmp" + QString::number((quintptr)QThread::currentThreadId());
+    QFile::remove(temp);
+    if (!QFile::copy(outFile, temp)) {
+        qDebug() << "保存结果缓存失败：" << outFile;
+        return;
+    }
+    QFile::remove(path);
+    if (!QFile::rename(temp, path)) {
+        QFile::remove(temp);
+        return;
+    }
+
+    QFileInfo info(path);
+    Entry entry;
+    entry.size = info.size();
+    entry.modified = info.lastModified().toMSecsSinceEpoch();
+    entry.used = QDateTime::currentMSecsSinceEpoch();
+
+    QMutexLocker locker(&m_mutex);
+    if (m_entries.contains(key)) {
+        m_size -= m_entries.value(key).size;
+    }
+    m_entries.insert(key, entry);
+    m_size += entry.size;
+    evict();
+    save();
+}
+
+/**
+ * @brief 修改缓存上限，超出部分立即淘汰
+ */
+void ResultCache::setLimit(qint64 limit) {
+    QMutexLocker locker(&m_mutex);
+    m_limit = limit;
+    evict();
+    save(true);
+}
+
+/**
+ * @brief 获取缓存上限
+ */
+qint64 ResultCache::limit() const {
+    QMutexLocker locker(&m_mutex);
+    return m_limit;
+}
+
+/**
+ * @brief 获取当前缓存占用（字节）
+ */
+qint64 ResultCache::size() const {
+    QMutexLocker locker(&m_mutex);
+    return m_size;
+}
+
+/**
+ * @brief 删除全部缓存条目
+ */
+void ResultCache::clear() {
+    QMutexLocker locker(&m_mutex);
+    for (const QString& key : m_entries.keys()) {
+        remove(key);
+    }
+    save(true);
+}
+
+/**
+ * @brief 条目文件路径
+ */
+QString ResultCache::entryPath(const QString& key) const {
+    return m_dir + "/" + key.left(2) + "/" + key + ".pdf";
+}
+
+/**
+ * @brief 计算输入文件内容的SHA-256
+ * @return 十六进制哈希，文件无法读取时返回空字符串
+ */
+QString ResultCache::inputHash(const QString& inputFile) {
+    QFileInfo info(inputFile);
+    InputHash memo;
+    memo.modified = info.lastModified().toMSecsSinceEpoch();
+    memo.size = info.size();
+    QString path = info.absoluteFilePath();
+    m_mutex.lock();
+    auto it = m_inputHashes.constFind(path);
+    if (it != m_inputHashes.constEnd() && it.value().modified == memo.modified &&
+        it.value().size == memo.size) {
+        QString hash = it.value().hash;
+        m_mutex.unlock();
+        return hash;
+    }
+    m_mutex.unlock();
+
+    QFile file(inputFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "读取文件失败：" << inputFile;
+        return QString();
+    }
+    QCryptographicHash sha(QCryptographicHash::Sha256);
+    if (!sha.addData(&file)) {
+        return QString();
+    }
+    memo.hash = QString::fromLatin1(sha.result().toHex());
+
+    // 每个路径只记最新的一次，文件改动后旧哈希被替换；条目过多时整体清空
+    QMutexLocker locker(&m_mutex);
+    if (m_inputHashes.size() >= kMaxInputHashes && !m_inputHashes.contains(path)) {
+        m_inputHashes.clear();
+    }
+    m_inputHashes.insert(path, memo);
+    return memo.hash;
+}
+
+/**
+ * @brief 删除一个条目，调用方需持有m_mutex
+ */
+void ResultCache::remove(const QString& key) {
+    if (!m_entries.contains(key)) {
+        return;
+    }
+    m_size -= m_entries.take(key).size;
+    QFile::remove(entryPath(key));
+}
+
+/**
+ * @brief 按最近使用时间淘汰条目直到不超过上限，调用方需持有m_mutex
+ */
+void ResultCache::evict() {
+    while (m_size > m_limit && !m_entries.isEmpty()) {
+        QString oldest;
+        qint64 oldestUsed = 0;
+        for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+            if (oldest.isEmpty() || it.value().used < oldestUsed) {
+                oldest = it.key();
+                oldestUsed = it.value().used;
+            }
+        }
+        remove(oldest);
+    }
+}
+
+/**
+ * @brief 读取索引，丢弃缺失的条目并删除索引之外的文件
+ */
+void ResultCache::load() {
+    QFile index(m_dir + "/index.txt");
+    if (index.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QTextStream in(&index);
+        while (!in.atEnd()) {
+            QStringList fields = in.readLine().split(' ');
+            if (fields.size() != 4) {
+                continue;
+            }
+            Entry entry;
+            entry.size = fields[1].toLongLong();
+            entry.modified = fields[2].toLongLong();
+            entry.used = fields[3].toLongLong();
+            QFileInfo info(entryPath(fields[0]));
+            if (info.isFile() && info.size() == entry.size) {
+                m_entries.insert(fields[0], entry);
+                m_size += entry.size;
+            }
+        }
+    }
+
+    QDirIterator it(m_dir, QStringList() << "*.pdf" << "*.tmp*", QDir::Files,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        QString path = it.next();
+        QString name = QFileInfo(path).fileName();
+        if (!name.endsWith(".pdf") || !m_entries.contains(name.chopped(4))) {
+            QFile::remove(path);
+        }
+    }
+
+    QMutexLocker locker(&m_mutex);
+    evict();
+}
+
+/**
+ * @brief 保存索引，调用方需持有m_mutex
+ * @param force 为false时距上次保存不足kSaveInterval则跳过
+ */
+void ResultCache::save(bool force) const {
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    if (!force && now - m_lastSave < kSaveInterval) {
+        return;
+    }
+    m_lastSave = now;
+
+    QSaveFile index(m_dir + "/index.txt");
+    if (!index.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return;
+    }
+    QTextStream out(&index);
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+        out << it.key() << ' ' << it.value().size << ' ' << it.value().modified << ' '
+            << it.value().used << '\n';
+    }
+    out.flush();
+    index.commit();
+}
@@ -0,0 +1,224 @@
+/**
+ * @file TextMetrics.cpp
+ * @brief 文本度量服务模块实现
+ *
+ * 字体优先从系统字体目录按文件名加载（与PDFlib输出使用同一个字体文件），
+ * 找不到文件时退回到按字体族名称匹配。字形前进宽度按码位缓存，
+ * 同一字体的后续测量只需查表求和。
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma execution_character_set("utf-8") // 设置编译器使用UTF-8字符集
+#include "include/function/TextMetrics.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QFont>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRawFont>
+#include <QStandardPaths>
+#include <QVector>
+#include <memory>
+
+namespace TextMetrics {
+
+namespace {
+
+/**
+ * @brief 测量结果缓存的条目上限，超过后整体清空
+ */
+const int kMaxCachedResults = 4096;
+
+/**
+ * @brief 一个（字体、字号）的度量数据
+ */
+struct FontEntry {
+    QRawFont raw;                   ///< 字体对象
+    qreal lineHeight = 0;           ///< 行高
+    QHash<uint, qreal> advances;    ///< 码位 -> 字形前进宽度
+};
+
+/**
+ * @brief 全局缓存，所有成员只在持有mutex时访问
+ *
+ * QRawFont对象本身不是线程安全的，因此测量过程整体在锁内进行；
+ * 命中缓存时只有一次哈希查找，锁的持有时间很短。
+ */
+struct Cache {
+    QMutex mutex;
+    QHash<QString, std::shared_ptr<FontEntry>> fonts;  ///< "字体|字号" -> 字体数据
+    QHash<QString, QSizeF> results;                    ///< "字体|字号|文本" -> 尺寸
+};
+
+Cache& cache() {
+    static Cache instance;
+    return instance;
+}
+
+/**
+ * @brief 在系统字体目录中查找字体文件
+ * @return 字体文件完整路径，找不到时返回空字符串
+ */
+QString findFontFile(const QString& fileName) {
+    QStringList dirs = QStandardPaths::standardLocations(QStandardPaths::FontsLocation);
+    for (const QString& dir : dirs) {
+        for (const char* ext : {".ttf", ".ttc", ".otf"}) {
+            QString path = QDir(dir).filePath(fileName + ext);
+            if (QFileInfo::exists(path)) {
+                return path;
+            }
+        }
+    }
+    return QString();
+}
+
+/**
+ * @brief 获取（字体、字号）对应的度量数据，不存在时加载
+ * @note 调用方需持有cache().mutex
+ */
+FontEntry& fontEntry(const QString& fontName, int fontSize) {
+    QString key = fontName + QLatin1Char('|') + QString::number(fontSize);
+    std::shared_ptr<FontEntry>& entry = cache().fonts[key];
+    if (entry) {
+        return *entry;
+    }
+
+    // 不使用微调，取字体设计度量，与PDFlib排版输出的字形宽度一致
+    entry = std::make_shared<FontEntry>();
+    QString path = findFontFile(fontFileName(fontName));
+    if (path.endsWith(".ttc", Qt::CaseInsensitive)) {
+        // QRawFont按文件加载时只取集合中的第一个字体（simsun.ttc中是宋体），
+        // 集合中的字体按PDFlib使用的字体名称从已安装字体中选择
+        QFont font(pdfFontName(fontName));
+        font.setPixelSize(fontSize);
+        font.setStyleStrategy(QFont::NoFontMerging);
+        font.setHintingPreference(QFont::PreferNoHinting);
+        entry->raw = QRawFont::fromFont(font);
+    } else if (!path.isEmpty()) {
+        entry->raw = QRawFont(path, fontSize, QFont::PreferNoHinting);
+    }
+    if (!entry->raw.isValid()) {
+        QFont font(fontName);
+        font.setPixelSize(fontSize);
+        font.setHintingPreference(QFont::PreferNoHinting);
+        entry->raw = QRawFont::fromFont(font);
+    }
+    if (entry->raw.isValid()) {
+        entry->lineHeight = entry->raw.ascent() + entry->raw.descent();
+    } else {
+        entry->lineHeight = fontSize * 1.2;  // 字体不可用时按常见行距估算
+    }
+    return *entry;
+}
+
+/**
+ * @brief 累加文本各字形的前进宽度，未缓存的码位查询后写入缓存
+ * @note 调用方需持有cache().mutex
+ */
+qreal measureWidth(FontEntry& entry, const QString& text) {
+    QVector<uint> codepoints = text.toUcs4();
+    // 字体缺少的字形（或字体不可用）按全角宽度估算
+    qreal fallback = entry.raw.isValid() ? entry.raw.pixelSize() : entry.lineHeight / 1.2;
+    for (uint cp : codepoints) {
+        if (entry.advances.contains(cp)) {
+            continue;
+        }
+        qreal advance = fallback;
+        if (entry.raw.isValid()) {
+            QVector<quint32> glyphs = entry.raw.glyphIndexesForString(QString::fromUcs4(&cp, 1));
+            if (!glyphs.isEmpty() && glyphs.first() != 0) {
+                advance = entry.raw.advancesForGlyphIndexes(glyphs.mid(0, 1)).first().x();
+            }
+        }
+        entry.advances.insert(cp, advance);
+    }
+
+    qreal width = 0;
+    for (uint cp : codepoints) {
+        width += entry.advances.value(cp);
+    }
+    return width;
+}
+
+} // namespace
+
+/**
+ * @brief 把界面上显示的字体名称转换为字体文件名
+ * @param fontName 字体名称
+ * @return 字体文件名（不含扩展名）
+ */
+QString fontFileName(const QString& fontName) {
+    if (fontName == "新宋体" || fontName == "NSimSun") return "simsun";
+    if (fontName == "楷体") return "simkai";
+    if (fontName == "仿宋") return "simfang";
+    if (fontName == "黑体") return "simhei";
+    return fontName;
+}
+
+/**
+ * @brief 把界面上显示的字体名称转换为PDFlib字体名称
+ * @param fontName 字体名称
+ * @return PDFlib字体名称
+ */
+QString pdfFontName(const QString& fontName) {
+    if (fontName == "新宋体" || fontName == "NSimSun") return "NSimSun";
+    return fontFileName(fontName);
+}
+
+/**
+ * @brief 测量单行文本的尺寸
+ * @param text 文本内容
+ * @param fontName 字体名称
+ * @param fontSize 字号（像素）
+ * @return 文本宽度和行高
+ */
+QSizeF textSize(const QString& text, const QString& fontName, int fontSize) {
+    QString key = fontName + QLatin1Char('|') + QString::number(fontSize) +
+                  QLatin1Char('|') + text;
+    Cache& c = cache();
+    QMutexLocker locker(&c.mutex);
+    auto it = c.results.constFind(key);
+    if (it != c.results.constEnd()) {
+        return it.value();
+    }
+
+    FontEntry& entry = fontEntry(fontName, fontSize);
+    QSizeF size(measureWidth(entry, text), entry.lineHeight);
+    if (c.results.size() >= kMaxCachedResults) {
+        c.results.clear();
+    }
+    c.results.insert(key, size);
+    return size;
+}
+
+/**
+ * @brief 测量单行文本的宽度
+ */
+qreal textWidth(const QString& text, const QString& fontName, int fontSize) {
+    return textSize(text, fontName, fontSize).width();
+}
+
+/**
+ * @brief 获取字体行高
+ */
+qreal lineHeight(const QString& fontName, int fontSize) {
+    Cache& c = cache();
+    QMutexLocker locker(&c.mutex);
+    return fontEntry(fontName, fontSize).lineHeight;
+}
+
+/**
+ * @brief 清空所有缓存
+ */
+void clearCache() {
+    Cache& c = cache();
+    QMutexLocker locker(&c.mutex);
+    c.results.clear();
+    c.fonts.clear();
+}
+
+} // namespace TextMetrics
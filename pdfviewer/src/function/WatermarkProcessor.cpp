@@ -2,8 +2,9 @@
  * @file WatermarkProcessor.cpp
  * @brief 水印处理模块实现
  * 
- * 该模块实现了PDF文档的水印处理功能，支持多行文本水印的添加，
- * 使用SVG生成技术和PDFlib库提供专业的水印效果。
+ * 该模块实现了PDF文档的水印处理功能，支持多行文本水印的添加。
+ * 文本行直接用PDFlib的fit_textline排版到一个旋转的模板中，
+ * 不经过SVG文件，也不产生临时文件。
  * 
  * @author Qt PDF工具集项目组
  * @date 2023
@@ -11,75 +12,80 @@
 
 #pragma execution_character_set("utf-8") // 设置编译器使用UTF-8字符集
 #include "include/function/WatermarkProcessor.h"
-#include "include/function/GeometryUtils.h" // 需要几何计算工具
+#include "include/function/ParallelWatermark.h" // 大文档分页并行
+#include "include/function/TextMetrics.h" // 字体名称解析和文本度量
 #include "include/mark/mark.h" // 包含GetFontsFolder函数声明
-#include <QFile>
+#include "include/mark/watermarkSession.h" // 字体加载
+#include <QColor>
+#include <QStringList>
+#include <map>
+#include <utility>
 
 namespace WatermarkProcessor {
 
+namespace {
+
 /**
- * @brief 获取SVG文件的尺寸信息
- * 使用libxml2库解析SVG文件并提取宽度和高度属性
- * @param filename SVG文件路径
- * @param width 输出参数，SVG宽度
- * @param height 输出参数，SVG高度
+ * @brief 多行水印的排版结果，同一范围内所有页面共用
  */
-void getSVGDimensions(const char* filename, int& width, int& height) {
-    xmlDocPtr doc;
-    xmlNodePtr rootNode;
-
-    // 解析SVG文件
-    doc = xmlReadFile(filename, nullptr, 0);
-    if (doc == nullptr) {
-        std::cerr << "Error: Unable to parse SVG file." << std::endl;
-        return;
-    }
+struct MultilineLayout {
+    QStringList lines;       ///< 各行文本
+    wstring textOptions;     ///< fit_textline选项列表（字体、字号、颜色）
+    int gstate = -1;         ///< 透明度图形状态句柄
+    double lineHeight = 0;   ///< 行高
+    double blockWidth = 0;   ///< 最长一行的宽度
+};
 
-    // 获取根节点
-    rootNode = xmlDocGetRootElement(doc);
-    if (rootNode == nullptr || xmlStrcmp(rootNode->name, (const xmlChar*)"svg")) {
-        std::cerr << "Error: Invalid SVG file format." << std::endl;
-        xmlFreeDoc(doc);
-        return;
-    }
-
-    // 从<svg>元素中提取width和height属性
-    const xmlChar* widthStr = xmlGetProp(rootNode, (const xmlChar*)"width");
-    const xmlChar* heightStr = xmlGetProp(rootNode, (const xmlChar*)"height");
+/**
+ * @brief 在当前文档中生成一个页面大小的多行水印模板
+ * @param p PDFlib对象
+ * @param layout 排版结果
+ * @param pageWidth 页面宽度
+ * @param pageHeight 页面高度
+ * @param angle 旋转角度（度，顺时针为正，与界面预览一致）
+ * @return 模板句柄
+ *
+ * 文本块以页面中心为原点整体旋转，各行左对齐、整体在垂直方向居中。
+ */
+int buildMultilineTemplate(PDFlib& p, const MultilineLayout& layout,
+                           int pageWidth, int pageHeight, qreal angle) {
+    int tpl = p.begin_template_ext(pageWidth, pageHeight, L"");
+    p.save();
+    p.set_gstate(layout.gstate);
+    p.translate(pageWidth / 2.0, pageHeight / 2.0);
+    p.rotate(-angle);  // PDF坐标系y轴向上，逆时针为正，取反后与QPainter一致
 
-    if (widthStr == nullptr || heightStr == nullptr) {
-        std::cerr << "Error: SVG file missing width or height attribute."
-                  << std::endl;
-        xmlFreeDoc(doc);
-        return;
+    double top = (layout.lines.size() - 1) * layout.lineHeight / 2.0;
+    for (int i = 0; i < layout.lines.size(); i++) {
+        if (layout.lines[i].isEmpty()) {
+            continue;  // 空行只占行高
+        }
+        p.fit_textline(StringConverter::QString2WString(layout.lines[i]),
+                       -layout.blockWidth / 2.0, top - i * layout.lineHeight,
+                       layout.textOptions);
     }
-
-    // 将宽度和高度字符串转换为整数
-    width = atoi((const char*)widthStr);
-    height = atoi((const char*)heightStr);
-
-    // 释放内存
-    xmlFreeDoc(doc);
+    p.restore();
+    p.end_template_ext(0, 0);
+    return tpl;
 }
 
 /**
- * @brief 为PDF文件添加多行文本水印
- * 支持自定义字体、字号、颜色、旋转角度和透明度
- * 使用SVG生成水印图形，然后作为图章添加到PDF页面
+ * @brief 为输入文档的一个页面范围添加多行文本水印
  * @param inFile 输入PDF文件路径
- * @param outFile 输出PDF文件路径
- * @param mark_txt 水印文本内容（支持换行符分隔的多行文本）
- * @param fontName 水印字体名称
- * @param fontSize 水印字体大小
- * @param color 水印颜色
- * @param angle 水印旋转角度
- * @param opacity 水印透明度（0.0-1.0）
+ * @param input 不为空时从该内存数据读取输入（PVF），忽略inFile
+ * @param outfile 输出PDF文件路径，为空时结果写入buffer
+ * @param firstPage 起始页（从1开始）
+ * @param lastPage 结束页（包含），-1表示到最后一页
+ * @param buffer outfile为空时接收输出PDF数据
  * @return 0表示成功，其他值表示失败
+ * @note 行宽和行高取自PDFlib已加载字体的度量，与输出中实际使用的字体一致；
+ *       同一范围内相同几何（宽、高、旋转）的页面共用一个缓存模板
  */
-int addWatermark_multiline(string inFile, string outFile, QString mark_txt,
-                           QString fontName, int fontSize, QString color,
-                           qreal angle, qreal opacity) {
-    const wstring outfile = StringConverter::String2WString(outFile);
+int multilineRange(const string& inFile, const QByteArray* input,
+                   const wstring& outfile, int firstPage,
+                   int lastPage, QByteArray* buffer, QString mark_txt,
+                   QString fontName, int fontSize, QString color, qreal angle,
+                   qreal opacity) {
     wstring pdffile = StringConverter::String2WString(inFile);
     
     try {
@@ -95,109 +101,105 @@ int addWatermark_multiline(string inFile, string outFile, QString mark_txt,
         p.set_option(optlist.str());
         p.set_option(L"errorpolicy=return");
 
+        // 在对象作用域中加载字体，字体度量与最终输出一致
+        int font = WatermarkSession::loadFont(
+            p, StringConverter::QString2WString(TextMetrics::pdfFontName(fontName)));
+        if (font == -1) {
+            qDebug() << L"Error: " << p.get_errmsg() << endl;
+            return 2;
+        }
+
         // 创建输出PDF文档
-        if (p.begin_document(outfile, L"") == 0) {
+        if (p.begin_document(outfile, L"") == -1) {
             qDebug() << L"Error: " << p.get_errmsg() << endl;
             return 2;
         }
         
-        // 打开输入PDF文档
+        // 打开输入PDF文档，内存数据以虚拟文件的形式交给PDI
+        if (input) {
+            pdffile = L"/pvf/multiline/input.pdf";
+            p.create_pvf(pdffile, input->constData(), input->size(), L"");
+        }
         int indoc = p.open_pdi_document(pdffile, L"");
-        if (indoc != 0) {
-            qDebug() << "error----------------indoc == 0";
+        if (indoc == -1) {
+            qDebug() << L"Error: " << p.get_errmsg() << endl;
+            return 2;
         }
 
         int endpage = (int)p.pcos_get_number(indoc, L"length:pages");
-        wstring graphicsfile = pdffile + L".svg";
-        int w = 0, h = 0;
-        
-        // 设置字体和文本
-        QFont font(fontName, fontSize);
-        QStringList textLines = mark_txt.split("\n");
-        
-        // 创建一个QFontMetrics对象，用于获取文本尺寸
-        QFontMetrics fontMetrics(font);
-        // 获取字体的高度
-        int lineHeight = fontMetrics.height();
-        int maxWidth = 0;
-        
-        // 遍历文本各行，获取最长宽度
-        foreach (const QString& line, textLines) {
-            int lineWidth = GeometryUtils::getTextWidth(line, fontName, fontSize).cx;
-            if (lineWidth > maxWidth) {
-                maxWidth = lineWidth;
+        if (lastPage > 0 && lastPage < endpage) {
+            endpage = lastPage;
+        }
+
+        // 由TextMetrics按与PDFlib相同的字体文件排版：行宽取最长一行，
+        // 各工作线程共用度量缓存，同一水印文本只测量一次
+        MultilineLayout layout;
+        layout.lines = mark_txt.split("\n");
+        wostringstream metricOptions;
+        metricOptions << L"font=" << font << L" fontsize=" << fontSize;
+        layout.lineHeight = TextMetrics::lineHeight(fontName, fontSize);
+        foreach (const QString& line, layout.lines) {
+            double lineWidth = TextMetrics::textWidth(line, fontName, fontSize);
+            if (lineWidth > layout.blockWidth) {
+                layout.blockWidth = lineWidth;
             }
         }
 
-        int maxHeight = lineHeight * textLines.size();  // 单行高度 × 行数
+        QColor fill(color);
+        wostringstream textOptions;
+        textOptions << metricOptions.str() << L" fillcolor={rgb " << fill.redF()
+                    << L" " << fill.greenF() << L" " << fill.blueF()
+                    << L"} position={left center}";
+        layout.textOptions = textOptions.str();
+
+        wostringstream gstateOptions;
+        gstateOptions << L"opacityfill=" << opacity;
+        layout.gstate = p.create_gstate(gstateOptions.str());
         
+        // 按页面尺寸缓存水印模板，相同尺寸的页面共用一个模板
+        // （模板只依赖页面宽高和水印角度，页面自身的/Rotate不参与绘制）
+        std::map<std::pair<int, int>, int> templates;
+
         // 遍历PDF文档的所有页面，为每一页添加水印
-        for (int pageno = 1; pageno <= endpage; pageno++) {
+        for (int pageno = firstPage; pageno <= endpage; pageno++) {
             int page = p.open_pdi_page(indoc, pageno, L"");  // 打开页面
-            if (page != 0) {
-                qDebug() << "error----------------page == 0";  // 页面打开失败
+            if (page == -1) {
+                qDebug() << "error----------------page == -1";  // 页面打开失败
             }
             
             // 获取当前页面的尺寸信息
-            int pageWidth =
-                p.pcos_get_number(indoc,
-                                  L"pages[" + StringConverter::String2WString(to_string(pageno - 1)) +
-                                      L"]/width");   // 页面宽度（如A4为595点）
-            int pageHeigth =
-                p.pcos_get_number(indoc,
-                                  L"pages[" + StringConverter::String2WString(to_string(pageno - 1)) +
-                                      L"]/height");  // 页面高度（如A4为842点）
-
-            // 创建水印矩形区域，位于页面中心
-            GeometryUtils::Rectangle rect = {pageWidth / 2 + 50,           // X坐标：页面中心 + 补偿值
-                                           pageHeigth / 2 + maxHeight / 2, // Y坐标：页面中心 + 文字高度的一半
-                                           maxWidth,                       // 矩形宽度
-                                           maxHeight};                     // 矩形高度
-            
-            double offsetX, offsetY;  // 旋转后的XY坐标补偿值
-            GeometryUtils::rotateRectangle(rect, angle, offsetX, offsetY);  // 计算旋转补偿
-            
-            // 如果页面尺寸发生变化，重新生成SVG水印文件
-            // 这样可以确保水印在不同尺寸的页面上都能正确显示
-            if ((pageWidth != w) || (pageHeigth != h)) {
-                GeometryUtils::createSVG(QString::fromStdString(inFile) + ".svg", mark_txt, pageWidth,
-                          pageHeigth, fontName, fontSize, color, angle, opacity);
-                w = pageWidth;   // 记录当前页面宽度
-                h = pageHeigth;  // 记录当前页面高度
-            }
+            wstring pagePath = L"pages[" + StringConverter::String2WString(to_string(pageno - 1)) + L"]";
+            int pageWidth = p.pcos_get_number(indoc, pagePath + L"/width");    // 页面宽度（如A4为595点）
+            int pageHeigth = p.pcos_get_number(indoc, pagePath + L"/height");  // 页面高度（如A4为842点）
 
             p.begin_page_ext(0, 0, L"width=a4.width height=a4.height");
 
             // 将导入的页面放置在输出页面上，并调整页面大小
             p.fit_pdi_page(page, 0, 0, L"adjustpage");
+
+            auto key = std::make_pair(pageWidth, pageHeigth);
+            auto cached = templates.find(key);
+            int tpl;
+            if (cached != templates.end()) {
+                tpl = cached->second;
+            } else {
+                tpl = buildMultilineTemplate(p, layout, pageWidth, pageHeigth, angle);
+                templates[key] = tpl;
+            }
             
-            // 创建用作注释图标的模板
-            p.begin_template_ext(pageWidth, pageHeigth, L"topdown=true");
-            
-            // 加载SVG图形
-            int gs = p.load_graphics(L"auto", graphicsfile, L"");
-            
-            // 将SVG放置在模板的指定位置
-            p.fit_graphics(gs, pageWidth / 2 - offsetX / 2,
-                           pageHeigth / 2 - offsetY / 2,
-                           L" scale=1 position={center} "
-                           L"fitmethod=auto showborder");
-            p.close_graphics(gs);
-            p.end_template_ext(0, 0);
-            
-            // 使用模板创建"正常"外观的注释
-            p.create_annotation(0, 0, pageWidth, pageHeigth, L"Stamp",
-                              L"template={normal=1} ");
+            // 水印作为页面内容绘制在原页面之上
+            p.fit_image(tpl, 0, 0, L"");
             p.close_pdi_page(page);
 
             p.end_page_ext(L"");
         }
 
         p.end_document(L"");
-        
-        // 删除临时SVG文件
-        string svg = inFile + ".svg";
-        QFile::remove(QString::fromStdString(svg));
+        if (buffer) {
+            long len = 0;
+            const char* data = p.get_buffer(&len);
+            *buffer = QByteArray(data, (int)len);
+        }
         
     } catch (PDFlib::Exception& ex) {
         wcerr << L"PDFlib exception occurred:" << endl
@@ -215,4 +217,64 @@ int addWatermark_multiline(string inFile, string outFile, QString mark_txt,
     return 0;
 }
 
+} // namespace
+
+/**
+ * @brief 为PDF文件添加多行文本水印
+ * 支持自定义字体、字号、颜色、旋转角度和透明度
+ * 各行文本直接排版到旋转的模板中，作为页面内容绘制在原页面之上
+ * @param inFile 输入PDF文件路径
+ * @param outFile 输出PDF文件路径
+ * @param mark_txt 水印文本内容（支持换行符分隔的多行文本）
+ * @param fontName 水印字体名称
+ * @param fontSize 水印字体大小
+ * @param color 水印颜色
+ * @param angle 水印旋转角度
+ * @param opacity 水印透明度（0.0-1.0）
+ * @return 0表示成功，其他值表示失败
+ * @note 页数达到ParallelWatermark::kPageThreshold时按页面范围并发处理后拼接
+ */
+int addWatermark_multiline(string inFile, string outFile, QString mark_txt,
+                           QString fontName, int fontSize, QString color,
+                           qreal angle, qreal opacity) {
+    int pages = ParallelWatermark::pageCount(QString::fromStdString(inFile));
+    if (ParallelWatermark::shouldSplit(pages)) {
+        return ParallelWatermark::run(
+            QString::fromStdString(inFile), QString::fromStdString(outFile), pages,
+            [=](int first, int last) {
+                QByteArray piece;
+                if (multilineRange(inFile, nullptr, L"", first, last, &piece, mark_txt,
+                                   fontName, fontSize, color, angle, opacity) != 0) {
+                    piece.clear();
+                }
+                return piece;
+            });
+    }
+    return multilineRange(inFile, nullptr, StringConverter::String2WString(outFile),
+                          1, -1, nullptr, mark_txt, fontName, fontSize, color,
+                          angle, opacity);
+}
+
+/**
+ * @brief 为内存中的PDF添加多行文本水印
+ * @param pdfData 输入PDF文件内容
+ * @param mark_txt 水印文本内容
+ * @param fontName 水印字体名称
+ * @param fontSize 水印字体大小
+ * @param color 水印颜色
+ * @param angle 水印旋转角度
+ * @param opacity 水印透明度（0.0-1.0）
+ * @return 加水印后的PDF文件内容，失败时返回空数组
+ */
+QByteArray addWatermark_multiline(const QByteArray& pdfData, QString mark_txt,
+                                  QString fontName, int fontSize, QString color,
+                                  qreal angle, qreal opacity) {
+    QByteArray result;
+    if (multilineRange(string(), &pdfData, L"", 1, -1, &result, mark_txt,
+                       fontName, fontSize, color, angle, opacity) != 0) {
+        result.clear();
+    }
+    return result;
+}
+
 } // namespace WatermarkProcessor
@@ -0,0 +1,339 @@
+/**
+ * @file incrementalStamp.cpp
+ * @brief 以增量更新方式追加水印的实现
+ *
+ * 水印页由调用方（通常是WatermarkSession）用PDFlib在内存中生成，
+ * 这里把水印页的内容流和资源嫁接为目标文档中的Form XObject，
+ * 每页的/Contents改为 [前缀 原内容... 后缀] 数组：
+ * - 前缀 "q" 保存原内容之前的图形状态
+ * - 后缀 "Q q <cm> /名称 Do Q" 恢复状态后在最上层绘制水印
+ * 前缀在全文档共享，后缀和XObject按页面几何共享。
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma execution_character_set("utf-8") // 设置编译器使用UTF-8字符集
+#include "include/mark/incrementalStamp.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <map>
+#include <tuple>
+
+#include "mupdf/fitz.h"
+#include "mupdf/pdf.h"
+
+namespace {
+
+/**
+ * @brief 页面几何：显示尺寸、旋转角度和MediaBox原点
+ */
+struct PageGeometry {
+  float width;
+  float height;
+  int rotate;
+  float x0;
+  float y0;
+
+  bool operator<(const PageGeometry& o) const {
+    return std::tie(width, height, rotate, x0, y0) <
+           std::tie(o.width, o.height, o.rotate, o.x0, o.y0);
+  }
+};
+
+/**
+ * @brief 已嫁接到目标文档的水印XObject
+ */
+struct StampXObject {
+  QByteArray data;       ///< 水印页PDF数据，需在嫁接期间保持有效
+  pdf_obj* xobj = nullptr;  ///< 目标文档中的Form XObject间接引用
+};
+
+/**
+ * @brief 读取页面几何信息
+ */
+PageGeometry pageGeometry(fz_context* ctx, pdf_obj* page) {
+  fz_rect box = pdf_to_rect(
+      ctx, pdf_dict_get_inheritable(ctx, page, PDF_NAME(MediaBox)));
+  int rotate = pdf_to_int(
+      ctx, pdf_dict_get_inheritable(ctx, page, PDF_NAME(Rotate)));
+  rotate = ((rotate % 360) + 360) % 360;
+
+  PageGeometry g;
+  g.width = box.x1 - box.x0;
+  g.height = box.y1 - box.y0;
+  g.rotate = rotate;
+  g.x0 = box.x0;
+  g.y0 = box.y0;
+  if (rotate == 90 || rotate == 270) {
+    std::swap(g.width, g.height);
+  }
+  return g;
+}
+
+/**
+ * @brief 将单页水印PDF嫁接为目标文档中的Form XObject
+ * @return 新XObject的间接引用，调用方负责释放
+ */
+pdf_obj* graftStamp(fz_context* ctx, pdf_document* doc, const QByteArray& data) {
+  fz_stream* stm = nullptr;
+  pdf_document* src = nullptr;
+  pdf_graft_map* map = nullptr;
+  fz_buffer* content = nullptr;
+  fz_buffer* packed = nullptr;
+  pdf_obj* dict = nullptr;
+  pdf_obj* xobj = nullptr;
+
+  fz_var(stm);
+  fz_var(src);
+  fz_var(map);
+  fz_var(content);
+  fz_var(packed);
+  fz_var(dict);
+
+  fz_try(ctx) {
+    stm = fz_open_memory(ctx, (const unsigned char*)data.constData(),
+                         data.size());
+    src = pdf_open_document_with_stream(ctx, stm);
+    pdf_obj* page = pdf_lookup_page_obj(ctx, src, 0);
+
+    // 合并水印页的全部内容流
+    content = fz_new_buffer(ctx, 1024);
+    pdf_obj* contents = pdf_dict_get(ctx, page, PDF_NAME(Contents));
+    int n = pdf_is_array(ctx, contents) ? pdf_array_len(ctx, contents) : 1;
+    for (int i = 0; i < n; i++) {
+      pdf_obj* part = pdf_is_array(ctx, contents)
+                          ? pdf_array_get(ctx, contents, i)
+                          : contents;
+      fz_buffer* buf = pdf_load_stream(ctx, part);
+      fz_append_buffer(ctx, content, buf);
+      fz_append_byte(ctx, content, '\n');
+      fz_drop_buffer(ctx, buf);
+    }
+
+    map = pdf_new_graft_map(ctx, doc);
+    dict = pdf_new_dict(ctx, doc, 4);
+    pdf_dict_put(ctx, dict, PDF_NAME(Type), PDF_NAME(XObject));
+    pdf_dict_put(ctx, dict, PDF_NAME(Subtype), PDF_NAME(Form));
+    pdf_dict_put_rect(
+        ctx, dict, PDF_NAME(BBox),
+        pdf_to_rect(ctx,
+                    pdf_dict_get_inheritable(ctx, page, PDF_NAME(MediaBox))));
+    pdf_dict_put_drop(
+        ctx, dict, PDF_NAME(Resources),
+        pdf_graft_mapped_object(
+            ctx, map,
+            pdf_dict_get_inheritable(ctx, page, PDF_NAME(Resources))));
+    // 增量保存不压缩新对象，模板内容流在这里先按Flate压缩
+    size_t len = 0;
+    unsigned char* deflated = fz_new_deflated_data_from_buffer(
+        ctx, &len, content, FZ_DEFLATE_DEFAULT);
+    packed = fz_new_buffer_from_data(ctx, deflated, len);
+    pdf_dict_put(ctx, dict, PDF_NAME(Filter), PDF_NAME(FlateDecode));
+    xobj = pdf_add_stream(ctx, doc, packed, dict, 1);
+  }
+  fz_always(ctx) {
+    pdf_drop_obj(ctx, dict);
+    fz_drop_buffer(ctx, packed);
+    fz_drop_buffer(ctx, content);
+    pdf_drop_graft_map(ctx, map);
+    pdf_drop_document(ctx, src);
+    fz_drop_stream(ctx, stm);
+  }
+  fz_catch(ctx) { fz_rethrow(ctx); }
+  return xobj;
+}
+
+/**
+ * @brief 生成一段只包含给定文本的内容流
+ * @return 新流对象的间接引用，调用方负责释放
+ */
+pdf_obj* addContentStream(fz_context* ctx, pdf_document* doc,
+                          const QByteArray& text) {
+  fz_buffer* buf = fz_new_buffer_from_copied_data(
+      ctx, (const unsigned char*)text.constData(), text.size());
+  pdf_obj* stm = nullptr;
+  fz_try(ctx) { stm = pdf_add_stream(ctx, doc, buf, nullptr, 0); }
+  fz_always(ctx) { fz_drop_buffer(ctx, buf); }
+  fz_catch(ctx) { fz_rethrow(ctx); }
+  return stm;
+}
+
+/**
+ * @brief 生成绘制水印XObject的后缀内容流
+ *
+ * 水印页按显示方向生成，带/Rotate的页面需要把它旋转回页面坐标系，
+ * 并平移到MediaBox原点。
+ */
+QByteArray suffixFor(const PageGeometry& g, const QByteArray& name) {
+  float a = 1, b = 0, c = 0, d = 1, e = 0, f = 0;
+  switch (g.rotate) {
+    case 90:
+      a = 0, b = 1, c = -1, d = 0, e = g.height, f = 0;
+      break;
+    case 180:
+      a = -1, b = 0, c = 0, d = -1, e = g.width, f = g.height;
+      break;
+    case 270:
+      a = 0, b = -1, c = 1, d = 0, e = 0, f = g.width;
+      break;
+    default:
+      break;
+  }
+  e += g.x0;
+  f += g.y0;
+  return QString("\nQ q %1 %2 %3 %4 %5 %6 cm /%7 Do Q\n")
+      .arg(a).arg(b).arg(c).arg(d).arg(e).arg(f)
+      .arg(QString::fromLatin1(name))
+      .toLatin1();
+}
+
+}  // namespace
+
+/**
+ * @brief 以增量更新方式为PDF追加水印
+ * @param inFile 输入PDF文件路径
+ * @param outFile 输出PDF文件路径
+ * @param stampFor 按页面尺寸生成水印页的函数
+ * @return 处理结果，0表示成功，2表示失败
+ */
+int appendStampIncremental(const QString& inFile, const QString& outFile,
+                           const StampProvider& stampFor) {
+  fz_context* ctx = fz_new_context(NULL, NULL, FZ_STORE_DEFAULT);
+  if (!ctx) {
+    qDebug() << "创建MuPDF上下文失败";
+    return 2;
+  }
+
+  // MuPDF在Windows上按UTF-8解释文件名，不能使用本地代码页
+  QByteArray inPath = inFile.toUtf8();
+  bool inPlace = QFileInfo(inFile).absoluteFilePath() ==
+                 QFileInfo(outFile).absoluteFilePath();
+  // 除原地增量追加外都先写到临时文件，成功后再替换，失败时不留下残缺的输出
+  QString savePath = outFile + ".tmp";
+  QByteArray savePathUtf8;
+
+  pdf_document* doc = nullptr;
+  pdf_obj* prefix = nullptr;
+  std::map<PageGeometry, StampXObject> stamps;
+  std::map<std::pair<PageGeometry, QByteArray>, pdf_obj*> suffixes;
+  int result = 0;
+
+  fz_var(doc);
+  fz_var(prefix);
+
+  fz_try(ctx) {
+    doc = pdf_open_document(ctx, inPath.constData());
+    bool incremental = pdf_can_be_saved_incrementally(ctx, doc);
+
+    prefix = addContentStream(ctx, doc, "q\n");
+
+    int pages = pdf_count_pages(ctx, doc);
+    for (int i = 0; i < pages; i++) {
+      pdf_obj* page = pdf_lookup_page_obj(ctx, doc, i);
+      PageGeometry g = pageGeometry(ctx, page);
+
+      // 同一几何的页面共享一个水印XObject
+      StampXObject& stamp = stamps[g];
+      if (!stamp.xobj) {
+        stamp.data = stampFor(g.width, g.height);
+        if (stamp.data.isEmpty()) {
+          fz_throw(ctx, FZ_ERROR_GENERIC, "failed to build watermark stamp");
+        }
+        stamp.xobj = graftStamp(ctx, doc, stamp.data);
+      }
+
+      // 资源字典若继承自父节点，复制一份到页面上再修改
+      pdf_obj* res = pdf_dict_get(ctx, page, PDF_NAME(Resources));
+      if (!res) {
+        pdf_obj* inherited =
+            pdf_dict_get_inheritable(ctx, page, PDF_NAME(Resources));
+        res = inherited ? pdf_copy_dict(ctx, inherited)
+                        : pdf_new_dict(ctx, doc, 1);
+        pdf_dict_put_drop(ctx, page, PDF_NAME(Resources), res);
+      }
+      pdf_obj* xobjects = pdf_dict_get(ctx, res, PDF_NAME(XObject));
+      if (!xobjects) {
+        xobjects = pdf_dict_put_dict(ctx, res, PDF_NAME(XObject), 1);
+      }
+
+      // 选择一个不与已有资源冲突的名称（重复追加时也不会覆盖旧水印）
+      QByteArray name;
+      for (int n = 0;; n++) {
+        name = "WmkA" + QByteArray::number(n);
+        pdf_obj* existing = pdf_dict_gets(ctx, xobjects, name.constData());
+        if (!existing ||
+            pdf_to_num(ctx, existing) == pdf_to_num(ctx, stamp.xobj)) {
+          break;
+        }
+      }
+      pdf_dict_puts(ctx, xobjects, name.constData(), stamp.xobj);
+
+      pdf_obj*& suffix = suffixes[std::make_pair(g, name)];
+      if (!suffix) {
+        suffix = addContentStream(ctx, doc, suffixFor(g, name));
+      }
+
+      // /Contents改为 [前缀 原内容... 后缀]
+      pdf_obj* contents = pdf_dict_get(ctx, page, PDF_NAME(Contents));
+      pdf_obj* wrapped = pdf_new_array(ctx, doc, 3);
+      pdf_array_push(ctx, wrapped, prefix);
+      if (pdf_is_array(ctx, contents)) {
+        int n = pdf_array_len(ctx, contents);
+        for (int k = 0; k < n; k++) {
+          pdf_array_push(ctx, wrapped, pdf_array_get(ctx, contents, k));
+        }
+      } else if (contents) {
+        pdf_array_push(ctx, wrapped, contents);
+      }
+      pdf_array_push(ctx, wrapped, suffix);
+      pdf_dict_put_drop(ctx, page, PDF_NAME(Contents), wrapped);
+    }
+
+    pdf_write_options opts = pdf_default_write_options;
+    if (incremental) {
+      // MuPDF的增量保存以追加方式写入目标文件，因此先把原文件复制到临时文件
+      if (inPlace) {
+        savePath = outFile;
+      } else {
+        QFile::remove(savePath);
+        if (!QFile::copy(inFile, savePath)) {
+          fz_throw(ctx, FZ_ERROR_GENERIC, "cannot copy input to output");
+        }
+      }
+      opts.do_incremental = 1;
+    } else {
+      qDebug() << "文档无法增量保存，改为完整重写：" << inFile;
+      opts.do_compress = 1;
+    }
+    savePathUtf8 = savePath.toUtf8();
+    pdf_save_document(ctx, doc, savePathUtf8.constData(), &opts);
+  }
+  fz_always(ctx) {
+    for (auto& s : suffixes) pdf_drop_obj(ctx, s.second);
+    for (auto& s : stamps) pdf_drop_obj(ctx, s.second.xobj);
+    pdf_drop_obj(ctx, prefix);
+    pdf_drop_document(ctx, doc);
+  }
+  fz_catch(ctx) {
+    qDebug() << "追加水印失败：" << inFile << fz_caught_message(ctx);
+    result = 2;
+  }
+
+  fz_drop_context(ctx);
+
+  if (savePath != outFile) {
+    if (result == 0) {
+      QFile::remove(outFile);
+      if (!QFile::rename(savePath, outFile)) {
+        result = 2;
+      }
+    }
+    if (result != 0) {
+      QFile::remove(savePath);
+    }
+  }
+  return result;
+}
@@ -19,8 +19,10 @@
 #pragma execution_character_set("utf-8")
 #include <QDebug>                                          // Qt调试输出支持
 #include <QElapsedTimer>                                   // Qt计时器，用于性能测试
+#include <QFile>                                           // 删除旧的输出文件
 #include <QThread>                                         // Qt线程支持
 
+#include "include/function/ResultCache.h"                 // 处理结果缓存
 #include "include/mark/mark.h"                            // 水印处理相关头文件
 #include "include/mark/multiWatermarkThreadSingle.h"      // 多行水印线程类头文件
 
@@ -120,10 +122,11 @@ void multiWatermarkThreadSingle::setFontsize(QString fontsize) {
  * 
  * 该函数是QRunnable接口的实现，会在Qt线程池中的工作线程中执行。
  * 主要功能：
- * 1. 调用addWatermark_multiline函数为PDF文件添加多行文本水印
- * 2. 进行必要的数据类型转换（字符串转数值类型）
- * 3. 使用互斥锁保护共享的结果映射表
- * 4. 发射完成信号通知主线程处理结果
+ * 1. 输入文件内容和水印参数与以前某次处理相同时，直接从ResultCache取出结果
+ * 2. 否则调用addWatermark_multiline函数为PDF文件添加多行文本水印，成功后存入缓存
+ * 3. 进行必要的数据类型转换（字符串转数值类型）
+ * 4. 使用互斥锁保护共享的结果映射表
+ * 5. 发射完成信号通知主线程处理结果
  * 
  * 与单行水印处理的区别：
  * - 使用addWatermark_multiline函数而非addWatermark
@@ -155,9 +158,25 @@ void multiWatermarkThreadSingle::run() {
   // - m_color: 文本颜色
   // - m_rotate.toDouble(): 旋转角度（转换为double）
   // - m_opacity.toDouble() / 100: 透明度（转换为0-1之间的小数）
-  int r = addWatermark_multiline(m_input.toStdString(), m_output.toStdString(),
-                                 m_text, m_font, m_fontsize.toInt(), m_color,
-                                 m_rotate.toDouble(), m_opacity.toDouble() / 100);
+  ResultCache* cache = ResultCache::shared();
+  QString key = cache->key("watermark-multiline", m_input,
+                           QStringList() << m_text << m_font << m_fontsize
+                                         << m_color << m_rotate << m_opacity);
+  int r = 0;
+  if (cache->fetch(key, m_output)) {
+    qDebug() << "命中结果缓存：" << m_input;
+  } else {
+    // 上次的输出可能是缓存条目的硬链接，先删除再写，避免原地改写缓存
+    if (m_output != m_input) {
+      QFile::remove(m_output);
+    }
+    r = addWatermark_multiline(m_input.toStdString(), m_output.toStdString(),
+                               m_text, m_font, m_fontsize.toInt(), m_color,
+                               m_rotate.toDouble(), m_opacity.toDouble() / 100);
+    if (r == 0) {
+      cache->store(key, m_output);
+    }
+  }
 
   // 使用互斥锁保护共享资源，确保多线程安全
   m_mutex->lock();
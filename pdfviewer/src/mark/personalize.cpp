@@ -0,0 +1,213 @@
+/**
+ * @file personalize.cpp
+ * @brief 批量个性化水印实现
+ *
+ * 收件人列表按工作线程数切成连续的几段，每段由一个线程处理：
+ * 线程内的会话先让输入文档常驻，然后逐个收件人替换水印文本并写出。
+ * 输入文档因此只被解析"工作线程数"次，而与收件人数量无关。
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma execution_character_set("utf-8") // 设置编译器使用UTF-8字符集
+#include "include/mark/personalize.h"
+
+#include <QAtomicInt>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+
+namespace {
+
+/**
+ * @brief 拆分一行CSV
+ * @param line 一行文本
+ * @return 各字段
+ */
+QStringList splitCsvLine(const QString& line) {
+  QStringList fields;
+  QString field;
+  bool quoted = false;
+  for (int i = 0; i < line.size(); i++) {
+    QChar ch = line.at(i);
+    if (quoted) {
+      if (ch == '"') {
+        if (i + 1 < line.size() && line.at(i + 1) == '"') {
+          field.append('"');  // 两个连续双引号表示一个双引号
+          i++;
+        } else {
+          quoted = false;
+        }
+      } else {
+        field.append(ch);
+      }
+    } else if (ch == '"') {
+      quoted = true;
+    } else if (ch == ',') {
+      fields.append(field.trimmed());
+      field.clear();
+    } else {
+      field.append(ch);
+    }
+  }
+  fields.append(field.trimmed());
+  return fields;
+}
+
+/**
+ * @brief 生成不与已有输出重名的文件路径
+ * @param path 期望的输出路径
+ * @param used 已使用的路径（小写，Windows文件名不区分大小写），结果会加入其中
+ * @return path本身，重名时在扩展名前追加"_2"、"_3"……
+ */
+QString uniqueOutFile(const QString& path, QSet<QString>& used) {
+  QFileInfo info(path);
+  QString candidate = info.absoluteFilePath();
+  for (int n = 2; used.contains(candidate.toLower()); n++) {
+    QString suffix = info.suffix();
+    candidate = info.absoluteDir().filePath(
+        info.completeBaseName() + "_" + QString::number(n) +
+        (suffix.isEmpty() ? QString() : "." + suffix));
+  }
+  used.insert(candidate.toLower());
+  return candidate;
+}
+
+}  // namespace
+
+/**
+ * @brief 读取收件人CSV文件
+ * @param csvFile CSV文件路径
+ * @param inFile 输入PDF文件路径
+ * @param outputDir 输出目录
+ * @return 收件人列表，重名的输出文件名追加序号
+ */
+QList<Recipient> readRecipients(const QString& csvFile, const QString& inFile,
+                                const QString& outputDir) {
+  QList<Recipient> recipients;
+  QFile file(csvFile);
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    qDebug() << "无法打开收件人列表：" << csvFile;
+    return recipients;
+  }
+
+  QTextStream in(&file);
+  in.setCodec("UTF-8");
+  QString baseName = QFileInfo(inFile).completeBaseName();
+  QDir dir(outputDir);
+  QSet<QString> used;
+  while (!in.atEnd()) {
+    QString line = in.readLine();
+    if (line.trimmed().isEmpty()) {
+      continue;
+    }
+    QStringList fields = splitCsvLine(line);
+    Recipient recipient;
+    recipient.text = fields.at(0);
+    QString name = fields.size() > 1 ? fields.at(1) : QString();
+    if (name.isEmpty()) {
+      name = baseName + "_" + QString::number(recipients.size() + 1) + ".pdf";
+    }
+    // 重名的输出会互相覆盖，结果表中也只剩最后一份
+    QString outFile = uniqueOutFile(dir.filePath(name), used);
+    if (QFileInfo(outFile).fileName() != QFileInfo(name).fileName()) {
+      qDebug() << "输出文件名重复，改为：" << outFile;
+    }
+    recipient.outFile = outFile;
+    recipients.append(recipient);
+  }
+  return recipients;
+}
+
+/**
+ * @brief 为同一输入文档生成多份不同水印文本的输出
+ * @param inFile 输入PDF文件路径
+ * @param recipients 收件人列表
+ * @param params 水印参数
+ * @param result 接收每个输出文件的处理结果
+ * @param progress 进度回调
+ * @param workers 并发数
+ * @return 全部成功返回0，否则返回2
+ */
+int personalize(const QString& inFile, const QList<Recipient>& recipients,
+                const WatermarkParams& params, QMap<QString, int>* result,
+                const PersonalizeProgress& progress, int workers) {
+  if (recipients.isEmpty()) {
+    return 0;
+  }
+
+  // 输入只读取一次，各线程的PVF直接引用这份数据
+  QFile file(inFile);
+  if (!file.open(QIODevice::ReadOnly)) {
+    qDebug() << "无法读取输入文件：" << inFile;
+    return 2;
+  }
+  const QByteArray data = file.readAll();
+  file.close();
+
+  if (workers <= 0) {
+    workers = QThread::idealThreadCount();
+  }
+  int total = recipients.size();
+  workers = std::max(1, std::min(workers, total));
+  int perWorker = (total + workers - 1) / workers;
+
+  QMutex mutex;
+  QAtomicInt done;
+  QAtomicInt failed;
+
+  QThreadPool pool;
+  pool.setMaxThreadCount(workers);
+  QList<QFuture<void>> futures;
+  for (int first = 0; first < total; first += perWorker) {
+    int last = std::min(first + perWorker, total);
+    futures.append(QtConcurrent::run(&pool, [&, first, last]() {
+      WatermarkParams current = params;
+      current.text = recipients.at(first).text;
+      WatermarkSession& session = WatermarkSession::forCurrentThread(current);
+
+      bool resident = session.openResident(inFile, data);
+      for (int i = first; i < last; i++) {
+        const Recipient& recipient = recipients.at(i);
+        int r = 2;
+        if (resident) {
+          current.text = recipient.text;
+          session.setParams(current);
+          r = session.processResident(recipient.outFile);
+          if (r != 0) {
+            // 出现异常时会话丢弃了常驻文档，重新打开后继续处理本段的其余收件人
+            resident = session.openResident(inFile, data);
+          }
+        }
+        if (r != 0) {
+          failed.fetchAndAddRelaxed(1);
+        }
+        if (result) {
+          QMutexLocker locker(&mutex);
+          result->insert(recipient.outFile, r);
+        }
+        int finished = done.fetchAndAddRelaxed(1) + 1;
+        if (progress) {
+          progress(finished, total);
+        }
+      }
+      // 数据只在本次调用中有效，线程会话不能继续持有
+      session.closeResident();
+    }));
+  }
+  for (QFuture<void>& future : futures) {
+    future.waitForFinished();
+  }
+
+  return failed.load() == 0 ? 0 : 2;
+}
@@ -0,0 +1,602 @@
+/**
+ * @file watermarkSession.cpp
+ * @brief 可复用的PDF水印会话类实现
+ *
+ * 实现WatermarkSession类，将PDFlib对象创建、searchpath设置、
+ * 字体加载和选项列表拼接等固定开销在整个批处理过程中只执行一次，
+ * 每个文件只承担打开输入、生成模板、导入页面和写出文档的开销。
+ *
+ * @author Qt PDF工具集项目组
+ * @date 2023
+ */
+
+#pragma execution_character_set("utf-8") // 设置编译器使用UTF-8字符集
+#include "include/mark/watermarkSession.h"
+
+#include <QAtomicInt>
+#include <QThreadStorage>
+#include <QtMath>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+#include "include/function/ParallelWatermark.h"
+#include "include/function/StringConverter.h"
+#include "include/mark/incrementalStamp.h"
+#include "include/mark/mark.h" // 包含GetFontsFolder函数声明
+
+using namespace std;
+using namespace pdflib;
+
+/**
+ * @brief 构造函数，使用默认水印参数
+ */
+WatermarkSession::WatermarkSession() { buildOptionLists(); }
+
+/**
+ * @brief 构造函数
+ * @param params 水印参数
+ */
+WatermarkSession::WatermarkSession(const WatermarkParams& params)
+    : m_params(params) {
+  buildOptionLists();
+}
+
+WatermarkSession::~WatermarkSession() = default;
+
+/**
+ * @brief 设置水印参数
+ * @param params 新的水印参数
+ *
+ * 字体句柄在对象作用域内有效，只有字体名称变化时才需要重新加载，
+ * 文本、颜色、透明度、角度只影响选项列表。
+ */
+void WatermarkSession::setParams(const WatermarkParams& params) {
+  if (params == m_params) {
+    return;
+  }
+  if (params.tileColumns != m_params.tileColumns ||
+      params.tileRows != m_params.tileRows) {
+    m_grids.clear();  // 网格只与页面尺寸和行列数有关
+  }
+  m_params = params;
+  m_stamps.clear();
+  buildOptionLists();
+}
+
+/**
+ * @brief 预先拼接模板和文本行的选项列表
+ */
+void WatermarkSession::buildOptionLists() {
+  m_text = StringConverter::QString2WString(m_params.text);
+  m_templateOptions = L"watermark={location=ontop opacity=" +
+                      StringConverter::QString2WString(m_params.opacity) +
+                      L"}";
+  m_anchorOptions.clear();
+  for (const WatermarkAnchor& anchor : m_params.anchors) {
+    m_anchorOptions.push_back(
+        L"watermark={location=ontop opacity=" +
+        StringConverter::QString2WString(m_params.opacity) +
+        L"  horizalign=right horizshift=-200 scale=" +
+        StringConverter::QString2WString(anchor.scale) + L" vertalign=" +
+        StringConverter::QString2WString(anchor.vertalign) + L" vertshift=" +
+        StringConverter::QString2WString(anchor.vertshift) + L"}  topdown=true");
+  }
+  // 字体句柄在ensureReady()中填入，这里只拼接与字体无关的部分
+  m_textOptions = L" fontsize=10 fillcolor=" +
+                  StringConverter::QString2WString(m_params.color) +
+                  L" boxsize={95 42}  rotate=" +
+                  StringConverter::QString2WString(m_params.rotate);
+  // 平铺模板只包含文本本身，模板尺寸即文本旋转后的外接矩形
+  m_tileTextOptions = L" fontsize=24 fillcolor=" +
+                      StringConverter::QString2WString(m_params.color) +
+                      L" rotate=" +
+                      StringConverter::QString2WString(m_params.rotate) +
+                      L" position=center";
+}
+
+namespace {
+
+/**
+ * @brief 生成会话内唯一的PVF虚拟文件名
+ */
+std::wstring nextPvfName(const std::wstring& prefix) {
+  static QAtomicInt serial;
+  return L"/pvf/" + prefix + L"/" +
+         std::to_wstring(serial.fetchAndAddRelaxed(1)) + L".pdf";
+}
+
+/**
+ * @brief 把"15%"或"0.15"形式的透明度转换为0~1的小数
+ */
+double opacityValue(const QString& opacity) {
+  QString value = opacity.trimmed();
+  if (value.endsWith('%')) {
+    value.chop(1);
+    return value.toDouble() / 100.0;
+  }
+  return value.toDouble();
+}
+
+}  // namespace
+
+/**
+ * @brief 丢弃PDFlib对象
+ *
+ * PDFlib发生异常后对象只允许被删除，且文档作用域中途出错时也无法
+ * 回到对象作用域，因此出错后直接丢弃，下次使用时重新创建。
+ */
+void WatermarkSession::reset() {
+  m_pdf.reset();
+  m_font = -1;
+  m_fontName.clear();
+  m_residentDoc = -1;
+  m_residentPageCount = 0;
+  m_residentPvf.clear();
+}
+
+/**
+ * @brief 在当前文档中生成水印模板
+ *
+ * 模板带watermark选项，PDFlib会自动把它放到之后的每一页上。
+ * 设置了锚点时每个锚点生成一个模板，所有锚点在同一次页面导入中放置。
+ */
+void WatermarkSession::buildTemplate() {
+  PDFlib& p = *m_pdf;
+  wostringstream textOptions;
+  textOptions << L"font=" << m_font << m_textOptions;
+
+  if (m_params.tiled()) {
+    buildTileTemplate();
+    return;
+  }
+  if (m_anchorOptions.empty()) {
+    p.begin_template_ext(0, 0, m_templateOptions);
+    p.fit_textline(m_text, 100, 100, textOptions.str());
+    p.end_template_ext(0, 0);
+    return;
+  }
+  for (const wstring& options : m_anchorOptions) {
+    p.begin_template_ext(10, 10, options);
+    p.fit_textline(m_text, 800, 200, textOptions.str());
+    p.end_template_ext(0, 0);
+  }
+}
+
+/**
+ * @brief 生成平铺用的水印模板（Form XObject）
+ *
+ * 文本只在模板中绘制一次，透明度也放在模板内部的图形状态里，
+ * 页面上每个网格位置只需一条"q cm /Fm Do Q"引用。
+ */
+void WatermarkSession::buildTileTemplate() {
+  PDFlib& p = *m_pdf;
+  wostringstream metricOptions;
+  metricOptions << L"font=" << m_font << L" fontsize=24";
+  double textWidth = p.info_textline(m_text, L"width", metricOptions.str());
+  double textHeight = 24;
+
+  // 旋转后文本的外接矩形
+  double radians = qDegreesToRadians(m_params.rotate.toDouble());
+  double c = std::fabs(std::cos(radians));
+  double s = std::fabs(std::sin(radians));
+  double width = textWidth * c + textHeight * s;
+  double height = textWidth * s + textHeight * c;
+
+  wostringstream gstateOptions;
+  gstateOptions << L"opacityfill=" << opacityValue(m_params.opacity);
+  int gstate = p.create_gstate(gstateOptions.str());
+
+  m_tile = p.begin_template_ext(width, height, L"");
+  p.set_gstate(gstate);
+  wostringstream textOptions;
+  textOptions << L"font=" << m_font << m_tileTextOptions;
+  p.fit_textline(m_text, width / 2, height / 2, textOptions.str());
+  p.end_template_ext(0, 0);
+}
+
+/**
+ * @brief 在当前页面的每个网格单元中放置平铺模板
+ * @param width 页面宽度
+ * @param height 页面高度
+ *
+ * 网格只与页面尺寸有关，按尺寸缓存后在页面和文件之间复用。
+ */
+void WatermarkSession::placeTiles(double width, double height) {
+  std::pair<int, int> key((int)(width + 0.5), (int)(height + 0.5));
+  auto it = m_grids.find(key);
+  if (it == m_grids.end()) {
+    std::vector<QRectF> cells;
+    double cellWidth = width / m_params.tileColumns;
+    double cellHeight = height / m_params.tileRows;
+    for (int row = 0; row < m_params.tileRows; row++) {
+      for (int col = 0; col < m_params.tileColumns; col++) {
+        // 每个单元四周各留10%的空白，相邻水印之间不会粘连
+        cells.push_back(QRectF(col * cellWidth + cellWidth * 0.1,
+                               row * cellHeight + cellHeight * 0.1,
+                               cellWidth * 0.8, cellHeight * 0.8));
+      }
+    }
+    it = m_grids.emplace(key, cells).first;
+  }
+
+  PDFlib& p = *m_pdf;
+  for (const QRectF& cell : it->second) {
+    wostringstream options;
+    options << L"boxsize={" << cell.width() << L" " << cell.height()
+            << L"} position=center fitmethod=meet";
+    p.fit_image(m_tile, cell.x(), cell.y(), options.str());
+  }
+}
+
+/**
+ * @brief 按字体名称加载水印字体
+ * @param p PDFlib对象
+ * @param font 字体名称
+ * @return 字体句柄，失败返回-1
+ */
+int WatermarkSession::loadFont(PDFlib& p, const wstring& font) {
+  if (font == L"NSimSun") {
+    p.set_option(L"FontOutline={NSimSun=simsun.ttc}");
+    return p.load_font(L"NSimSun", L"unicode", L"embedding");
+  }
+  p.set_option(L"FontOutline={" + font + L"=" + font + L".ttf}");
+  return p.load_font(font, L"unicode", L"");
+}
+
+/**
+ * @brief 确保PDFlib对象和字体已就绪
+ * @return 就绪返回true，字体加载失败返回false
+ */
+bool WatermarkSession::ensureReady() {
+  if (!m_pdf) {
+    m_pdf.reset(new PDFlib());
+    const wstring searchpath = L"./PDFlib-CMap-5.0/resource/cmap";
+    wostringstream optlist;
+    optlist << L"searchpath={{" << searchpath << L"}";
+    optlist << L" {" << GetFontsFolder() << L"}}";
+    m_pdf->set_option(optlist.str());
+  }
+
+  wstring fontName = StringConverter::QString2WString(m_params.font);
+  if (m_font == -1 || fontName != m_fontName) {
+    // 在对象作用域中加载，字体句柄可在之后的所有文档中使用
+    m_font = loadFont(*m_pdf, fontName);
+    if (m_font == -1) {
+      wcerr << L"Error: " << m_pdf->get_errmsg() << endl;
+      m_fontName.clear();
+      return false;
+    }
+    m_fontName = fontName;
+  }
+  return true;
+}
+
+/**
+ * @brief 把已打开输入文档的指定页面加上水印写入新文档
+ * @param outfile 输出文件路径，为空时写入内存，之后可用get_buffer取出
+ * @param indoc 已打开的PDI文档句柄
+ * @param first 起始页（从1开始）
+ * @param last 结束页（包含）
+ * @return 0表示成功，2表示失败
+ */
+int WatermarkSession::writeDocument(const wstring& outfile, int indoc,
+                                    int first, int last) {
+  PDFlib& p = *m_pdf;
+  if (p.begin_document(outfile, L"") == -1) {
+    wcerr << L"Error: " << p.get_errmsg() << endl;
+    return 2;
+  }
+  p.set_info(L"Creator", L"泛生态业务工具集");
+  p.set_info(L"Title", L"本文档来自于泛生态业务投标案例");
+
+  // 模板属于文档作用域，每个文档重新生成；字体已加载，这一步很轻
+  buildTemplate();
+
+  // PDI页面句柄属于当前输出文档，每个文档重新打开；
+  // 输入文档已解析，打开页面只读取该页的对象
+  for (int pageno = first; pageno <= last; pageno++) {
+    int page = p.open_pdi_page(indoc, pageno, L"");
+    if (page == -1) {
+      wcerr << L"Error: " << p.get_errmsg() << endl;
+      continue;
+    }
+    p.begin_page_ext(0, 0, L"width=a4.width height=a4.height");
+    p.fit_pdi_page(page, 0, 0, L"adjustpage");
+    if (m_params.tiled()) {
+      placeTiles(p.get_option(L"pagewidth", L""),
+                 p.get_option(L"pageheight", L""));
+    }
+    p.close_pdi_page(page);
+    p.end_page_ext(L"");
+  }
+  p.end_document(L"");
+  return 0;
+}
+
+/**
+ * @brief 为一个PDF文件添加水印
+ * @param inFile 输入PDF文件路径
+ * @param outFile 输出PDF文件路径
+ * @return 处理结果，0表示成功，2表示失败
+ */
+int WatermarkSession::process(const QString& inFile, const QString& outFile) {
+  if (m_params.mode == WatermarkMode::Append) {
+    return appendStampIncremental(
+        inFile, outFile,
+        [this](double width, double height) { return stampPage(width, height); });
+  }
+
+  wstring infile = StringConverter::QString2WString(inFile);
+  wstring outfile = StringConverter::QString2WString(outFile);
+
+  try {
+    if (!ensureReady()) {
+      return 2;
+    }
+    PDFlib& p = *m_pdf;
+
+    // 先打开输入文档，失败时PDFlib仍处于对象作用域，会话可以继续使用
+    int indoc = p.open_pdi_document(infile, L"");
+    if (indoc == -1) {
+      wcerr << L"Error: " << p.get_errmsg() << endl;
+      return 2;
+    }
+    int endpage = (int)p.pcos_get_number(indoc, L"length:pages");
+
+    // 页数很多时拆分为多个页面范围并发处理，每个工作线程使用自己的会话
+    if (ParallelWatermark::shouldSplit(endpage)) {
+      p.close_pdi_document(indoc);
+      WatermarkParams params = m_params;
+      return ParallelWatermark::run(
+          inFile, outFile, endpage, [params, inFile](int first, int last) {
+            return WatermarkSession::forCurrentThread(params).renderRange(
+                inFile, first, last);
+          });
+    }
+
+    int result = writeDocument(outfile, indoc, 1, endpage);
+    p.close_pdi_document(indoc);
+    return result;
+  } catch (PDFlib::Exception& ex) {
+    wcerr << L"PDFlib 发生异常: " << endl
+          << L"[" << ex.get_errnum() << L"] " << ex.get_apiname() << L": "
+          << ex.get_errmsg() << endl
+          << L": " << L"错误的参数选项请使用 - h参数查看帮助" << endl;
+    reset();
+    return 2;
+  }
+}
+
+/**
+ * @brief 为内存中的PDF添加水印
+ * @param pdfData 输入PDF文件内容
+ * @return 加水印后的PDF文件内容，失败返回空数组
+ */
+QByteArray WatermarkSession::processBuffer(const QByteArray& pdfData) {
+  QByteArray result;
+  try {
+    if (!ensureReady()) {
+      return result;
+    }
+    PDFlib& p = *m_pdf;
+    const wstring pvf = nextPvfName(L"buffer");
+    p.create_pvf(pvf, pdfData.constData(), pdfData.size(), L"");
+    int indoc = p.open_pdi_document(pvf, L"");
+    if (indoc == -1) {
+      wcerr << L"Error: " << p.get_errmsg() << endl;
+      p.delete_pvf(pvf);
+      return result;
+    }
+    int endpage = (int)p.pcos_get_number(indoc, L"length:pages");
+    if (writeDocument(L"", indoc, 1, endpage) == 0) {
+      long len = 0;
+      const char* buf = p.get_buffer(&len);
+      result = QByteArray(buf, (int)len);
+    }
+    p.close_pdi_document(indoc);
+    p.delete_pvf(pvf);
+  } catch (PDFlib::Exception& ex) {
+    wcerr << L"PDFlib 发生异常: " << endl
+          << L"[" << ex.get_errnum() << L"] " << ex.get_apiname() << L": "
+          << ex.get_errmsg() << endl;
+    reset();
+    return QByteArray();
+  }
+  return result;
+}
+
+/**
+ * @brief 为输入文档的一个页面范围加水印，结果保存在内存中
+ * @param inFile 输入PDF文件路径
+ * @param first 起始页（从1开始）
+ * @param last 结束页（包含）
+ * @return 只包含这些页面的PDF数据，失败返回空数组
+ */
+QByteArray WatermarkSession::renderRange(const QString& inFile, int first,
+                                         int last) {
+  QByteArray result;
+  try {
+    if (!ensureReady()) {
+      return result;
+    }
+    PDFlib& p = *m_pdf;
+    int indoc = p.open_pdi_document(StringConverter::QString2WString(inFile), L"");
+    if (indoc == -1) {
+      wcerr << L"Error: " << p.get_errmsg() << endl;
+      return result;
+    }
+    if (writeDocument(L"", indoc, first, last) == 0) {
+      long len = 0;
+      const char* buf = p.get_buffer(&len);
+      result = QByteArray(buf, (int)len);
+    }
+    p.close_pdi_document(indoc);
+  } catch (PDFlib::Exception& ex) {
+    wcerr << L"PDFlib 发生异常: " << endl
+          << L"[" << ex.get_errnum() << L"] " << ex.get_apiname() << L": "
+          << ex.get_errmsg() << endl;
+    reset();
+    return QByteArray();
+  }
+  return result;
+}
+
+/**
+ * @brief 生成指定页面尺寸的单页水印PDF
+ * @param width 页面宽度（点）
+ * @param height 页面高度（点）
+ * @return 单页PDF数据，失败返回空数组
+ *
+ * 在内存中生成一个只有一页的文档，页面上由同一个水印模板自动放置，
+ * 因此追加模式与重建模式的水印外观一致。
+ */
+QByteArray WatermarkSession::stampPage(double width, double height) {
+  std::pair<int, int> key((int)(width + 0.5), (int)(height + 0.5));
+  auto it = m_stamps.find(key);
+  if (it != m_stamps.end()) {
+    return it->second;
+  }
+
+  QByteArray stamp;
+  try {
+    if (!ensureReady()) {
+      return stamp;
+    }
+    PDFlib& p = *m_pdf;
+    if (p.begin_document(L"", L"") == -1) {
+      wcerr << L"Error: " << p.get_errmsg() << endl;
+      return stamp;
+    }
+    buildTemplate();
+    p.begin_page_ext(width, height, L"");
+    if (m_params.tiled()) {
+      placeTiles(width, height);
+    }
+    p.end_page_ext(L"");
+    p.end_document(L"");
+
+    long len = 0;
+    const char* buf = p.get_buffer(&len);
+    stamp = QByteArray(buf, (int)len);
+  } catch (PDFlib::Exception& ex) {
+    wcerr << L"PDFlib 发生异常: " << endl
+          << L"[" << ex.get_errnum() << L"] " << ex.get_apiname() << L": "
+          << ex.get_errmsg() << endl;
+    reset();
+    return QByteArray();
+  }
+  m_stamps[key] = stamp;
+  return stamp;
+}
+
+/**
+ * @brief 把输入文档解析一次并常驻在会话中
+ * @param inFile 输入PDF文件路径
+ * @param data 输入PDF的完整内容
+ * @return 成功返回true
+ *
+ * 输入数据通过PVF交给PDFlib，不复制；多个线程的会话可以共用同一份数据。
+ * 只有PVF和PDI文档句柄常驻，页面句柄属于输出文档，在writeDocument中打开。
+ */
+bool WatermarkSession::openResident(const QString& inFile,
+                                    const QByteArray& data) {
+  try {
+    if (!ensureReady()) {
+      return false;
+    }
+    closeResident();
+    PDFlib& p = *m_pdf;
+
+    m_residentPvf = nextPvfName(L"resident");
+    p.create_pvf(m_residentPvf, data.constData(), data.size(), L"");
+    m_residentDoc = p.open_pdi_document(m_residentPvf, L"");
+    if (m_residentDoc == -1) {
+      wcerr << L"Error: " << StringConverter::QString2WString(inFile) << L" "
+            << p.get_errmsg() << endl;
+      closeResident();
+      return false;
+    }
+
+    m_residentPageCount =
+        (int)p.pcos_get_number(m_residentDoc, L"length:pages");
+  } catch (PDFlib::Exception& ex) {
+    wcerr << L"PDFlib 发生异常: " << endl
+          << L"[" << ex.get_errnum() << L"] " << ex.get_apiname() << L": "
+          << ex.get_errmsg() << endl;
+    reset();
+    return false;
+  }
+  return true;
+}
+
+/**
+ * @brief 把常驻文档加上当前参数的水印写出
+ * @param outFile 输出PDF文件路径
+ * @return 处理结果，0表示成功，2表示失败
+ */
+int WatermarkSession::processResident(const QString& outFile) {
+  if (m_residentDoc == -1) {
+    return 2;
+  }
+  try {
+    // 文本变化只影响选项列表，字体已加载，这里不会重新加载
+    if (!ensureReady()) {
+      return 2;
+    }
+    return writeDocument(StringConverter::QString2WString(outFile),
+                         m_residentDoc, 1, m_residentPageCount);
+  } catch (PDFlib::Exception& ex) {
+    wcerr << L"PDFlib 发生异常: " << endl
+          << L"[" << ex.get_errnum() << L"] " << ex.get_apiname() << L": "
+          << ex.get_errmsg() << endl;
+    reset();
+    return 2;
+  }
+}
+
+/**
+ * @brief 关闭常驻文档并释放对应的虚拟文件
+ */
+void WatermarkSession::closeResident() {
+  if (!m_pdf) {
+    return;
+  }
+  PDFlib& p = *m_pdf;
+  try {
+    if (m_residentDoc != -1) {
+      p.close_pdi_document(m_residentDoc);
+    }
+    if (!m_residentPvf.empty()) {
+      p.delete_pvf(m_residentPvf);
+    }
+  } catch (PDFlib::Exception& ex) {
+    wcerr << L"PDFlib 发生异常: " << endl
+          << L"[" << ex.get_errnum() << L"] " << ex.get_apiname() << L": "
+          << ex.get_errmsg() << endl;
+    reset();
+    return;
+  }
+  m_residentDoc = -1;
+  m_residentPageCount = 0;
+  m_residentPvf.clear();
+}
+
+/**
+ * @brief 获取当前工作线程专属的会话
+ * @param params 水印参数
+ * @return 当前线程的会话对象
+ *
+ * QThreadPool中的工作线程会被复用，同一线程上先后执行的任务
+ * 共享同一个会话，线程退出时QThreadStorage负责释放。
+ */
+WatermarkSession& WatermarkSession::forCurrentThread(
+    const WatermarkParams& params) {
+  static QThreadStorage<WatermarkSession*> sessions;
+  if (!sessions.hasLocalData()) {
+    sessions.setLocalData(new WatermarkSession(params));
+  }
+  WatermarkSession* session = sessions.localData();
+  session->setParams(params);
+  return *session;
+}
@@ -23,6 +23,7 @@
 #include <QThread>
 
 #include "../../include/mark/mark.h"
+#include "include/mark/watermarkSession.h"
 #include "function.h"
 
 /**
@@ -101,6 +102,22 @@ void watermarkThread::setFont(QString font) { m_font = font; }
  */
 void watermarkThread::setRotate(QString rotate) { m_rotate = rotate; }
 
+/**
+ * @brief 设置是否使用追加（增量更新）模式
+ * @param append true时追加共享水印XObject，不重新导入页面
+ */
+void watermarkThread::setAppendMode(bool append) { m_append = append; }
+
+/**
+ * @brief 设置平铺水印的网格
+ * @param columns 列数
+ * @param rows 行数，与列数均大于0时启用平铺模式，否则使用单条水印
+ */
+void watermarkThread::setTileGrid(int columns, int rows) {
+  m_tileColumns = columns;
+  m_tileRows = rows;
+}
+
 /**
  * @brief 设置水印字体大小
  * @param fontsize 字体大小值
@@ -111,6 +128,7 @@ void watermarkThread::setFontsize(QString fontsize) { m_fontsize = fontsize; }
  * @brief 水印处理线程的主要执行方法
  * 
  * 在独立线程中批量处理PDF文件，为每个文件添加水印
+ * 整个文件列表共用一个WatermarkSession，字体和PDFlib对象只初始化一次
  * 使用QElapsedTimer计时，处理完成后通过信号通知主线程
  */
 void watermarkThread::run() {
@@ -122,6 +140,18 @@ void watermarkThread::run() {
   QMap<QString, int> map;  // 存储处理结果的映射表
   int milsec = time.elapsed();
 
+  // 水印参数在整个批次中不变，所有文件共用同一个会话
+  WatermarkParams params;
+  params.text = m_text;
+  params.opacity = m_opacity;
+  params.color = m_color;
+  params.rotate = m_rotate;
+  params.font = m_font;
+  params.mode = m_append ? WatermarkMode::Append : WatermarkMode::Rebuild;
+  params.tileColumns = m_tileColumns;
+  params.tileRows = m_tileRows;
+  WatermarkSession session(params);
+
   // 遍历处理每个PDF文件
   for (const QString& file : m_files) {
     // 输出调试信息：当前处理的文件和输出路径
@@ -133,15 +163,10 @@ void watermarkThread::run() {
     qDebug() << "颜色：" << m_color << "旋转：" << m_rotate;
     qDebug() << "字体：" << m_font;
     
-    // 调用水印添加功能，处理单个PDF文件
-    int r = addWatermark(
+    // 使用会话处理单个PDF文件
+    int r = session.process(
         file,  // 输入文件路径
-        pathChange(m_input, m_output, file, "_out_").replace("//", "/"),  // 输出文件路径
-        m_text,     // 水印文本
-        m_opacity,  // 透明度
-        m_color,    // 颜色
-        m_rotate,   // 旋转角度
-        m_font);    // 字体
+        pathChange(m_input, m_output, file, "_out_").replace("//", "/"));  // 输出文件路径
     
     // 保存处理结果到映射表
     map.insert(m_filename, r);
@@ -19,9 +19,12 @@
 
 #include <QDebug>        // Qt调试输出支持
 #include <QElapsedTimer> // Qt计时器，用于测量执行时间
+#include <QFile>         // 删除旧的输出文件
 #include <QThread>       // Qt线程支持
 
+#include "include/function/ResultCache.h" // 处理结果缓存
 #include "include/mark/mark.h" // 水印功能相关头文件
+#include "include/mark/watermarkSession.h" // 可复用水印会话
 
 /**
  * @brief 构造函数 - 用于批量水印处理
@@ -98,6 +101,22 @@ void watermarkThreadSingle::setFont(QString font) { m_font = font; }
  */
 void watermarkThreadSingle::setRotate(QString rotate) { m_rotate = rotate; }
 
+/**
+ * @brief 设置是否使用追加（增量更新）模式
+ * @param append true时追加共享水印XObject，不重新导入页面
+ */
+void watermarkThreadSingle::setAppendMode(bool append) { m_append = append; }
+
+/**
+ * @brief 设置平铺水印的网格
+ * @param columns 列数
+ * @param rows 行数，与列数均大于0时启用平铺模式，否则使用单条水印
+ */
+void watermarkThreadSingle::setTileGrid(int columns, int rows) {
+  m_tileColumns = columns;
+  m_tileRows = rows;
+}
+
 /**
  * @brief 设置水印字体大小
  * @param fontsize 字体大小
@@ -111,9 +130,11 @@ void watermarkThreadSingle::setFontsize(QString fontsize) {
  * 
  * 该函数是QRunnable接口的实现，会在Qt线程池中的工作线程中执行
  * 主要功能：
- * 1. 调用addWatermark函数为PDF文件添加水印
- * 2. 使用互斥锁保护共享的结果映射表
- * 3. 发射完成信号通知主线程
+ * 1. 输入文件内容和水印参数与以前某次处理相同时，直接从ResultCache取出结果
+ * 2. 否则使用当前工作线程的WatermarkSession为PDF文件添加水印，
+ *    同一线程上先后执行的任务复用已加载的字体和PDFlib对象，成功后存入缓存
+ * 3. 使用互斥锁保护共享的结果映射表
+ * 4. 发射完成信号通知主线程
  */
 void watermarkThreadSingle::run() {
   // 注释的调试代码 - 用于显示当前线程地址
@@ -128,7 +149,37 @@ void watermarkThreadSingle::run() {
   // if ((!m_input.contains("_out_")) && (!m_input.contains("_pdf_"))) {
   
   // 执行水印添加操作，返回处理结果（0表示成功，其他值表示错误码）
-  int r = addWatermark(m_input, m_output, m_text, m_opacity, m_color, m_rotate, m_font);
+  WatermarkParams params;
+  params.text = m_text;
+  params.opacity = m_opacity;
+  params.color = m_color;
+  params.rotate = m_rotate;
+  params.font = m_font;
+  params.mode = m_append ? WatermarkMode::Append : WatermarkMode::Rebuild;
+  params.tileColumns = m_tileColumns;
+  params.tileRows = m_tileRows;
+
+  // 缓存键包含全部影响输出的参数
+  QStringList cacheParams;
+  cacheParams << params.text << params.opacity << params.color << params.rotate
+              << params.font << QString::number((int)params.mode)
+              << QString::number(params.tileColumns)
+              << QString::number(params.tileRows);
+  ResultCache* cache = ResultCache::shared();
+  QString key = cache->key("watermark", m_input, cacheParams);
+  int r = 0;
+  if (cache->fetch(key, m_output)) {
+    qDebug() << "命中结果缓存：" << m_input;
+  } else {
+    // 上次的输出可能是缓存条目的硬链接，先删除再写，避免原地改写缓存
+    if (m_output != m_input) {
+      QFile::remove(m_output);
+    }
+    r = WatermarkSession::forCurrentThread(params).process(m_input, m_output);
+    if (r == 0) {
+      cache->store(key, m_output);
+    }
+  }
   
   // 使用互斥锁保护共享资源，确保多线程安全
   m_mutex->lock();
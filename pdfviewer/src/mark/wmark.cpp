@@ -32,6 +32,7 @@
 #include <string>              // 字符串操作
 
 #include "include/mark/mark.h"  // 水印处理头文件
+#include "include/mark/watermarkSession.h"  // 可复用水印会话
 #include "lib/pdflib.hpp"       // PDFlib库头文件
 
 using namespace std;
@@ -155,26 +156,11 @@ file_pagesize =String2WString(ops.getopt<std::string>('z', "size", "")); //
         int r;
         // n=3 页面添加3条水印文本
         if (mark_number == L"3") {
-          string tmpfile = GetTmpFolder() + "\\" + GetFilename(infile);
-          r = setMark(infile, outfile, mark_txt, mark_opacity, mark_font,
-                      mark_rotate, mark_color, L"0.6", L"top", L"-10");
-          if (r == 0) {
-            // DeleteFile(String2WString(infile).c_str());
-            // rename(outfile.c_str(), infile.c_str());
-            r = setMark(outfile, tmpfile, mark_txt, mark_opacity, mark_font,
-                        mark_rotate, mark_color, L"0.6", L"center", L"10");
-            if (r == 0) {
-              r = setMark(tmpfile, outfile, mark_txt, mark_opacity, mark_font,
-                          mark_rotate, mark_color, L"0.6", L"bottom", L"40");
-              if (r == 0) {
-                DeleteFile(String2WString(tmpfile).c_str());
-              } else {
-                return 2;
-              }
-            } else {
-              return 2;
-            }
-          } else {
+          // 三条水印在一次导入/写出中完成，不再经过临时文件
+          r = setAnchoredMark(infile, outfile, mark_txt, mark_opacity, mark_font,
+                              mark_rotate, mark_color,
+                              WatermarkAnchor::threeLine());
+          if (r != 0) {
             return 2;
           }
         } else {
@@ -200,74 +186,51 @@ file_pagesize =String2WString(ops.getopt<std::string>('z', "size", "")); //
  * @param vertshift 垂直偏移量
  * @return 处理结果，0表示成功，2表示失败
  * 
- * 使用PDFlib库为PDF文档的每一页添加水印，支持高级参数控制，
- * 包括位置对齐、缩放比例和偏移量等。
+ * 只有一个锚点的setAnchoredMark。需要多条水印时应直接调用
+ * setAnchoredMark一次传入全部锚点，而不是多次调用本函数。
  */
 int setMark(std::string infile, std::string outfile, wstring mark_txt,
             wstring mark_opacity, wstring mark_font, wstring mark_rotate,
             wstring mark_color, wstring scale, wstring vertalign,
             wstring vertshift) {
-  // wcout << mark_color << endl;
-  PDFlib p;  // 创建PDFlib实例
-  int indoc, endpage, pageno, page, font;  // PDF处理相关变量
-  
-  // 设置字符映射和字体搜索路径
-  const wstring searchpath = L"./PDFlib-CMap-5.0/resource/cmap";
-  wostringstream optlist;
-  optlist << L"searchpath={{" << searchpath << L"}";
-  optlist << L" {" << GetFontsFolder() << L"}}";
-  p.set_option(optlist.str());  // 应用搜索路径设置
-  // wcout << optlist.str() << endl;
-
-  p.set_info(L"Creator", L"泛生态业务工具集");
-  p.set_info(L"Title", L"本文档来自于泛生态业务投标案例");
-  indoc = p.open_pdi_document(String2WString(infile), L"");
-  // font = p.load_font(L"Helvetica", L"winansi", L"unicode");
-  // 设置字体、字符集
-  p.set_option(L"FontOutline={" + mark_font + L"=" + mark_font + L".ttf}");
-  font = p.load_font(mark_font, L"unicode", L"");
-  if (font == -1) {
-    wcerr << L"Error: " << p.get_errmsg() << endl;
-    return 2;
-  }
-  endpage = (int)p.pcos_get_number(indoc, L"length:pages");
-
-  try {
-    if (p.begin_document(String2WString(outfile), L"") == -1) {
-      wcerr << L"Error: " << p.get_errmsg() << endl;
-      return 2;
-    }
-    p.begin_template_ext(10, 10,
-                         L"watermark={location=ontop opacity=" + mark_opacity +
-                             L"  horizalign=right horizshift=-200 scale=" +
-                             scale + L" vertalign=" + vertalign +
-                             L" vertshift=" + vertshift + L"}  topdown=true");
-    p.fit_textline(mark_txt, 800, 200,
-                   L"fontsize=10 fontname=" + mark_font +
-                       L" encoding=unicode fillcolor=" + mark_color +
-                       L" boxsize={95 42} rotate=" + mark_rotate);
-    p.end_template_ext(0, 0);
-
-    for (pageno = 1; pageno <= endpage; pageno++) {
-      page = p.open_pdi_page(indoc, pageno, L"");
-
-      p.begin_page_ext(0, 0, L"width=a4.width height=a4.height");
-
-      p.fit_pdi_page(page, 0, 0, L"adjustpage");
-
-      p.close_pdi_page(page);
+  WatermarkAnchor anchor;
+  anchor.scale = QString::fromStdWString(scale);
+  anchor.vertalign = QString::fromStdWString(vertalign);
+  anchor.vertshift = QString::fromStdWString(vertshift);
+  return setAnchoredMark(infile, outfile, mark_txt, mark_opacity, mark_font,
+                         mark_rotate, mark_color, {anchor});
+}
 
-      p.end_page_ext(L"");
-    }
-    p.end_document(L"");
-    return 0;
-  } catch (PDFlib::Exception& ex) {
-    wcerr << L"PDFlib 发生异常: " << endl
-          << L"[" << ex.get_errnum() << L"] " << ex.get_apiname() << L": "
-          << ex.get_errmsg() << endl
-          << L": " << L"错误的参数选项请使用 - h参数查看帮助" << endl;
-    return 2;
-  }
+/**
+ * @brief 在一次导入/写出中为PDF添加多条定位水印
+ * @param infile 输入PDF文件路径
+ * @param outfile 输出PDF文件路径
+ * @param mark_txt 水印文本内容
+ * @param mark_opacity 水印透明度（如"15%"）
+ * @param mark_font 水印字体名称
+ * @param mark_rotate 水印旋转角度
+ * @param mark_color 水印颜色
+ * @param anchors 水印锚点列表，每个锚点一个模板
+ * @return 处理结果，0表示成功，2表示失败
+ * 
+ * 所有锚点的模板都在输出文档开始时生成，由PDFlib在每页自动放置，
+ * 输入文档只读取一次、输出只写出一次，不再经过临时文件。
+ */
+int setAnchoredMark(std::string infile, std::string outfile, wstring mark_txt,
+                    wstring mark_opacity, wstring mark_font, wstring mark_rotate,
+                    wstring mark_color,
+                    const std::vector<WatermarkAnchor>& anchors) {
+  WatermarkParams params;
+  params.text = QString::fromStdWString(mark_txt);
+  params.opacity = QString::fromStdWString(mark_opacity);
+  params.color = QString::fromStdWString(mark_color);
+  params.rotate = QString::fromStdWString(mark_rotate);
+  params.font = QString::fromStdWString(mark_font);
+  params.anchors = anchors;
+
+  WatermarkSession session(params);
+  return session.process(QString::fromStdString(infile),
+                         QString::fromStdString(outfile));
 }
 
 /**
@@ -281,84 +244,12 @@ int setMark(std::string infile, std::string outfile, wstring mark_txt,
  * @param mark_color 水印颜色
  * @return 处理结果，0表示成功，2表示失败
  * 
- * 使用PDFlib库为PDF文档的每一页添加基本水印，相比setMark函数
- * 参数较少，适用于简单的水印添加需求。
+ * 不带锚点的setAnchoredMark，水印使用模板的默认位置。
  */
 int setSingleMark(string in, string out, wstring mark_txt, wstring mark_opacity,
                   wstring mark_font, wstring mark_rotate, wstring mark_color) {
-  int indoc, endpage, pageno, page, font;  // PDF处理相关变量
-  wstring infile = String2WString(in);     // 转换输入文件路径为宽字符串
-  wstring outfile = String2WString(out);   // 转换输出文件路径为宽字符串
-  try {
-    PDFlib p;
-    const wstring searchpath = L"./PDFlib-CMap-5.0/resource/cmap";
-    wostringstream optlist;
-    optlist << L"searchpath={{" << searchpath << L"}";
-    optlist << L" {" << GetFontsFolder() << L"}}";
-    p.set_option(optlist.str());
-    // wcout << optlist.str() << endl;
-    if (p.begin_document(outfile, L"") == -1) {
-      wcerr << L"Error: " << p.get_errmsg() << endl;
-      return 2;
-    }
-    p.set_info(L"Creator", L"泛生态业务工具集");
-    p.set_info(L"Title", L"本文档来自于泛生态业务投标案例");
-
-    indoc = p.open_pdi_document(infile, L"");
-    // font = p.load_font(L"Helvetica", L"winansi", L"unicode");
-    // 设置字体、字符集
-    p.set_option(L"FontOutline={" + mark_font + L"=" + mark_font + L".ttf}");
-    font = p.load_font(mark_font, L"unicode", L"");
-
-    if (font == -1) {
-      wcerr << L"Error: " << p.get_errmsg() << endl;
-      return 2;
-    }
-    // wcout << L"infile:" << infile << endl;
-    endpage = (int)p.pcos_get_number(indoc, L"length:pages");
-    // wcout << L"mark_opacity:" << mark_opacity << endl;
-
-    p.begin_template_ext(
-        0, 0, L"watermark={location=ontop opacity=" + mark_opacity + L"}");
-
-    // p.fit_textline(L"继续与设计院、业主重点合作伙伴沟通，争取达成共赢合作模式",
-    // 0, 0,L"fontsize=10 fontname=STSong-Light encoding=unicode  fillcolor=red
-    // boxsize={595 842} rotate=15 stamp=ll2ur");
-    // p.fit_textline(L"“十四五”武都引水灌区现代化改造工程信息化(“智慧武引”二期)系统",
-    // 0, 0,L"fontsize=10 fontname=STSong-Light encoding=unicode  fillcolor=red
-    // boxsize={195 142}  rotate=-45 "); wstring mark = L"fontsize=10 fontname="
-    // + mark_font + L" encoding=unicode  fillcolor=" + mark_color + L"
-    // boxsize={95 42}  rotate=" + mark_rotate;
-    wstring mark = L"fontsize=10 fontname=" + mark_font +
-                   L" encoding=unicode  fillcolor=" + mark_color +
-                   L" boxsize={95 42}  rotate=" + mark_rotate;
-    // wcout<< mark<<endl;
-    p.fit_textline(mark_txt, 100, 100, mark);
-    p.end_template_ext(0, 0);
-
-    for (pageno = 1; pageno <= endpage; pageno++) {
-      page = p.open_pdi_page(indoc, pageno, L"");
-
-      p.begin_page_ext(0, 0, L"width=a4.width height=a4.height");
-
-      p.fit_pdi_page(page, 0, 0, L"adjustpage");
-
-      p.close_pdi_page(page);
-
-      p.end_page_ext(L"");
-    }
-    p.end_document(L"");
-
-  }
-
-  catch (PDFlib::Exception& ex) {
-    wcerr << L"PDFlib 发生异常: " << endl
-          << L"[" << ex.get_errnum() << L"] " << ex.get_apiname() << L": "
-          << ex.get_errmsg() << endl
-          << L": " << L"错误的参数选项请使用 - h参数查看帮助" << endl;
-    return 2;
-  }
-  return 0;
+  return setAnchoredMark(in, out, mark_txt, mark_opacity, mark_font,
+                         mark_rotate, mark_color, {});
 }
 
 /**
@@ -428,109 +319,75 @@ int getpages(wstring filename, string flag) {
  * @param vs 垂直偏移量（目前未使用）
  * @return 处理结果，0表示成功，2表示失败
  * 
- * 这是Qt应用程序的主要水印接口，将QString参数转换为wstring后
- * 调用PDFlib进行水印处理。支持特殊字体（如NSimSun）的处理。
+ * 这是Qt应用程序的主要水印接口，内部创建一个临时的WatermarkSession
+ * 完成处理。支持特殊字体（如NSimSun）的处理。批量处理多个文件时
+ * 应直接复用WatermarkSession，避免每个文件重复加载字体。
  */
 int addWatermark(const QString& i, const QString& o, const QString& t,
                  const QString& p, const QString& c, const QString& r,
                  const QString& f, const QString& s, const QString& va,
                  const QString& vs) {
-  // 将Qt字符串参数转换为宽字符串
-  wstring infile = QString2WString(i);        // 输入文件路径
-  wstring outfile = QString2WString(o);       // 输出文件路径
-  wstring mark_txt = QString2WString(t);      // 水印文本
-
-  wstring mark_opacity = QString2WString(p);  // 透明度
-  wstring mark_color = QString2WString(c);    // 颜色
-  wstring mark_rotate = QString2WString(r);   // 旋转角度
-  wstring mark_font = QString2WString(f);     // 字体
-  wstring mark_scale = QString2WString(s);    // 缩放比例（暂未使用）
-  wstring mark_vertalign = QString2WString(va);  // 垂直对齐（暂未使用）
-  wstring mark_vertshift = QString2WString(vs);  // 垂直偏移（暂未使用）
-
-  // wstring mark1 = L"fontsize=10 fontname=" + mark_font + L"
-  // encoding=unicode fillcolor=" + mark_color + L" boxsize={95 42} rotate="
-  // + mark_rotate; wcout
-  // << mark_txt << endl; qDebug() << "mark_txt:" << mark_txt;//流输出方式
-  // qDebug() << getpages(infile, "pages");
-
-  int indoc, endpage, pageno, page, font;
-
-  try {
-    PDFlib p;
-    const wstring searchpath = L"./PDFlib-CMap-5.0/resource/cmap";
-    wostringstream optlist;
-    wstring mark;
-    optlist << L"searchpath={{" << searchpath << L"}";
-    optlist << L" {" << GetFontsFolder() << L"}}";
-    p.set_option(optlist.str());
-    if (p.begin_document(outfile, L"") == -1) {
-      wcerr << L"Error: " << p.get_errmsg() << endl;
-      return 2;
-    }
-    p.set_info(L"Creator", L"泛生态业务工具集");
-    p.set_info(L"Title", L"本文档来自于泛生态业务投标案例");
-    indoc = p.open_pdi_document(infile, L"");
-    // font = p.load_font(L"Helvetica", L"winansi", L"unicode");
-    // 设置字体、字符集
-    // p.set_option(L"FontOutline={" + mark_font + L"=" + mark_font + L".ttf}");
-    // wcout << L"font:" << mark_font << endl;
-    // font = p.load_font(mark_font, L"unicode", L"");
-    if (mark_font == L"NSimSun") {
-      p.set_option(L"FontOutline={NSimSun=simsun.ttc}");
-      font = p.load_font(L"NSimSun", L"unicode", L"embedding");
-    } else {
-      p.set_option(L"FontOutline={" + mark_font + L"=" + mark_font + L".ttf}");
-      font = p.load_font(mark_font, L"unicode", L"");
-    }
-
-    if (font == -1) {
-      wcerr << L"Error: " << p.get_errmsg() << endl;
-      return 2;
-    }
-    // wcout << L"infile:" << infile << endl;
-    endpage = (int)p.pcos_get_number(indoc, L"length:pages");
-    // wcout << L"mark_opacity:" << mark_opacity << endl;
-
-    p.begin_template_ext(
-        0, 0, L"watermark={location=ontop opacity=" + mark_opacity + L"}");
-    /*
-    p.begin_template_ext(0, 0,
-                         L"watermark={location=ontop opacity=" + mark_opacity +
-                             L"  horizalign=right horizshift=-200 scale=" +
-                             mark_scale + L" vertalign=" + mark_vertalign +
-                             L" vertshift=" + mark_vertshift +
-                             L"}  topdown=true");
-*/
-    mark = L"fontsize=10 fontname=" + mark_font +
-           L" encoding=unicode  fillcolor=" + mark_color +
-           L" boxsize={95 42}  rotate=" + mark_rotate;
-    // wcout<< mark<<endl;
-    p.fit_textline(mark_txt, 100, 100, mark);
-    p.end_template_ext(0, 0);
-
-    for (pageno = 1; pageno <= endpage; pageno++) {
-      page = p.open_pdi_page(indoc, pageno, L"");
-
-      p.begin_page_ext(0, 0, L"width=a4.width height=a4.height");
-
-      p.fit_pdi_page(page, 0, 0, L"adjustpage");
-
-      p.close_pdi_page(page);
+  // 缩放、对齐、偏移参数目前未使用，其余参数交给水印会话处理
+  WatermarkParams params;
+  params.text = t;
+  params.opacity = p;
+  params.color = c;
+  params.rotate = r;
+  params.font = f;
+
+  // 单次调用使用临时会话；批量处理请复用WatermarkSession::forCurrentThread
+  WatermarkSession session(params);
+  return session.process(i, o);
+}
 
-      p.end_page_ext(L"");
-    }
-    p.end_document(L"");
-  }
+/**
+ * @brief 为内存中的PDF添加水印
+ * @param pdfData 输入PDF文件内容
+ * @param t 水印文本内容
+ * @param p 水印透明度百分比
+ * @param c 水印颜色
+ * @param r 水印旋转角度
+ * @param f 水印字体名称
+ * @return 加水印后的PDF文件内容，失败返回空数组
+ */
+QByteArray addWatermarkBuffer(const QByteArray& pdfData, const QString& t,
+                              const QString& p, const QString& c,
+                              const QString& r, const QString& f) {
+  WatermarkParams params;
+  params.text = t;
+  params.opacity = p;
+  params.color = c;
+  params.rotate = r;
+  params.font = f;
+
+  WatermarkSession session(params);
+  return session.processBuffer(pdfData);
+}
 
-  catch (PDFlib::Exception& ex) {
-    wcerr << L"PDFlib 发生异常: " << endl
-          << L"[" << ex.get_errnum() << L"] " << ex.get_apiname() << L": "
-          << ex.get_errmsg() << endl
-          << L": " << L"错误的参数选项请使用 - h参数查看帮助" << endl;
-    return 2;
-  }
-  return 0;
+/**
+ * @brief 以追加（增量更新）方式添加水印
+ * @param i 输入PDF文件路径
+ * @param o 输出PDF文件路径
+ * @param t 水印文本内容
+ * @param p 水印透明度百分比
+ * @param c 水印颜色
+ * @param r 水印旋转角度
+ * @param f 水印字体名称
+ * @return 处理结果，0表示成功，2表示失败
+ */
+int appendWatermark(const QString& i, const QString& o, const QString& t,
+                    const QString& p, const QString& c, const QString& r,
+                    const QString& f) {
+  WatermarkParams params;
+  params.text = t;
+  params.opacity = p;
+  params.color = c;
+  params.rotate = r;
+  params.font = f;
+  params.mode = WatermarkMode::Append;
+
+  WatermarkSession session(params);
+  return session.process(i, o);
 }
 
 /*
@@ -0,0 +1,80 @@
+/**
+ * @file image2pdfThread.cpp
+ * @brief 批量图片转PDF线程类实现文件
+ *
+ * 进度回调在ImageBatch的工作线程中调用，这里只发射信号，
+ * 由Qt排队送到界面线程。
+ */
+
+#pragma execution_character_set("utf-8")  // 防止中文乱码
+#include "include/pdf2image/image2pdfThread.h"
+
+#include <QDebug>
+
+#include "include/function/ImageBatch.h"
+
+/**
+ * @brief 构造函数
+ * @param parent 父对象指针
+ */
+image2pdfThread::image2pdfThread(QObject* parent)
+    : QObject(parent), QRunnable() {
+  setAutoDelete(true);  // 设置任务完成后自动删除对象
+}
+
+/**
+ * @brief 设置待转换的图片列表
+ */
+void image2pdfThread::setImages(const QStringList& images) {
+  m_images = images;
+}
+
+/**
+ * @brief 设置合并输出的PDF文件，为空时每个图片单独输出
+ */
+void image2pdfThread::setTargetFile(const QString& targetFile) {
+  m_targetFile = targetFile;
+}
+
+/**
+ * @brief 设置工作线程数，0表示使用CPU核心数
+ */
+void image2pdfThread::setWorkers(int workers) { m_workers = workers; }
+
+/**
+ * @brief 设置分辨率上限，0表示按原始像素嵌入
+ */
+void image2pdfThread::setMaxDpi(int maxDpi) { m_maxDpi = maxDpi; }
+
+/**
+ * @brief 线程主执行函数
+ *
+ * 执行流程：
+ * 1. 未指定目标文件时，每个图片单独转换为"图片路径.pdf"
+ * 2. 指定目标文件时，所有图片按顺序合并为一个多页PDF
+ * 3. 发送完成信号，无论成功与否都会发出
+ */
+void image2pdfThread::run() {
+  const int total = m_images.size();
+  auto report = [this](int done, int total) {
+    // 只在百分比变化时发信号，两万个图片也只有约一百次界面刷新
+    if (done == total || done * 100 / total != (done - 1) * 100 / total) {
+      emit progress(done, total);
+    }
+  };
+
+  int succeeded = 0;
+  ImageBatch::Stats stats;
+  if (m_targetFile.isEmpty()) {
+    succeeded =
+        ImageBatch::convertEach(m_images, m_workers, report, &stats, m_maxDpi);
+  } else if (ImageBatch::combine(m_images, m_targetFile, m_workers, report,
+                                 &stats, m_maxDpi) == 0) {
+    succeeded = total;
+  } else {
+    // 跳过的图片不在输出中，其余图片已按顺序写入
+    succeeded = total - stats.skipped;
+    qDebug() << "合并图片未全部完成：" << m_targetFile << "跳过" << stats.skipped;
+  }
+  emit addFinish(succeeded, total, stats.summary());
+}
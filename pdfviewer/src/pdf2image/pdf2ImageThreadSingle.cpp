@@ -26,9 +26,13 @@
 
 #include <QDebug>
 #include <QElapsedTimer>
+#include <QFile>
 #include <QThread>
 
 #include "function.h"
+#include "include/function/FlattenPipeline.h"
+#include "include/function/PageRasterizer.h"
+#include "include/function/ResultCache.h"
 
 /**
  * @brief PDF转图片线程构造函数
@@ -101,12 +105,46 @@ void pdf2imageThreadSingle::setResolution(int resolution) {
  * @note PDF→图片→PDF模式常用于PDF压缩或格式标准化
  */
 void pdf2imageThreadSingle::setIs2pdf(bool is2pdf) { m_is2pdf = is2pdf; }
+
+/**
+ * @brief 设置单个文档的渲染线程数
+ * @param workers 渲染线程数，0表示使用CPU核心数
+ * @note 多个文件同时处理时应按文件数分摊，避免线程数超过CPU核心数
+ */
+void pdf2imageThreadSingle::setWorkers(int workers) { m_workers = workers; }
+
+/**
+ * @brief 设置扁平化使用的内存预算
+ * @param budget 内存预算，默认为进程共享预算，nullptr表示不限制
+ */
+void pdf2imageThreadSingle::setMemoryBudget(MemoryBudget* budget) {
+  m_budget = budget;
+}
+
+/**
+ * @brief 设置扁平化的条带高度
+ * @param bandHeight 条带高度（像素），0表示整页，小于0表示自动
+ * @note 600 DPI等高分辨率下分条带渲染，每个渲染线程只分配条带大小的像素数据
+ */
+void pdf2imageThreadSingle::setBandHeight(int bandHeight) {
+  m_bandHeight = bandHeight;
+}
+
+/**
+ * @brief 设置扁平化输出的图片编码
+ * @param encoding 编码选项，默认按页自动选择黑白/灰度/JPEG
+ */
+void pdf2imageThreadSingle::setEncoding(const FlattenPipeline::Encoding& encoding) {
+  m_encoding = encoding;
+}
 /**
  * @brief 线程主执行函数
  * 
  * 执行实际的PDF转换任务流程：
- * 1. 调用pdf2image()函数将PDF转换为图片文件
- * 2. 如果是PDF→图片→PDF模式，则调用images2pdf()将图片合并回PDF
+ * 1. PDF→图片模式：调用pdf2image()函数将PDF转换为图片文件
+ * 2. PDF→图片→PDF模式：由FlattenPipeline渲染、压缩、写入，
+ *    内存受m_budget限制，不经过PNG编码和图片目录，最后只写出目标PDF；
+ *    输入内容和参数与以前某次处理相同时直接从ResultCache取出结果
  * 3. 发送完成信号通知上层组件
  * 4. 处理所有可能的异常情况并确保信号发出
  * 
@@ -114,13 +152,37 @@ void pdf2imageThreadSingle::setIs2pdf(bool is2pdf) { m_is2pdf = is2pdf; }
  */
 void pdf2imageThreadSingle::run() {
   try {
-    // 执行PDF转图片操作，获取转换页数
-    int num = pdf2image(m_sourceFile.toStdString(), m_imagePath.toStdString(),
-                        m_resolution);
-    
-    // 如果转换成功且需要再次转为PDF，则执行图片合并操作
-    if (num > 0 && m_is2pdf) {
-      images2pdf(m_imagePath.toStdString(), m_targetFile.toStdString(), num);
+    if (m_is2pdf) {
+      // 条带高度决定输出中每页的图片对象划分，同样计入缓存键
+      ResultCache* cache = ResultCache::shared();
+      QString key = cache->key(
+          "flatten", m_sourceFile,
+          QStringList() << QString::number(m_resolution)
+                        << QString::number((int)m_encoding.codec)
+                        << QString::number(m_encoding.jpegQuality)
+                        << QString::number(m_encoding.maxDpi)
+                        << QString::number(m_bandHeight));
+      if (cache->fetch(key, m_targetFile)) {
+        qDebug() << "命中结果缓存：" << m_sourceFile;
+      } else {
+        // PDF→图片→PDF：渲染、压缩、写入三个阶段流水线处理，不经过PNG编解码
+        FlattenPipeline::Stats stats;
+        QByteArray pdf = FlattenPipeline::runFile(m_sourceFile, m_resolution,
+                                                  m_encoding, m_workers,
+                                                  m_bandHeight, m_budget, &stats);
+        // 上次的输出可能是缓存条目的硬链接，先删除再写，避免原地改写缓存
+        QFile::remove(m_targetFile);
+        if (pdf.isEmpty() || !FileSystemUtils::writeFileBytes(m_targetFile, pdf)) {
+          qDebug() << "PDF转换失败：" << m_sourceFile;
+        } else {
+          cache->store(key, m_targetFile);
+        }
+        qDebug() << "扁平化" << m_sourceFile << stats.summary();
+      }
+    } else {
+      // 执行PDF转图片操作
+      pdf2image(m_sourceFile.toStdString(), m_imagePath.toStdString(),
+                m_resolution);
     }
     
     // 发送任务完成信号
@@ -147,93 +209,28 @@ void pdf2imageThreadSingle::run() {
  * @return 成功转换的页数，失败返回-1
  * 
  * 详细处理流程：
- * 1. 初始化MuPDF上下文和文档对象
- * 2. 注册文档处理器并打开PDF文件
- * 3. 获取PDF页数并验证有效性
- * 4. 计算缩放矩阵（基于分辨率）
- * 5. 逐页转换：渲染→生成Pixmap→保存PNG
- * 6. 清理所有资源并返回结果
+ * 1. 从DisplayListCache取得各页显示列表，已解析过的文件不再重复解析
+ * 2. 由PageRasterizer在m_workers个线程上并行渲染各页
+ * 3. 渲染结果按页码顺序交回本线程，保存为PNG
  * 
- * @note 使用MuPDF库实现，支持完整的异常处理和资源清理
+ * @note 单页保存失败时记录错误并继续处理下一页
  */
 int pdf2imageThreadSingle::pdf2image(string pdfFile, string imagePath, int resolution) {
-  // 初始化MuPDF资源指针
-  fz_context* ctx = nullptr;   // MuPDF上下文对象
-  fz_document* doc = nullptr;  // PDF文档对象
-  
-  try {
-    // 创建MuPDF上下文（内存管理器、异常处理器、默认缓存大小）
-    ctx = fz_new_context(NULL, NULL, FZ_STORE_DEFAULT);
-    if (!ctx) {
-      qDebug() << "创建MuPDF上下文失败";
-      return -1;
-    }
-    
-    // 注册文档处理器（PDF、XPS等格式支持）
-    fz_register_document_handlers(ctx);
-    
-    // 打开PDF文档文件
-    doc = fz_open_document(ctx, pdfFile.c_str());
-    if (!doc) {
-      qDebug() << "文件处理错误：" << QString::fromStdString(pdfFile);
-      fz_drop_context(ctx);  // 清理上下文资源
-      return -1;
-    }
-    
-    // 获取PDF文档的总页数
-    int num = fz_count_pages(ctx, doc);
-    if (num <= 0) {
-      qDebug() << "PDF页数无效：" << num;
-      fz_drop_document(ctx, doc);  // 清理文档资源
-      fz_drop_context(ctx);        // 清理上下文资源
-      return -1;
-    }
-    
-    // 计算缩放因子：目标分辨率 / 默认DPI(72)
-    // 例如：300 DPI / 72 DPI = 4.17倍缩放
-    float zoom = static_cast<float>(resolution) / 72.0f;
-    
-    // 创建缩放变换矩阵（同时对X和Y方向应用相同缩放）
-    fz_matrix ctm = fz_scale(zoom, zoom);
-
-    // 遍历PDF的每一页并转换为图片
-    for (int i = 0; i < num; i++) {
-      // 生成输出图片文件名：0.png, 1.png, 2.png...
-      string fileName = imagePath + "/" + to_string(i) + ".png";
-      fz_pixmap* pix = nullptr;  // 像素数据对象
-      
-      try {
-        // 从指定页面创建像素数据（渲染过程）
-        // 参数：上下文、文档、页码、变换矩阵、颜色空间、透明度
-        pix = fz_new_pixmap_from_page_number(ctx, doc, i, ctm, fz_device_rgb(ctx), 0);
-        
-        if (pix) {
-          // 将像素数据保存为PNG格式文件
-          fz_save_pixmap_as_png(ctx, pix, fileName.c_str());
-          // 释放当前页的像素数据内存
-          fz_drop_pixmap(ctx, pix);
-        }
-        
-      } catch (...) {
-        // 单页处理失败，清理资源并继续处理下一页
-        if (pix) fz_drop_pixmap(ctx, pix);
-        qDebug() << "处理第" << i << "页时发生错误";
-        continue; // 跳过当前页，继续处理下一页
-      }
+  // 生成输出图片文件名：0.png, 1.png, 2.png...
+  auto savePage = [&imagePath](fz_context* ctx, int page, fz_pixmap* pix,
+                               const fz_rect&) -> bool {
+    string fileName = imagePath + "/" + to_string(page) + ".png";
+    fz_try(ctx) { fz_save_pixmap_as_png(ctx, pix, fileName.c_str()); }
+    fz_catch(ctx) {
+      qDebug() << "处理第" << page << "页时发生错误：" << fz_caught_message(ctx);
     }
+    return true;
+  };
 
-    // 所有页面处理完成，清理MuPDF资源
-    fz_drop_document(ctx, doc);  // 释放文档对象
-    fz_drop_context(ctx);        // 释放上下文对象
-    
-    // 返回成功转换的页数
-    return num;
-    
-  } catch (...) {
-    // 发生严重异常，确保资源清理
-    if (doc) fz_drop_document(ctx, doc);  // 安全释放文档对象
-    if (ctx) fz_drop_context(ctx);        // 安全释放上下文对象
-    qDebug() << "pdf2image发生严重异常";
-    return -1;  // 返回失败标志
+  int num = PageRasterizer::rasterizeFile(QString::fromStdString(pdfFile), resolution,
+                                         savePage, m_workers);
+  if (num < 0) {
+    qDebug() << "pdf2image处理失败：" << QString::fromStdString(pdfFile);
   }
+  return num;
 }
@@ -12,6 +12,7 @@
 #include <QtCore/QVariant>
 #include <QtWidgets/QAction>
 #include <QtWidgets/QApplication>
+#include <QtWidgets/QCheckBox>
 #include <QtWidgets/QComboBox>
 #include <QtWidgets/QGridLayout>
 #include <QtWidgets/QHeaderView>
@@ -73,11 +74,16 @@ public:
     CustomSlider *sliderOpacity;
     CustomSlider *sliderRotate;
     QPushButton *btnExportPDF;
+    QComboBox *cBoxCodec;
     QComboBox *cBoxResolution;
     CustomLineEdit *lineEdit_fs;
     CustomTextEdit *lineEditWaterText;
     QLabel *label_2;
     CustomSlider *sliderFontsize;
+    QCheckBox *checkBoxAppend;
+    QPushButton *btnPersonalize;
+    QComboBox *cBoxTile;
+    QComboBox *cBoxExportDpi;
     QWidget *tab_transform;
     CustomLineEdit *lineEditImageFile;
     QLabel *label_i2p;
@@ -89,6 +95,8 @@ public:
     QPushButton *btnSelectImageDir;
     QLabel *label_i2p_4;
     CustomLineEdit *lineEditImageDir;
+    QComboBox *cBoxMaxDpi;
+    QCheckBox *checkBoxCombine;
     QLabel *label_i2p_5;
     CustomLineEdit *lineEditPdfFile;
     QPushButton *btnPdfToImage;
@@ -324,6 +332,18 @@ public:
         btnExportPDF->setObjectName(QString::fromUtf8("btnExportPDF"));
         btnExportPDF->setGeometry(QRect(250, 360, 101, 31));
         btnExportPDF->setStyleSheet(QString::fromUtf8(""));
+        cBoxCodec = new QComboBox(tab);
+        cBoxCodec->addItem(QString());
+        cBoxCodec->addItem(QString());
+        cBoxCodec->addItem(QString());
+        cBoxCodec->addItem(QString());
+        cBoxCodec->addItem(QString());
+        cBoxCodec->addItem(QString());
+        cBoxCodec->addItem(QString());
+        cBoxCodec->setObjectName(QString::fromUtf8("cBoxCodec"));
+        cBoxCodec->setGeometry(QRect(355, 363, 71, 25));
+        cBoxCodec->setStyleSheet(QString::fromUtf8("border: 1px solid #b8d4f0;"));
+        cBoxCodec->setEditable(false);
         cBoxResolution = new QComboBox(tab);
         cBoxResolution->addItem(QString());
         cBoxResolution->addItem(QString());
@@ -358,6 +378,31 @@ public:
         sliderFontsize->setValue(25);
         sliderFontsize->setSliderPosition(25);
         sliderFontsize->setOrientation(Qt::Horizontal);
+        checkBoxAppend = new QCheckBox(tab);
+        checkBoxAppend->setObjectName(QString::fromUtf8("checkBoxAppend"));
+        checkBoxAppend->setGeometry(QRect(90, 400, 141, 21));
+        btnPersonalize = new QPushButton(tab);
+        btnPersonalize->setObjectName(QString::fromUtf8("btnPersonalize"));
+        btnPersonalize->setGeometry(QRect(90, 440, 101, 31));
+        cBoxTile = new QComboBox(tab);
+        cBoxTile->addItem(QString());
+        cBoxTile->addItem(QString());
+        cBoxTile->addItem(QString());
+        cBoxTile->addItem(QString());
+        cBoxTile->addItem(QString());
+        cBoxTile->setObjectName(QString::fromUtf8("cBoxTile"));
+        cBoxTile->setGeometry(QRect(250, 398, 101, 25));
+        cBoxTile->setStyleSheet(QString::fromUtf8("border: 1px solid #b8d4f0;"));
+        cBoxTile->setEditable(false);
+        cBoxExportDpi = new QComboBox(tab);
+        cBoxExportDpi->addItem(QString());
+        cBoxExportDpi->addItem(QString());
+        cBoxExportDpi->addItem(QString());
+        cBoxExportDpi->addItem(QString());
+        cBoxExportDpi->setObjectName(QString::fromUtf8("cBoxExportDpi"));
+        cBoxExportDpi->setGeometry(QRect(355, 398, 71, 25));
+        cBoxExportDpi->setStyleSheet(QString::fromUtf8("border: 1px solid #b8d4f0;"));
+        cBoxExportDpi->setEditable(false);
         tabWidget->addTab(tab, QString());
         labOutput->raise();
         labWater->raise();
@@ -378,12 +423,17 @@ public:
         sliderRotate->raise();
         btnExportPDF->raise();
         cBoxResolution->raise();
+        cBoxCodec->raise();
         lineEditColor->raise();
         cBoxFont->raise();
         lineEdit_fs->raise();
         lineEditWaterText->raise();
         sliderFontsize->raise();
         label_2->raise();
+        checkBoxAppend->raise();
+        btnPersonalize->raise();
+        cBoxTile->raise();
+        cBoxExportDpi->raise();
         tab_transform = new QWidget();
         tab_transform->setObjectName(QString::fromUtf8("tab_transform"));
         lineEditImageFile = new CustomLineEdit(tab_transform);
@@ -406,7 +456,7 @@ public:
         label_i2p_2->setStyleSheet(QString::fromUtf8("font: 700 9pt \"Microsoft YaHei UI\";"));
         label_i2p_3 = new QLabel(tab_transform);
         label_i2p_3->setObjectName(QString::fromUtf8("label_i2p_3"));
-        label_i2p_3->setGeometry(QRect(10, 80, 271, 21));
+        label_i2p_3->setGeometry(QRect(10, 80, 141, 21));
         label_i2p_3->setStyleSheet(QString::fromUtf8("font: 700 9pt \"Microsoft YaHei UI\";"));
         btnTransformBat = new QPushButton(tab_transform);
         btnTransformBat->setObjectName(QString::fromUtf8("btnTransformBat"));
@@ -422,6 +472,18 @@ public:
         lineEditImageDir->setGeometry(QRect(80, 110, 210, 31));
         lineEditImageDir->setStyleSheet(QString::fromUtf8("color: rgb(52, 52, 52);"));
         lineEditImageDir->setReadOnly(true);
+        cBoxMaxDpi = new QComboBox(tab_transform);
+        cBoxMaxDpi->addItem(QString());
+        cBoxMaxDpi->addItem(QString());
+        cBoxMaxDpi->addItem(QString());
+        cBoxMaxDpi->addItem(QString());
+        cBoxMaxDpi->setObjectName(QString::fromUtf8("cBoxMaxDpi"));
+        cBoxMaxDpi->setGeometry(QRect(160, 78, 121, 25));
+        cBoxMaxDpi->setStyleSheet(QString::fromUtf8("border: 1px solid #b8d4f0;"));
+        cBoxMaxDpi->setEditable(false);
+        checkBoxCombine = new QCheckBox(tab_transform);
+        checkBoxCombine->setObjectName(QString::fromUtf8("checkBoxCombine"));
+        checkBoxCombine->setGeometry(QRect(291, 80, 121, 21));
         label_i2p_5 = new QLabel(tab_transform);
         label_i2p_5->setObjectName(QString::fromUtf8("label_i2p_5"));
         label_i2p_5->setGeometry(QRect(10, 152, 101, 21));
@@ -451,6 +513,8 @@ public:
         btnSelectImageDir->raise();
         label_i2p_4->raise();
         lineEditImageDir->raise();
+        cBoxMaxDpi->raise();
+        checkBoxCombine->raise();
         label_i2p_5->raise();
         btnPdfToImage->raise();
         btnSelectPDFFile->raise();
@@ -818,6 +882,17 @@ public:
         btnExportPDF->setToolTip(QCoreApplication::translate("MainWindow", "<html><head/><body><p><span style=\" font-size:10pt; color:#0055ff;\">\345\260\206\345\242\236\345\212\240\350\277\207\346\260\264\345\215\260\347\232\204PDF\345\257\274\345\207\272\344\270\272\345\233\276\347\211\207PDF</span></p></body></html>", nullptr));
 #endif // QT_CONFIG(tooltip)
         btnExportPDF->setText(QCoreApplication::translate("MainWindow", "\345\257\274\345\207\272PDF", nullptr));
+        cBoxCodec->setItemText(0, QCoreApplication::translate("MainWindow", "\350\207\252\345\212\250", nullptr));
+        cBoxCodec->setItemText(1, QCoreApplication::translate("MainWindow", "\351\273\221\347\231\275", nullptr));
+        cBoxCodec->setItemText(2, QCoreApplication::translate("MainWindow", "\347\201\260\345\272\246", nullptr));
+        cBoxCodec->setItemText(3, QCoreApplication::translate("MainWindow", "JPEG 90", nullptr));
+        cBoxCodec->setItemText(4, QCoreApplication::translate("MainWindow", "JPEG 75", nullptr));
+        cBoxCodec->setItemText(5, QCoreApplication::translate("MainWindow", "JPEG 50", nullptr));
+        cBoxCodec->setItemText(6, QCoreApplication::translate("MainWindow", "\346\227\240\346\215\237", nullptr));
+
+#if QT_CONFIG(tooltip)
+        cBoxCodec->setToolTip(QCoreApplication::translate("MainWindow", "<html><head/><body><p><span style=\" color:#0055ff;\">\345\257\274\345\207\272PDF\347\232\204\345\233\276\347\211\207\347\274\226\347\240\201\343\200\202\350\207\252\345\212\250\357\274\232\351\273\221\347\231\275\351\241\265\351\235\242\346\214\2111\344\275\215\345\216\213\347\274\251\357\274\214\347\201\260\345\272\246\351\241\265\351\235\242\346\214\211\347\201\260\345\272\246\345\216\213\347\274\251\357\274\214\345\275\251\350\211\262\351\241\265\351\235\242\346\214\211JPEG\345\216\213\347\274\251\343\200\202</span></p></body></html>", nullptr));
+#endif // QT_CONFIG(tooltip)
         cBoxResolution->setItemText(0, QCoreApplication::translate("MainWindow", "100", nullptr));
         cBoxResolution->setItemText(1, QCoreApplication::translate("MainWindow", "300", nullptr));
         cBoxResolution->setItemText(2, QCoreApplication::translate("MainWindow", "150", nullptr));
@@ -838,6 +913,31 @@ public:
 "</style></head><body style=\" font-family:'SimSun'; font-size:9pt; font-weight:400; font-style:normal;\">\n"
 "<p style=\" margin-top:0px; margin-bottom:0px; margin-left:0px; margin-right:0px; -qt-block-indent:0; text-indent:0px;\"><span style=\" font-family:'Microsoft YaHei UI';\">\350\201\224\351\200\232\346\225\260\345\255\227\347\247\221\346\212\200\346\234\211\351\231\220\345\205\254\345\217\270\346\200\273\351\203\250xx\351\241\271\347\233\256\344\270\223\347\224\250\346\226\207\346\241\243</span></p></body></html>", nullptr));
         label_2->setText(QCoreApplication::translate("MainWindow", "\345\255\227\344\275\223\345\255\227\345\217\267:", nullptr));
+#if QT_CONFIG(tooltip)
+        checkBoxAppend->setToolTip(QCoreApplication::translate("MainWindow", "<html><head/><body><p><span style=\" color:#0055ff;\">\345\215\225\350\241\214\346\260\264\345\215\260\344\273\245\345\242\236\351\207\217\346\233\264\346\226\260\346\226\271\345\274\217\350\277\275\345\212\240\357\274\232\345\216\237\346\226\207\344\273\266\345\206\205\345\256\271\345\216\237\346\240\267\344\277\235\347\225\231\357\274\214\345\217\252\345\242\236\345\212\240\344\270\200\344\270\252\345\205\261\344\272\253\347\232\204\346\260\264\345\215\260\345\257\271\350\261\241\357\274\214\351\200\202\345\220\210\344\275\223\347\247\257\345\276\210\345\244\247\347\232\204\346\211\253\346\217\217\344\273\266\343\200\202</span></p></body></html>", nullptr));
+#endif // QT_CONFIG(tooltip)
+        checkBoxAppend->setText(QCoreApplication::translate("MainWindow", "\350\277\275\345\212\240\346\250\241\345\274\217\357\274\210\345\242\236\351\207\217\344\277\235\345\255\230\357\274\211", nullptr));
+#if QT_CONFIG(tooltip)
+        btnPersonalize->setToolTip(QCoreApplication::translate("MainWindow", "<html><head/><body><p><span style=\" font-size:10pt; color:#0055ff;\">\344\270\272\344\270\200\344\270\252PDF\346\214\211\346\224\266\344\273\266\344\272\272\345\220\215\345\215\225\357\274\210CSV\357\274\232\346\260\264\345\215\260\346\226\207\346\234\254[,\350\276\223\345\207\272\346\226\207\344\273\266\345\220\215]\357\274\211\345\220\204\347\224\237\346\210\220\344\270\200\344\273\275\345\270\246\344\270\215\345\220\214\346\260\264\345\215\260\346\226\207\346\234\254\347\232\204\346\226\207\344\273\266\357\274\214\350\276\223\345\205\245\345\217\252\350\247\243\346\236\220\344\270\200\346\254\241\343\200\202</span></p></body></html>", nullptr));
+#endif // QT_CONFIG(tooltip)
+        btnPersonalize->setText(QCoreApplication::translate("MainWindow", "\346\214\211\345\220\215\345\215\225\347\224\237\346\210\220", nullptr));
+        cBoxTile->setItemText(0, QCoreApplication::translate("MainWindow", "\345\215\225\344\270\252\346\260\264\345\215\260", nullptr));
+        cBoxTile->setItemText(1, QCoreApplication::translate("MainWindow", "\345\271\263\351\223\272 2\303\2272", nullptr));
+        cBoxTile->setItemText(2, QCoreApplication::translate("MainWindow", "\345\271\263\351\223\272 3\303\2273", nullptr));
+        cBoxTile->setItemText(3, QCoreApplication::translate("MainWindow", "\345\271\263\351\223\272 4\303\2274", nullptr));
+        cBoxTile->setItemText(4, QCoreApplication::translate("MainWindow", "\345\271\263\351\223\272 3\303\2275", nullptr));
+
+#if QT_CONFIG(tooltip)
+        cBoxTile->setToolTip(QCoreApplication::translate("MainWindow", "<html><head/><body><p><span style=\" color:#0055ff;\">\345\215\225\350\241\214\346\260\264\345\215\260\345\271\263\351\223\272\344\270\272\345\210\227\303\227\350\241\214\347\232\204\347\275\221\346\240\274\357\274\214\346\226\207\346\234\254\345\217\252\347\273\230\345\210\266\344\270\200\346\254\241\357\274\214\345\220\204\347\275\221\346\240\274\344\275\215\347\275\256\345\205\261\347\224\250\345\220\214\344\270\200\344\270\252\346\260\264\345\215\260\345\257\271\350\261\241\343\200\202</span></p></body></html>", nullptr));
+#endif // QT_CONFIG(tooltip)
+        cBoxExportDpi->setItemText(0, QCoreApplication::translate("MainWindow", "\345\216\237\345\247\213", nullptr));
+        cBoxExportDpi->setItemText(1, QCoreApplication::translate("MainWindow", "300 DPI", nullptr));
+        cBoxExportDpi->setItemText(2, QCoreApplication::translate("MainWindow", "200 DPI", nullptr));
+        cBoxExportDpi->setItemText(3, QCoreApplication::translate("MainWindow", "150 DPI", nullptr));
+
+#if QT_CONFIG(tooltip)
+        cBoxExportDpi->setToolTip(QCoreApplication::translate("MainWindow", "<html><head/><body><p><span style=\" color:#0055ff;\">\345\257\274\345\207\272PDF\346\227\266\347\201\260\345\272\246\345\222\214\345\275\251\350\211\262\351\241\265\351\235\242\345\233\276\347\211\207\347\232\204\345\210\206\350\276\250\347\216\207\344\270\212\351\231\220\343\200\202\346\270\262\346\237\223\345\210\206\350\276\250\347\216\207\346\233\264\351\253\230\346\227\266\346\214\211\351\235\242\347\247\257\345\271\263\345\235\207\347\274\251\345\260\217\345\220\216\345\206\215\347\274\226\347\240\201\357\274\214\351\273\221\347\231\275\351\241\265\351\235\242\344\277\235\346\214\201\346\270\262\346\237\223\345\210\206\350\276\250\347\216\207\343\200\202</span></p></body></html>", nullptr));
+#endif // QT_CONFIG(tooltip)
         tabWidget->setTabText(tabWidget->indexOf(tab), QCoreApplication::translate("MainWindow", "\346\260\264\345\215\260\346\223\215\344\275\234", nullptr));
         lineEditImageFile->setPlaceholderText(QCoreApplication::translate("MainWindow", "\345\217\257\344\273\245\346\213\226\345\212\250\346\226\207\344\273\266\345\210\260\350\257\245\346\226\207\346\234\254\346\241\206\344\270\255", nullptr));
         label_i2p->setText(QCoreApplication::translate("MainWindow", "\345\233\276\347\211\207\346\226\207\344\273\266:", nullptr));
@@ -849,6 +949,15 @@ public:
         btnSelectImageDir->setText(QCoreApplication::translate("MainWindow", "\351\200\211\346\213\251", nullptr));
         label_i2p_4->setText(QCoreApplication::translate("MainWindow", "\345\233\276\347\211\207\347\233\256\345\275\225:", nullptr));
         lineEditImageDir->setPlaceholderText(QCoreApplication::translate("MainWindow", "\345\217\257\344\273\245\346\213\226\345\212\250\347\233\256\345\275\225\345\210\260\350\257\245\346\226\207\346\234\254\346\241\206\344\270\255", nullptr));
+        cBoxMaxDpi->setItemText(0, QCoreApplication::translate("MainWindow", "\345\216\237\345\247\213\345\210\206\350\276\250\347\216\207", nullptr));
+        cBoxMaxDpi->setItemText(1, QCoreApplication::translate("MainWindow", "300 DPI", nullptr));
+        cBoxMaxDpi->setItemText(2, QCoreApplication::translate("MainWindow", "200 DPI", nullptr));
+        cBoxMaxDpi->setItemText(3, QCoreApplication::translate("MainWindow", "150 DPI", nullptr));
+
+#if QT_CONFIG(tooltip)
+        cBoxMaxDpi->setToolTip(QCoreApplication::translate("MainWindow", "<html><head/><body><p><span style=\" color:#0055ff;\">\345\233\276\347\211\207\345\234\250\351\241\265\351\235\242\344\270\212\347\232\204\345\210\206\350\276\250\347\216\207\344\270\212\351\231\220\343\200\202\351\200\211\346\213\251\345\216\237\345\247\213\345\210\206\350\276\250\347\216\207\344\273\245\345\244\226\347\232\204\351\200\211\351\241\271\346\227\266\357\274\214\351\225\277\350\276\271\350\266\205\350\277\207842\347\202\271\357\274\210A4\351\225\277\350\276\271\357\274\211\347\232\204\351\241\265\351\235\242\344\270\200\345\276\213\347\255\211\346\257\224\347\274\251\345\210\260A4\345\244\247\345\260\217\357\274\233\345\233\276\347\211\207\345\234\250\350\257\245\351\241\265\351\235\242\344\270\212\350\266\205\350\277\207\344\270\212\351\231\220\346\227\266\345\206\215\346\214\211\351\235\242\347\247\257\345\271\263\345\235\207\347\274\251\345\260\217\345\220\216\345\265\214\345\205\245\343\200\202</span></p></body></html>", nullptr));
+#endif // QT_CONFIG(tooltip)
+        checkBoxCombine->setText(QCoreApplication::translate("MainWindow", "\345\220\210\345\271\266\344\270\272\344\270\200\344\270\252PDF", nullptr));
         label_i2p_5->setText(QCoreApplication::translate("MainWindow", "PDF\350\275\254\345\233\276\347\211\207:", nullptr));
         lineEditPdfFile->setPlaceholderText(QCoreApplication::translate("MainWindow", "\345\217\257\344\273\245\346\213\226\345\212\250\346\226\207\344\273\266\345\210\260\350\257\245\346\226\207\346\234\254\346\241\206\344\270\255", nullptr));
         btnPdfToImage->setText(QCoreApplication::translate("MainWindow", "\350\275\254\346\215\242", nullptr));
@@ -874,7 +983,7 @@ public:
         lineEditSubPages->setPlaceholderText(QCoreApplication::translate("MainWindow", "\345\217\257\344\273\245\346\213\226\345\212\250\347\233\256\345\275\225\345\210\260\350\257\245\346\226\207\346\234\254\346\241\206\344\270\255", nullptr));
         labInput_6->setText(QCoreApplication::translate("MainWindow", "\351\241\265\344\277\235\345\255\230\344\270\200\344\270\252\346\226\207\346\241\243", nullptr));
         lineEditSplitscope->setText(QString());
-        lineEditSplitscope->setPlaceholderText(QCoreApplication::translate("MainWindow", "\347\244\272\344\276\213\357\274\232 1-7,4-12,10-20", nullptr));
+        lineEditSplitscope->setPlaceholderText(QCoreApplication::translate("MainWindow", "\347\244\272\344\276\213\357\274\232 1-7,9,12-,odd", nullptr));
 #if QT_CONFIG(tooltip)
         btnSplitPdf->setToolTip(QCoreApplication::translate("MainWindow", "<html><head/><body><p><span style=\" font-size:10pt; color:#0055ff;\">\345\260\206\345\242\236\345\212\240\350\277\207\346\260\264\345\215\260\347\232\204PDF\345\257\274\345\207\272\344\270\272\345\233\276\347\211\207PDF</span></p></body></html>", nullptr));
 #endif // QT_CONFIG(tooltip)